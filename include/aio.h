@@ -0,0 +1,72 @@
+#ifndef AIO_H
+#define AIO_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * 基于 io_uring 的异步读（直接使用系统调用，不依赖 liburing）。
+ * 每个环只由一个线程使用，不加锁。
+ */
+typedef struct AioRing {
+    int fd;                       // io_uring 实例，-1 表示未初始化
+    // 提交队列
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned sq_entries;
+    unsigned to_submit;           // 已准备但尚未提交给内核的请求数
+    // 完成队列
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    // mmap 区域
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+} AioRing;
+
+/**
+ * @brief 创建 io_uring 实例
+ *
+ * @param entries 队列深度
+ * @return 内核不支持或被禁止时返回 false，调用方应退回同步 I/O
+ */
+bool aio_ring_init(AioRing* ring, unsigned entries);
+
+/**
+ * @brief 销毁 io_uring 实例（调用方需保证没有未完成的请求）
+ */
+void aio_ring_destroy(AioRing* ring);
+
+/**
+ * @brief 准备一个读请求，暂不提交
+ *
+ * @param user_data 完成时原样返回，用于识别请求
+ * @return 提交队列已满时返回 false
+ */
+bool aio_prep_read(AioRing* ring, int fd, void* buf, unsigned len, off_t offset, uint64_t user_data);
+
+/**
+ * @brief 把已准备的请求提交给内核
+ *
+ * @return 提交的请求数，出错返回 -errno
+ */
+int aio_submit(AioRing* ring);
+
+/**
+ * @brief 等待并取出一个完成事件（先提交尚未提交的请求）
+ *
+ * @param user_data 完成请求的 user_data
+ * @param res 读到的字节数，出错时为 -errno
+ * @return 等待失败时返回 false
+ */
+bool aio_wait(AioRing* ring, uint64_t* user_data, int* res);
+
+#endif // AIO_H
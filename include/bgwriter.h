@@ -0,0 +1,22 @@
+#ifndef BGWRITER_H
+#define BGWRITER_H
+#include <stdbool.h>
+
+/**
+ * @brief 启动后台写进程（线程）
+ *
+ * 每隔 delay_ms 毫秒按页序写回最多 max_pages 个脏缓冲区，
+ * 前台 DML 只需把页面标记为脏。max_pages <= 0 时不启动。
+ *
+ * @param delay_ms 两轮之间的间隔（毫秒）
+ * @param max_pages 每轮最多写回的页数
+ * @return 是否已启动
+ */
+bool bgwriter_start(int delay_ms, int max_pages);
+
+/**
+ * @brief 通知后台写进程退出并等待其结束
+ */
+void bgwriter_stop();
+
+#endif // BGWRITER_H
@@ -0,0 +1,82 @@
+#ifndef BUF_TABLE_H
+#define BUF_TABLE_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "types.h"
+
+// 缓冲区标签：(表 OID, 页号) 唯一确定一个缓存页
+typedef struct BufferTag {
+    uint32_t rel_oid;   // 页面所属表的 OID
+    PageID page_id;     // 表内页号
+} BufferTag;
+
+#define INIT_BUFFER_TAG(tag, oid, pid) \
+    ((tag).rel_oid = (oid), (tag).page_id = (pid))
+#define BUFFER_TAGS_EQUAL(a, b) \
+    ((a)->rel_oid == (b)->rel_oid && (a)->page_id == (b)->page_id)
+
+/*
+ * 映射表按哈希值低位分成 NUM_BUFFER_PARTITIONS 个分区，每个分区一把锁。
+ * 桶数不少于分区数且都为 2 的幂，因此同一条桶链上的项必属于同一分区，
+ * 持有某分区的锁即可安全地查找/修改该分区的所有桶链。
+ */
+#define NUM_BUFFER_PARTITIONS 128
+#define BufTableHashPartition(hashcode) ((hashcode) % NUM_BUFFER_PARTITIONS)
+
+// 映射项：下标与缓存项下标 (buf_id) 一一对应，每个缓存项最多映射一次
+typedef struct BufTableEntry {
+    BufferTag tag;
+    int next;           // 同一桶中的下一项，-1 表示链尾
+    bool used;          // 该项当前是否挂在某个桶中
+} BufTableEntry;
+
+// 缓冲区映射哈希表 (类似 pg 的 buf_table.c)
+typedef struct BufTable {
+    int* buckets;            // 桶数组，存放链表头 (entries 下标)，-1 表示空桶
+    uint32_t bucket_mask;    // 桶数 - 1，桶数为 2 的幂
+    BufTableEntry* entries;  // 映射项数组，共 nbuffers 项
+    int nbuffers;
+} BufTable;
+
+/**
+ * @brief 初始化映射表，桶数取不小于 2*nbuffers（且不少于分区数）的 2 的幂
+ *
+ * @param table 映射表
+ * @param nbuffers 缓存页数量
+ * @return 是否成功
+ */
+bool buf_table_init(BufTable* table, int nbuffers);
+
+/**
+ * @brief 释放映射表占用的内存
+ */
+void buf_table_destroy(BufTable* table);
+
+/**
+ * @brief 计算缓冲区标签的哈希值
+ */
+uint32_t buf_table_hash_code(const BufferTag* tag);
+
+/**
+ * @brief 按标签查找缓存项
+ *
+ * @param hashcode buf_table_hash_code(tag) 的结果
+ * @return buf_id，未找到返回 -1
+ */
+int buf_table_lookup(const BufTable* table, const BufferTag* tag, uint32_t hashcode);
+
+/**
+ * @brief 插入 tag -> buf_id 映射
+ *
+ * @return 若标签已存在返回已有的 buf_id（不插入），否则返回 -1
+ */
+int buf_table_insert(BufTable* table, const BufferTag* tag, uint32_t hashcode, int buf_id);
+
+/**
+ * @brief 删除 tag 对应的映射
+ *
+ * @return 是否找到并删除
+ */
+bool buf_table_delete(BufTable* table, const BufferTag* tag, uint32_t hashcode);
+
+#endif // BUF_TABLE_H
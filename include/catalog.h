@@ -3,10 +3,7 @@
 
 #include <stdint.h>
 
-#define MAX_NAME_LEN 64
-#define MAX_COLS 32
-#define MAX_TABLES 128
-
+// MAX_NAME_LEN、MAX_COLS、MAX_TABLES 统一在 types.h 中定义
 #include "minidb.h"
 #include "tuple.h"
 // 数据库目录（表目录）
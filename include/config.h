@@ -0,0 +1,83 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+#include <stdint.h>
+#include <stdbool.h>
+
+// 配置文件名，位于数据目录下
+#define CONFIG_FILE "minidb.conf"
+
+#define DEFAULT_SHARED_BUFFERS 128  // 默认缓冲池页数
+#define MIN_SHARED_BUFFERS 16
+#define DEFAULT_BGWRITER_DELAY 200        // 后台写进程每轮间隔（毫秒）
+#define DEFAULT_BGWRITER_LRU_MAXPAGES 100 // 后台写进程每轮最多写回页数
+#define DEFAULT_MAX_FILES_PER_PROCESS 64  // 存储管理层最多同时打开的数据文件数
+#define DEFAULT_EFFECTIVE_IO_CONCURRENCY 16 // 顺序扫描最多同时发起的读请求数
+#define DEFAULT_AUTOPREWARM_INTERVAL 300000  // 缓冲池内容转储间隔（毫秒）
+#define DEFAULT_AUTOVACUUM_MAX_WORKERS 3        // 自动清理线程数
+#define DEFAULT_AUTOVACUUM_NAPTIME 60000        // 自动清理线程每轮间隔（毫秒）
+#define DEFAULT_AUTOVACUUM_VACUUM_THRESHOLD 50  // 死元组数超过 阈值 + 比例 * 存活元组数 时清理
+#define DEFAULT_AUTOVACUUM_VACUUM_SCALE_FACTOR 0.2
+#define DEFAULT_AUTOVACUUM_VACUUM_COST_DELAY 2  // 自动清理的代价休眠（毫秒）
+#define DEFAULT_VACUUM_COST_LIMIT 200           // 代价累计到该值时休眠
+
+// 缓冲池是否使用大页
+typedef enum {
+    HUGE_PAGES_OFF,   // 不使用大页
+    HUGE_PAGES_TRY,   // 优先 MAP_HUGETLB，失败则退回普通页并建议透明大页
+    HUGE_PAGES_ON     // 必须使用 MAP_HUGETLB，失败则启动失败
+} HugePagesMode;
+
+// 数据页读 I/O 方式
+typedef enum {
+    IO_METHOD_SYNC,      // pread 同步读
+    IO_METHOD_IO_URING   // io_uring 异步读，内核不支持时自动退回同步
+} IOMethod;
+
+// 数据库运行参数（类似 postgresql.conf）
+typedef struct MiniDBConfig {
+    int shared_buffers;        // 缓冲池页数
+    HugePagesMode huge_pages;  // 缓冲池大页模式
+    int bgwriter_delay;        // 后台写进程每轮间隔（毫秒）
+    int bgwriter_lru_maxpages; // 后台写进程每轮最多写回页数，0 表示关闭
+    int max_files_per_process; // 最多同时打开的数据文件数
+    bool direct_io;            // 数据文件以 O_DIRECT 读写，绕过内核页缓存
+    IOMethod io_method;        // 数据页读 I/O 方式
+    int effective_io_concurrency; // 顺序扫描预读页数，0 表示不预读
+    bool mmap_scans;           // db_query 写回表的脏页后通过只读内存映射扫描表文件，开启时 VACUUM 不截断表
+    bool autoprewarm;          // 定期转储缓冲池内容，启动时按转储预热
+    int autoprewarm_interval;  // 转储间隔（毫秒），0 表示只在关闭时转储
+    bool autovacuum;           // 是否启动自动清理线程
+    int autovacuum_max_workers;   // 自动清理线程数
+    int autovacuum_naptime;       // 自动清理线程每轮间隔（毫秒）
+    int autovacuum_vacuum_threshold;       // 触发清理的死元组数基数
+    double autovacuum_vacuum_scale_factor; // 触发清理的死元组数按存活元组数增加的比例
+    int autovacuum_vacuum_cost_delay;      // 自动清理的代价休眠（毫秒），0 表示不限速
+    int autovacuum_vacuum_cost_limit;      // 自动清理的代价上限
+    int vacuum_cost_delay;     // VACUUM 命令的代价休眠（毫秒），0 表示不限速
+    int vacuum_cost_limit;     // VACUUM 命令的代价上限
+} MiniDBConfig;
+
+extern MiniDBConfig db_config;
+
+/**
+ * @brief 把配置设置为默认值
+ */
+void config_set_defaults(MiniDBConfig* config);
+
+/**
+ * @brief 从配置文件加载参数，格式为每行 "name = value"，# 开头为注释
+ *
+ * @param config 待填充的配置（未出现的参数保持原值）
+ * @param path 配置文件路径
+ * @return 文件不存在返回 false，其余情况返回 true（无法识别的行会打印警告）
+ */
+bool config_load_file(MiniDBConfig* config, const char* path);
+
+/**
+ * @brief 设置单个参数
+ *
+ * @return 参数名或取值无效时返回 false
+ */
+bool config_set_option(MiniDBConfig* config, const char* name, const char* value);
+
+#endif // CONFIG_H
@@ -0,0 +1,50 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+#include <stdint.h>
+#include <stdbool.h>
+
+// 控制文件名，位于数据目录下（类似 pg 的 global/pg_control）
+#define CONTROL_FILE "minidb.control"
+
+#define CONTROL_MAGIC 0x4D444243    // "MDBC"
+/*
+ * 页面格式版本，磁盘布局变化时递增：
+ *   2: 元组头增加 ctid 和 infomask，.meta 末尾增加 fillfactor
+ *   3: 页头增加 prune_xid
+ */
+#define CONTROL_VERSION 3
+
+/*
+ * 控制文件：建库时写入，记录与数据文件格式相关、建库后不能再改的参数。
+ * 页大小在构建时选定 (cmake -DMINIDB_BLOCK_SIZE=...)，每次启动检查
+ * 数据目录的页大小与本构建一致，不一致时拒绝打开。
+ */
+typedef struct ControlFileData {
+    uint32_t magic;
+    uint32_t version;     // 建库时的 CONTROL_VERSION
+    uint32_t blcksz;      // 建库时的页大小（字节）
+    uint32_t crc;         // 以上字段的 CRC32
+} ControlFileData;
+
+/**
+ * @brief 读取控制文件
+ *
+ * @param data_dir 数据目录
+ * @param control 读到的内容
+ * @return 文件不存在（errno 为 ENOENT）、长度不对或校验失败时返回 false
+ */
+bool control_file_read(const char* data_dir, ControlFileData* control);
+
+/**
+ * @brief 按本构建的参数写入控制文件（先写临时文件再改名）
+ */
+bool control_file_write(const char* data_dir);
+
+/**
+ * @brief 启动时调用：新数据目录写入控制文件，已有的检查版本和页大小与本构建一致
+ *
+ * @return 不一致或控制文件损坏时打印原因并返回 false
+ */
+bool control_file_startup(const char* data_dir);
+
+#endif // CONTROL_H
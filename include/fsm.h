@@ -0,0 +1,73 @@
+#ifndef FSM_H
+#define FSM_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "types.h"
+#include "lock.h"
+
+#define TRANCHE_FSM_LOCK 4
+#define FSM_FILE_SUFFIX ".fsm"       // 空闲空间映射文件 = 表文件名 + 后缀
+#define FSM_CATEGORIES 256           // 空闲空间按 PAGE_SIZE/256 字节一档记为 1 字节
+#define FSM_CAT_STEP (PAGE_SIZE / FSM_CATEGORIES)
+#define FSM_MIN_LEAVES 64
+
+/*
+ * 空闲空间映射 (类似 pg 的 freespace.c)：每个数据页的空闲空间记为 1 字节的档位，
+ * 组织成一棵最大值树（数组表示，tree[1] 为根，叶子 tree[nleaves + page_id]），
+ * 按所需空间找页、更新某页档位都是 O(log n)。
+ * 映射只是提示，插入时仍以页面实际空闲空间为准，发现不符再更新映射。
+ * 映射持久化在表文件旁的 .fsm 文件中，检查点时写回；文件缺失或比表短时
+ * 按表文件重建缺失部分。
+ */
+typedef struct FreeSpaceMap {
+    uint32_t rel_oid;
+    char path[256];       // .fsm 文件路径
+    int nleaves;          // 叶子数，2 的幂
+    uint8_t* tree;        // 2 * nleaves 项
+    PageID nblocks;       // 已记录的页数
+    bool dirty;           // 自上次写回后是否修改过
+    LWLock lock;
+} FreeSpaceMap;
+
+/**
+ * @brief 取表的空闲空间映射，首次访问时从 .fsm 文件加载（表需已在存储管理层登记）
+ *
+ * @param table_path 表数据文件路径
+ * @return 内存不足或登记已满时返回 NULL
+ */
+FreeSpaceMap* fsm_open(uint32_t rel_oid, const char* table_path);
+
+/**
+ * @brief 找一个空闲空间不少于 needed 字节的页
+ *
+ * @return 页号，没有时返回 INVALID_PAGE_ID
+ */
+PageID GetPageWithFreeSpace(FreeSpaceMap* fsm, size_t needed);
+
+/**
+ * @brief 记录某页当前的空闲空间
+ */
+void RecordPageWithFreeSpace(FreeSpaceMap* fsm, PageID page_id, size_t free_space);
+
+/**
+ * @brief 记录 old_page 的空闲空间并另找一页（插入时发现映射过时调用）
+ */
+PageID RecordAndGetPageWithFreeSpace(FreeSpaceMap* fsm, PageID old_page, size_t old_free, size_t needed);
+
+/**
+ * @brief 表被截断为 nblocks 页后，去掉映射中截掉的页
+ */
+void FreeSpaceMapTruncateRel(FreeSpaceMap* fsm, PageID nblocks);
+
+/**
+ * @brief 把所有修改过的映射写回 .fsm 文件（检查点时调用）
+ */
+void fsm_sync_all();
+
+/**
+ * @brief 释放所有映射（不写回）
+ */
+void fsm_shutdown();
+
+#endif // FSM_H
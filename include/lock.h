@@ -9,11 +9,15 @@ typedef struct {
     LWLock bucket_locks[ROW_LOCK_BUCKETS];  // 每个桶独立锁
 } RowLockTable;
 
-RowLockTable global_row_locks;
+extern RowLockTable global_row_locks;
 
 void LWLockInit(LWLock *lock, uint16_t tranche_id);
 bool LWLockAcquireExclusive(LWLock *lock) ;
+bool LWLockAcquireShared(LWLock *lock);
+bool LWLockAcquire(LWLock *lock, LWLockMode mode);
 void LWLockRelease(LWLock *lock) ;
+// 正在等待排他锁的线程数（类似 pg 的 RelationExtensionLockWaiterCount）
+int LWLockWaiterCount(LWLock *lock);
 
 
 void init_row_lock_table();
@@ -0,0 +1,59 @@
+#ifndef MEMCTX_H
+#define MEMCTX_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 内存上下文 (类似 pg 的 MemoryContext/AllocSet)：
+ * 上下文从成块申请的内存中顺序切分，pfree 不回收单个分配，
+ * 重置或删除上下文时一次性释放其中所有分配以及所有子上下文。
+ *
+ * palloc 从当前线程的 CurrentMemoryContext 分配。CurrentMemoryContext 为 NULL
+ * (后台线程、未设置上下文的调用方) 时直接用 malloc，此时 pfree 等同于 free，
+ * 所以元组等对象无论在哪种方式下分配，都可以统一用 pfree 释放。
+ *
+ * 一个上下文只能由一个线程使用。
+ */
+typedef struct MemoryContextData* MemoryContext;
+
+extern _Thread_local MemoryContext CurrentMemoryContext;
+
+/**
+ * @brief 创建上下文，parent 不为 NULL 时随父上下文一起重置和删除
+ *
+ * @param name 用于调试输出，需为常量字符串
+ * @return 新上下文，内存不足返回 NULL
+ */
+MemoryContext MemoryContextCreate(MemoryContext parent, const char* name);
+
+/**
+ * @brief 释放上下文中的所有分配并删除其子上下文，上下文本身可继续使用
+ *
+ * 只保留与上下文一起分配的第一块，代价与分配次数无关。
+ */
+void MemoryContextReset(MemoryContext context);
+
+/**
+ * @brief 删除上下文及其子上下文；若它是当前上下文，当前上下文切换为其父上下文
+ */
+void MemoryContextDelete(MemoryContext context);
+
+static inline MemoryContext MemoryContextSwitchTo(MemoryContext context) {
+    MemoryContext old = CurrentMemoryContext;
+    CurrentMemoryContext = context;
+    return old;
+}
+
+// 从指定上下文分配，context 为 NULL 时用 malloc；内存不足返回 NULL
+void* MemoryContextAlloc(MemoryContext context, size_t size);
+
+void* palloc(size_t size);
+void* palloc0(size_t size);
+char* pstrdup(const char* str);
+// 释放 palloc 的内存：malloc 得到的立即释放，上下文中的等上下文重置时回收
+void pfree(void* ptr);
+
+// 上下文中已申请的字节数（含子上下文），用于统计和调试
+size_t MemoryContextMemAllocated(MemoryContext context);
+
+#endif // MEMCTX_H
@@ -14,6 +14,7 @@
 #include "txmgr.h"
 #include "page.h"
 #include "types.h"
+#include "config.h"
 #include "parser.h"'
 
 // 数据库常量
@@ -21,7 +22,6 @@
 #define HEADER_SIZE 24
 
 //#define MAX_COLS 8
-#define MAX_NAME_LEN 32
 #define MAX_STRING_LEN 256
 #define SYSTEM_CATALOG "pg_class.dat"
 #define MAX_RESULTS 1000
@@ -52,6 +52,7 @@ typedef struct {
 
 // 数据库操作函数
 void init_db(MiniDB *db, const char *data_dir);
+void init_db_with_config(MiniDB *db, const char *data_dir, const MiniDBConfig *config);
 
 uint32_t begin_transaction(MiniDB *db);
 int commit_transaction(MiniDB *db);
@@ -65,12 +66,53 @@ int db_create_table(MiniDB *db, const char *table_name, ColumnDef *columns, uint
 
 //int db_insert(MiniDB *db, const char *table_name, Tuple *tuple);
 bool db_insert(MiniDB *db, const char *table_name,   const Tuple * values,Session session);
+// 批量插入 count 行，只在一个 BAS_BULKWRITE 环中使用缓冲区，返回成功插入的行数
+int db_insert_batch(MiniDB *db, const char *table_name, const Tuple *values, int count, Session session);
+// 把元组放入表中（不分配行 OID），位置写入 tid（可为 NULL）；大的 TEXT 列先压缩或移到 .toast 文件
+bool db_heap_insert(MiniDB *db, TableMeta *meta, Tuple *tuple, BufferAccessStrategy strategy,
+                    ItemPointer *tid);
+// 取出 tid 处元组的副本，槽位无效时返回 NULL
+Tuple* db_heap_fetch(MiniDB *db, TableMeta *meta, ItemPointer tid);
+// 扫描表找出 OID 为 oid 的行的最新版本（xmax 未提交），位置写入 tid；
+// 记下的版本已被剪枝回收时用来重新定位该行
+Tuple* db_heap_fetch_latest(MiniDB *db, TableMeta *meta, uint32_t oid, ItemPointer *tid);
+
+// db_heap_update 的结果 (类似 pg 的 TM_Result)
+typedef enum {
+    HEAP_UPDATE_OK,             // 已更新
+    HEAP_UPDATE_SELF,           // 本事务已更新或删除过这一版本
+    HEAP_UPDATE_UPDATED,        // 已被其他已提交事务更新，otid 改为新版本位置
+    HEAP_UPDATE_DELETED,        // 已被其他已提交事务删除
+    HEAP_UPDATE_BEING_UPDATED,  // 其他进行中的事务正在更新这一版本
+    HEAP_UPDATE_PRUNED,         // 版本已被剪枝回收，槽位为空或已被其他行重用
+    HEAP_UPDATE_FAILED          // 放不下新版本
+} HeapUpdateResult;
+
+// 用 newtup 替换 otid 处的版本：本页放得下时做 HOT 更新，否则放到其他页。
+// newtup->oid 须为要更新的行的 OID，用来核对 otid 处是否仍是该行
+HeapUpdateResult db_heap_update(MiniDB *db, TableMeta *meta, ItemPointer *otid, Tuple *newtup,
+                                Session session);
+// 设置表的 fillfactor (10..100)，只影响之后的插入
+bool db_set_fillfactor(MiniDB *db, const char *table_name, int fillfactor);
 //bool db_update(MiniDB* db, const UpdateStmt* stmt, Session session);
 //bool db_update(MiniDB *db, const char *table_name,const UpdateStmt* stmt, int *result_count, Session session);
 
 //int db_query(MiniDB *db, const char *table_name, Tuple *results, int max_results);
 Tuple** db_query(MiniDB *db, const char *table_name, int *result_count,Session session);
+struct Condition;  // 见 server/parser.h，与本文件互相包含
+/**
+ * @brief 同 db_query，只返回满足 qual 的行，每行只解析 needed 中的列
+ *
+ * qual 在缓冲区页面上直接判断，不满足的行不复制。返回的元组只解析到最后一个需要的列
+ * (col_count 为已解析的列数)，其中不需要的 TEXT 列 str_val 为 NULL。
+ *
+ * @param needed 按列下标，NULL 表示全部
+ * @param qual WHERE 条件，NULL 表示不过滤
+ */
+Tuple** db_query_attrs(MiniDB *db, const char *table_name, int *result_count, Session session,
+                       const bool *needed, const struct Condition *qual);
 void db_create_checkpoint(MiniDB *db);
+void close_db(MiniDB *db);
 void print_db_status(const MiniDB *db);
 
 #endif // MINIDB_H
\ No newline at end of file
@@ -3,48 +3,331 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "types.h"
+#include "buf_table.h"
+#include "config.h"
+#include "smgr.h"
 
 #define PAGE_DATA_OFFSET offsetof(Page, data)
 #define TRANCHE_PAGE_LOCK 1
 #define TRANCHE_ROW_LOCK  2
 
-#define PAGE_CACHE_SIZE 128  // 缓存页数上限，可按需调整
+#define BM_MAX_USAGE_COUNT 5 // clock-sweep 使用计数上限
+#define MAX_PREFETCH_DISTANCE 64 // 顺序扫描一次最多预读的页数
 
-typedef struct PageCacheEntry {
-    uint32_t oid;            // 页面所在行的 OID（或对应的唯一页标识符）=page_id
-    Page page;              // 缓存的页面内容
+// LockBuffer 的模式
+#define BUFFER_LOCK_UNLOCK    0
+#define BUFFER_LOCK_SHARE     1
+#define BUFFER_LOCK_EXCLUSIVE 2
+
+// 缓冲区编号：1..nbuffers，0 表示无效 (与 pg 的 Buffer 一致)
+typedef int Buffer;
+#define InvalidBuffer 0
+#define BufferIsValid(buf) ((buf) != InvalidBuffer)
+
+/*
+ * 缓冲区描述符：缓存页的元数据，与页面内容分开存放。
+ * tag/dirty/valid/usage_count 由描述符头自旋锁 hdr_lock 保护；
+ * pin (refcount 增加) 也在 hdr_lock 下进行，unpin 直接原子减。
+ */
+typedef struct BufferDesc {
+    BufferTag tag;          // 缓存页标签 (表 OID + 页号)
+    int buf_id;             // 在描述符数组中的下标
+    atomic_uint refcount;   // pin 计数，>0 时不会被淘汰
+    atomic_flag hdr_lock;   // 描述符头自旋锁
     bool dirty;             // 是否被修改过，需写回磁盘
-    bool valid;             // 是否为有效缓存
-} PageCacheEntry;
+    bool valid;             // 页面内容是否已装入
+    uint8_t usage_count;    // clock-sweep 使用计数，命中 +1，扫过 -1
+    int free_next;          // 空闲链表中的下一项，-1 表示链尾，-2 表示不在链表中
+    LWLock io_lock;         // 装入/写回期间持有，串行化同一缓冲区的 I/O
+    LWLock content_lock;    // 页面内容锁，读页面持共享锁，修改页面持排他锁
+} BufferDesc;
+
+// 页缓存统计快照，用于计算命中率
+typedef struct PageCacheStats {
+    uint64_t hits;              // 命中次数
+    uint64_t misses;            // 未命中（从磁盘读入）次数
+    uint64_t evictions;         // 淘汰有效页的次数
+    uint64_t dirty_writebacks;  // 淘汰前写回脏页的次数
+    uint64_t buffers_written;   // 后台写进程/检查点/映射扫描前写回的页数
+} PageCacheStats;
+
+// 页缓存内部计数器，各线程无锁累加
+typedef struct PageCacheCounters {
+    atomic_ullong hits;
+    atomic_ullong misses;
+    atomic_ullong evictions;
+    atomic_ullong dirty_writebacks;
+    atomic_ullong buffers_written;
+} PageCacheCounters;
 
 typedef struct PageCache {
-    PageCacheEntry entries[PAGE_CACHE_SIZE];
-    LWLock lock;    // 多线程访问保护
+    BufferDesc* descriptors;  // 缓冲区描述符数组
+    Page* pages;              // 页面数组，下标与描述符对应
+    int nbuffers;             // 缓冲池页数 (shared_buffers)
+    void* region;             // 页面与描述符所在的连续内存区
+    size_t region_size;
+    bool huge_pages;          // region 是否由 MAP_HUGETLB 大页支撑
+    BufTable mapping;       // (表 OID, 页号) -> 缓冲区下标 的哈希映射
+    LWLockPadded partition_locks[NUM_BUFFER_PARTITIONS];  // 映射表分区锁，查找用共享模式
+    LWLock strategy_lock;   // 保护空闲链表
+    int first_free;         // 空闲缓存项链表头，-1 表示没有空闲项
+    atomic_uint next_victim; // clock-sweep 指针，原子递增
+    PageCacheCounters stats;
 } PageCache;
 
-PageCache global_page_cache;
+extern PageCache global_page_cache;
+
+/*
+ * 缓冲区访问策略（类似 pg 的 BufferAccessStrategy）：大表扫描、批量写入
+ * 只在一个私有的小环中循环使用缓冲区，不把共享缓冲池中的热点页挤出去。
+ */
+typedef enum {
+    BAS_BULKREAD,   // 大表顺序扫描，环大小 256kB
+    BAS_BULKWRITE,  // 批量写入，环大小 16MB
+    BAS_VACUUM      // 清理，环大小 256kB
+} BufferAccessStrategyType;
+
+typedef struct BufferAccessStrategyData {
+    BufferAccessStrategyType type;
+    int nbuffers;       // 环大小
+    int current;        // 上一次使用的环位置
+    Buffer buffers[];   // 环中的缓冲区，InvalidBuffer 表示空位
+} BufferAccessStrategyData;
+
+typedef BufferAccessStrategyData* BufferAccessStrategy;
+
+// ReadBufferExtended 的模式
+typedef enum {
+    RBM_NORMAL,     // 从磁盘读入
+    RBM_ZERO        // 表扩展出的新页，直接初始化为空页（已在缓冲池中时也重新初始化）
+} ReadBufferMode;
+
 
 
+// 空页（page_init 之后）的空闲空间
+#define PAGE_EMPTY_FREE_SPACE PAGE_DATA_SIZE
+
+// 页上出现了 xid 删除/更新的版本（或已删除的槽位），记下最老的一个供剪枝判断
+#define PageSetPrunable(page, xid) \
+    do { \
+        if ((page)->header.prune_xid == 0 || (xid) < (page)->header.prune_xid) \
+            (page)->header.prune_xid = (xid); \
+    } while (0)
 
 void page_init(Page* page, PageID page_id);
+// 页面是否尚未初始化（预分配后从未写入过，内容全为 0）
+bool page_is_new(const Page* page);
 size_t page_free_space(const Page* page);
+// 把仍占用的元组紧凑地移到页尾，回收空闲槽位和已删除元组占用的数据空间（槽位号不变）
+void page_compact(Page* page);
 
 bool page_insert_tuple(Page* page, const  Tuple* tuple, uint16_t* slot_out);
+// 放入已序列化的元组（如 heap_toast_serialize 的结果）
+bool page_insert_tuple_data(Page* page, const uint8_t* data, size_t tuple_size, uint16_t* slot_out);
 bool page_delete_tuple(Page* page, uint16_t slot);
 Tuple* page_get_tuple(const Page* page, uint16_t slot, const  TableMeta* meta);
+// 取元组，只解析 needed 中的列（见 deserialize_tuple_attrs），needed 为 NULL 表示全部
+Tuple* page_get_tuple_attrs(const Page* page, uint16_t slot, const TableMeta* meta,
+                            const bool* needed);
+// 在槽位的元组上建立只读视图（见 TupleView），不分配内存；槽位未占用时返回 false
+bool page_get_tuple_view(const Page* page, uint16_t slot, const TableMeta* meta, TupleView* view);
 bool page_update_tuple(Page* page, uint16_t slot, const  Tuple* new_tuple);
+// 原地覆盖元组头中的 xmax、ctid、infomask
+bool page_update_tuple_header(Page* page, uint16_t slot, const Tuple* tuple);
 uint16_t page_find_slot_by_oid(const Page* page, uint32_t oid);
 void page_print_info(const Page* page);
 
 //int read_page(const char *table_path, PageID page_id, Page *page);
-Page* read_page(const char* table_path, PageID page_id);
+Page* read_page(uint32_t rel_oid, PageID page_id);
 void free_page(Page* page) ;
 
 
 //cache
-void init_page_cache();
-Page* page_cache_load_or_fetch(uint32_t oid, const char* filename) ;
-Page* page_cache_get(uint32_t oid, TableMeta* meta, FILE* table_file) ;
-bool page_cache_flush(uint32_t oid, const char* filename);
-void page_cache_mark_dirty(uint32_t oid);
+/**
+ * @brief 分配并初始化缓冲池
+ *
+ * 页面数组和描述符数组放在同一块按页对齐的 mmap 区域中；
+ * huge_pages 为 on/try 时尝试 MAP_HUGETLB，try 失败时退回普通页并启用透明大页。
+ *
+ * @param nbuffers 缓冲池页数
+ * @param huge_pages 大页模式
+ * @return 是否成功
+ */
+bool init_page_cache(int nbuffers, HugePagesMode huge_pages);
+
+/**
+ * @brief 释放缓冲池内存（不写回脏页）
+ */
+void destroy_page_cache();
+
+/**
+ * @brief 读取表中的页面并 pin 住所在缓冲区
+ *
+ * @param rel_oid 表 OID
+ * @param page_id 页号
+ * @param filename 表数据文件路径，首次访问时登记到存储管理层；NULL 表示表已登记
+ * @return 已 pin 的缓冲区，页面不存在或缓存无可用项时返回 InvalidBuffer
+ */
+Buffer ReadBuffer(uint32_t rel_oid, PageID page_id, const char* filename);
+
+/**
+ * @brief 为表扩展出的新页面分配并 pin 一个缓冲区（标记为脏，尚未写盘）
+ */
+Buffer ReadBufferNew(uint32_t rel_oid, PageID page_id, const char* filename);
+
+/**
+ * @brief 页面已在缓冲池中时 pin 住并返回其缓冲区，否则返回 InvalidBuffer（不读盘）
+ */
+Buffer ReadBufferIfCached(uint32_t rel_oid, PageID page_id);
+
+/**
+ * @brief 按指定模式和访问策略读取页面
+ *
+ * @param strategy 访问策略，NULL 表示使用共享缓冲池的正常替换
+ */
+Buffer ReadBufferExtended(uint32_t rel_oid, PageID page_id, const char* filename,
+                          ReadBufferMode mode, BufferAccessStrategy strategy);
+
+/**
+ * @brief 创建访问策略，环大小不超过缓冲池的 1/8
+ */
+BufferAccessStrategy GetAccessStrategy(BufferAccessStrategyType type);
+
+/**
+ * @brief 大于缓冲池 1/4 的表扫描返回 BAS_BULKREAD 策略，否则返回 NULL
+ *
+ * @param nblocks 待扫描的页数
+ */
+BufferAccessStrategy GetScanAccessStrategy(uint32_t nblocks);
+
+/**
+ * @brief 释放访问策略（环中的缓冲区留在缓冲池中），strategy 可为 NULL
+ */
+void FreeAccessStrategy(BufferAccessStrategy strategy);
+
+/**
+ * @brief 释放 ReadBuffer/ReadBufferNew 得到的 pin
+ */
+void ReleaseBuffer(Buffer buffer);
+
+/**
+ * @brief 获取缓冲区中的页面，调用方必须持有该缓冲区的 pin
+ */
+Page* BufferGetPage(Buffer buffer);
+
+/**
+ * @brief 加/解页面内容锁，调用方必须持有该缓冲区的 pin
+ *
+ * @param mode BUFFER_LOCK_SHARE / BUFFER_LOCK_EXCLUSIVE / BUFFER_LOCK_UNLOCK
+ */
+void LockBuffer(Buffer buffer, int mode);
+
+/**
+ * @brief 把已 pin 的缓冲区标记为脏
+ */
+void MarkBufferDirty(Buffer buffer);
+
+/**
+ * @brief 若缓冲区为脏则立即写回磁盘，调用方需持有 pin 且不能持有排他内容锁
+ */
+bool FlushBuffer(Buffer buffer);
+
+/**
+ * @brief 按 (表 OID, 页号) 顺序写回脏缓冲区，供后台写进程周期调用
+ *
+ * 写回时只在页锁下拷贝页面，磁盘 I/O 不持有全局锁。
+ *
+ * @param max_pages 本轮最多写回的页数，<= 0 表示不限
+ * @return 实际写回的页数
+ */
+int BgBufferSync(int max_pages);
+
+/**
+ * @brief 写回所有脏缓冲区（检查点、关闭数据库时调用）
+ *
+ * @return 是否全部写回成功
+ */
+bool FlushAllBuffers();
+
+/**
+ * @brief 写回一个表的所有脏缓冲区（映射扫描前调用）
+ *
+ * @return 是否全部写回成功
+ */
+bool FlushRelationBuffers(uint32_t rel_oid);
+
+/**
+ * @brief 丢弃表中页号不小于 first_page 的缓存页，脏页不写回（截断表文件前调用）
+ *
+ * 仍被 pin 住的缓冲区只清除脏标记，留在缓冲池中等正常淘汰，调用方需保证
+ * 之后没有人再修改这些页。
+ */
+void DropRelationBuffers(uint32_t rel_oid, PageID first_page);
+
+/*
+ * 顺序扫描的读流：按批发起后续页面的读请求（io_uring 下同批请求并发执行），
+ * 批内自己装入的页面全部完成后才把缓冲区交给调用方，因此调用方处理页面期间
+ * 不持有任何 io_lock。预读距离遇到未命中时翻倍，命中时减一。
+ */
+typedef struct ReadStreamEntry {
+    Buffer buffer;
+    PageID page_id;
+    bool wait;          // 命中了其他线程正在装入的缓冲区，取出时需等待
+} ReadStreamEntry;
+
+typedef struct ReadStream {
+    uint32_t rel_oid;
+    const char* filename;
+    PageID next_page;   // 下一个待发起的页号
+    PageID end_page;    // 扫描的最后一页（含）
+    int distance;       // 当前预读距离
+    int max_distance;
+    BufferAccessStrategy strategy; // 可为 NULL
+    int head;           // 下一个交给调用方的项
+    int count;          // 队列中的项数
+    ReadStreamEntry entries[MAX_PREFETCH_DISTANCE];
+} ReadStream;
+
+/**
+ * @brief 开始顺序读取 [first_page, last_page]
+ *
+ * @param max_distance 最大预读页数（effective_io_concurrency），会按缓冲池大小截断
+ * @param strategy 访问策略，可为 NULL；预读距离不超过环大小的一半
+ */
+void read_stream_begin(ReadStream* stream, uint32_t rel_oid, const char* filename,
+                       PageID first_page, PageID last_page, int max_distance,
+                       BufferAccessStrategy strategy);
+
+/**
+ * @brief 取下一页的缓冲区（已 pin，用完后调用 ReleaseBuffer）
+ *
+ * 缓冲池暂无可用缓冲区时等待其他线程释放；等待超过上限（约 1 秒）仍没有
+ * 可用缓冲区时按读取失败处理，避免与持有 pin 的线程互相等待。
+ *
+ * @param buffer 输出缓冲区，页面不存在、读取失败或等不到缓冲区时为 InvalidBuffer
+ * @param page_id 输出页号，可为 NULL
+ * @return 扫描结束返回 false
+ */
+bool read_stream_next(ReadStream* stream, Buffer* buffer, PageID* page_id);
+
+/**
+ * @brief 结束扫描，释放尚未取出的缓冲区
+ */
+void read_stream_end(ReadStream* stream);
+
+/**
+ * @brief 取缓冲池中所有有效页的标签
+ *
+ * @return 写入 tags 的个数
+ */
+int page_cache_get_resident_tags(BufferTag* tags, int max_tags);
+
+/**
+ * @brief 空闲链表是否还有缓冲区（预热时用于避免淘汰已有页面）
+ */
+bool page_cache_have_free_buffer();
+
+void page_cache_get_stats(PageCacheStats* out);
+double page_cache_hit_ratio();
+void page_cache_print_stats();
 #endif // PAGE_H
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef PREWARM_H
+#define PREWARM_H
+#include <stdbool.h>
+
+// 缓冲池内容转储文件名，位于数据目录下
+#define AUTOPREWARM_FILE "autoprewarm.blocks"
+
+/*
+ * 缓冲池预热 (类似 pg_prewarm 的 autoprewarm)：
+ * 后台线程定期把缓冲池中有效页的 (页号, 表文件名) 写入转储文件；
+ * 表 OID 每次启动重新分配，所以记文件名（相对数据目录），装入时按存储管理层的登记换回 OID。
+ * 启动时先按 (表, 页号) 顺序把上次转储的页面读回缓冲池，
+ * 缓冲池没有空闲项时停止，不会为预热淘汰已有页面。
+ * 转储和装入时表都需已在存储管理层登记，未登记的表跳过。
+ */
+
+/**
+ * @brief 启动预热线程：先装入上次的转储，之后每隔 interval_ms 毫秒转储一次
+ *
+ * @param data_dir 数据目录
+ * @param interval_ms 转储间隔（毫秒），0 表示只在 autoprewarm_stop 时转储
+ * @return 是否已启动
+ */
+bool autoprewarm_start(const char* data_dir, int interval_ms);
+
+/**
+ * @brief 停止预热线程，退出前转储一次
+ */
+void autoprewarm_stop();
+
+/**
+ * @brief 立即把缓冲池中的页面标签写入转储文件
+ *
+ * @return 写入的页数，失败返回 -1
+ */
+int autoprewarm_dump(const char* data_dir);
+
+/**
+ * @brief 按转储文件把页面读回缓冲池
+ *
+ * @return 读入的页数，文件不存在返回 0
+ */
+int autoprewarm_load(const char* data_dir);
+
+#endif // PREWARM_H
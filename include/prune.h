@@ -0,0 +1,49 @@
+#ifndef PRUNE_H
+#define PRUNE_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "types.h"
+
+// 取页插入/更新时，页面空闲空间低于该值才尝试剪枝（类似 pg 的 BLCKSZ/10）
+#define PRUNE_MIN_FREE_SPACE (PAGE_DATA_SIZE / 10)
+
+/*
+ * 页内剪枝 (类似 pg 的 pruneheap.c)：回收对所有事务都已不可见的版本——
+ * xmax 已提交且早于最老活动事务的旧版本、回滚时删除的槽位，
+ * 回收的槽位置为 SLOT_UNUSED 供之后插入重用，末尾的空槽位直接截掉，再整理数据区。
+ * 仍存活的元组槽位号不变。
+ *
+ * 被回收的版本之前可能被别处记下了位置（更新链上更老版本的 ctid、
+ * 扫描后还没来得及更新的行），槽位可能已空或被其他行重用，
+ * 沿这些位置取元组时需核对行 OID。
+ * 调用方需持有页面排他锁。
+ */
+
+// 剪枝后页面的情况，清理据此统计存活元组、设置可见性映射
+typedef struct PruneResult {
+    int nlive;         // 剩余的元组数
+    bool all_visible;  // 剩余元组都对所有事务可见（插入事务已提交且早于最老活动事务、未被删除）
+} PruneResult;
+
+/**
+ * @brief 剪枝页面，并按剩余的版本重新计算页头的 prune_xid
+ *
+ * @param oldest_xid 最老活动事务 ID，xmax 早于它且已提交的版本对所有事务都不可见
+ * @param presult 非 NULL 时填入剪枝后页面的情况
+ * @return 回收的槽位数
+ */
+int heap_page_prune(Page* page, const TransactionManager* txmgr, uint32_t oldest_xid,
+                    PruneResult* presult);
+
+/**
+ * @brief 按需剪枝：页面空闲空间低于 max(minfree, PRUNE_MIN_FREE_SPACE)，
+ *        且页头记录的可剪枝 xmax 早于最老活动事务时才剪枝
+ *
+ * @param minfree 调用方这次需要的空间（含 fillfactor 预留）
+ * @return 未剪枝返回 -1；否则返回回收的槽位数（可能为 0），
+ *         此时页头的 prune_xid 已重新计算，调用方需把页面标记为脏
+ */
+int heap_page_prune_opt(Page* page, const TransactionManager* txmgr, size_t minfree);
+
+#endif // PRUNE_H
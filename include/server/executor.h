@@ -14,8 +14,11 @@ typedef struct {
 
 //bool db_create_table(MiniDB* db, const CreateTableStmt* stmt);
 //bool db_insert(MiniDB* db, const char* table_name, const InsertStmt* stmt);
+// 结果集（rows 及其中的字符串）在当前内存上下文中分配，随上下文一起释放
 bool db_select(MiniDB* db, const SelectStmt* stmt, ResultSet* result,Session session);
 //bool db_update(MiniDB* db, const UpdateStmt* stmt, Session* session);
 //bool exce_update(MiniDB* db, const UpdateStmt* stmt, Session* session);
 int db_update(MiniDB *db, const UpdateStmt* stmt, Session session);
+// 按 SET 子句的文本给列赋值；TEXT 列换成新值的副本（在当前内存上下文中分配）
+void set_column_value(Column* column, const char* new_value);
 #endif
\ No newline at end of file
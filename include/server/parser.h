@@ -24,19 +24,22 @@ typedef struct {
     const char* values[MAX_VALUES];  // 直接字符串数组
 } InsertStmt;
 
+// 表达式结构，可根据你已有的 SELECT/WHERE 支持扩展
+// column 用本文件定义的长度：MAX_NAME_LEN 在各头文件中取值不同，随包含顺序变化会让结构布局不一致
+typedef struct Condition {
+    char column[MAX_COLUMN_NAME_LEN];  // 列名
+    char op[4];                        // 操作符，例如 "="、"!="、"<"
+    char value[MAX_WHERE_LEN];         // 值
+} Condition;
+
 typedef struct {
     char table_name[MAX_TABLE_NAME];
     char columns[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
     int num_columns;
+    Condition where;            // WHERE 子句条件（只支持一个简单条件）
+    bool has_where;
 } SelectStmt;
 
-// 表达式结构，可根据你已有的 SELECT/WHERE 支持扩展
-typedef struct {
-    char column[MAX_NAME_LEN];  // 列名
-    char op[4];                 // 操作符，例如 "="、"!="、"<"
-    char value[MAX_WHERE_LEN];  // 值
-} Condition;
-
 // Update语句结构
 typedef struct {
     char table_name[MAX_NAME_LEN];      // 表名
@@ -48,8 +51,15 @@ typedef struct {
     bool has_where;                     // 是否指定了 WHERE 子句
 } UpdateStmt;
 
+// VACUUM [表名]，不带表名时清理所有表
+typedef struct {
+    char table_name[MAX_TABLE_NAME];
+    bool has_table;
+} VacuumStmt;
+
 bool parse_create_table(const char* sql, CreateTableStmt* stmt);
 bool parse_insert(const char* sql, InsertStmt* stmt);
 bool parse_select(const char* sql, SelectStmt* stmt);
 bool parse_update(const char* sql, UpdateStmt* stmt) ;
+bool parse_vacuum(const char* sql, VacuumStmt* stmt);
 #endif
\ No newline at end of file
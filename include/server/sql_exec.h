@@ -10,4 +10,5 @@ bool execute_insert(MiniDB* db, const char* sql,Session session );
 //char* execute_select_to_string(MiniDB* db, const char* sql,Session session) ;
 int execute_select_to_string(MiniDB* db, const char* sql,Session session,char * ret);
 int execute_update_to_string(MiniDB* db, const char* sql, Session session, char* output); 
+bool execute_vacuum(MiniDB* db, const char* sql);
 #endif
@@ -0,0 +1,156 @@
+#ifndef SMGR_H
+#define SMGR_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "types.h"
+#include "config.h"
+
+#define TRANCHE_SMGR_LOCK 3
+#define MAX_SMGR_RELS 128        // 可登记的表文件数上限
+#define SMGR_MAX_PATH 256
+#define SMGR_MIN_OPEN_FILES 4    // 同时打开的文件数下限
+#define SMGR_AIO_QUEUE_DEPTH 64  // 每个线程的 io_uring 队列深度
+
+// 一个进行中的异步读，由发起线程调用 smgr_finish_read 完成
+typedef struct SMgrIO {
+    void* rel;           // 读取期间 pin 住的表文件
+    Page* page;          // 目标页
+    PageID page_id;
+    int result;          // 读到的字节数，出错时为 -errno
+    bool pending;        // 已交给 io_uring 尚未完成
+} SMgrIO;
+
+// 表文件的只读内存映射，由 smgr_map 返回，用完后调用 smgr_unmap
+typedef struct SMgrMap {
+    const Page* pages;   // 映射起始地址
+    PageID nblocks;      // 映射覆盖的页数
+    atomic_int refcount; // 使用者数，存储管理层缓存该映射时另持一个引用
+} SMgrMap;
+
+/*
+ * 存储管理层 (类似 pg 的 smgr/md.c)：按表 OID 登记数据文件，
+ * 缓存已打开的文件描述符，用 pread/pwrite 按页偏移读写。
+ * 打开的文件数达到上限时，按 LRU 关闭当前没有 I/O 在用的描述符。
+ * direct_io 模式下以 O_DIRECT 打开文件，绕过内核页缓存，避免与缓冲池重复缓存；
+ * 调用方的页面不按 PAGE_SIZE 对齐时经线程私有的对齐缓冲区中转。
+ */
+
+/**
+ * @brief 初始化存储管理层（会先关闭之前打开的所有文件）
+ *
+ * @param max_open_files 同时保持打开的文件描述符上限
+ * @param direct_io 是否以 O_DIRECT 打开数据文件
+ * @param io_method 读 I/O 方式
+ */
+void smgr_init(int max_open_files, bool direct_io, IOMethod io_method);
+
+/**
+ * @brief 关闭所有文件描述符并清空登记
+ */
+void smgr_shutdown();
+
+/**
+ * @brief 登记表 OID 对应的数据文件，不立即打开；重复登记时更新路径
+ *
+ * @return 登记表已满时返回 false
+ */
+bool smgr_open(uint32_t rel_oid, const char* path);
+
+/**
+ * @brief 关闭表的文件描述符（保留登记，下次访问时重新打开）
+ */
+void smgr_close(uint32_t rel_oid);
+
+/**
+ * @brief 取已登记表文件的路径
+ *
+ * @return 表未登记时返回 false
+ */
+bool smgr_relpath(uint32_t rel_oid, char* path, size_t size);
+
+/**
+ * @brief 按路径查找已登记的表文件，取其表 OID
+ *
+ * @return 没有表登记在该路径时返回 false
+ */
+bool smgr_lookup_path(const char* path, uint32_t* rel_oid);
+
+/**
+ * @brief 以只读方式映射表文件，供扫描直接访问页面，不经缓冲池、不调用 read
+ *
+ * 每张表缓存一个映射；文件被扩展（页数与映射不符）或重新登记到其他路径时
+ * 建立新映射，旧映射在最后一个使用者释放后解除。映射与 pwrite 写入保持一致，
+ * 但不包含缓冲池中尚未写回的脏页。文件被外部截断时访问映射会触发 SIGBUS。
+ *
+ * @return 表未登记、文件为空或映射失败时返回 NULL
+ */
+SMgrMap* smgr_map(uint32_t rel_oid);
+
+/**
+ * @brief 释放 smgr_map 得到的映射
+ */
+void smgr_unmap(SMgrMap* map);
+
+/**
+ * @brief 取映射中的第 page_id 页，超出映射范围返回 NULL
+ */
+static inline const Page* smgr_map_page(const SMgrMap* map, PageID page_id) {
+    return page_id < map->nblocks ? &map->pages[page_id] : NULL;
+}
+
+/**
+ * @brief 读取第 page_id 页
+ *
+ * @return 表未登记、读失败或页面超出文件末尾时返回 false
+ */
+bool smgr_read(uint32_t rel_oid, PageID page_id, Page* page);
+
+/**
+ * @brief 发起读取第 page_id 页，请求先排队，smgr_submit 或 smgr_finish_read 时提交
+ *
+ * io_uring 不可用时直接同步读完。page 在 smgr_finish_read 之前不能访问。
+ *
+ * @return 表未登记或文件打不开时返回 false
+ */
+bool smgr_start_read(uint32_t rel_oid, PageID page_id, Page* page, SMgrIO* io);
+
+/**
+ * @brief 把本线程排队的读请求提交给内核
+ */
+void smgr_submit();
+
+/**
+ * @brief 等待读请求完成
+ *
+ * @return 读失败或页面超出文件末尾时返回 false
+ */
+bool smgr_finish_read(SMgrIO* io);
+
+/**
+ * @brief 写入第 page_id 页（超出文件末尾时文件自动扩展）
+ */
+bool smgr_write(uint32_t rel_oid, PageID page_id, const Page* page);
+
+/**
+ * @brief 为 [first_page, first_page + npages) 预分配磁盘空间（fallocate），
+ * 文件系统不支持时用 ftruncate 扩展文件长度。新页内容全为 0，读入时需初始化。
+ *
+ * @return 是否成功
+ */
+bool smgr_extend(uint32_t rel_oid, PageID first_page, int npages);
+
+/**
+ * @brief 数据文件当前的页数，失败返回 0
+ */
+PageID smgr_nblocks(uint32_t rel_oid);
+
+/**
+ * @brief 把数据文件截断为 nblocks 页，并丢弃缓存的映射
+ *
+ * 调用方需保证截掉的页不再被访问（缓冲池中的页已用 DropRelationBuffers 丢弃）。
+ *
+ * @return 是否成功
+ */
+bool smgr_truncate(uint32_t rel_oid, PageID nblocks);
+
+#endif // SMGR_H
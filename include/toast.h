@@ -0,0 +1,68 @@
+#ifndef TOAST_H
+#define TOAST_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "types.h"
+
+#define TRANCHE_TOAST_LOCK 6
+#define TOAST_FILE_SUFFIX ".toast"   // 外部存储文件 = 表文件名 + 后缀
+
+/*
+ * 大字段存储 (类似 pg 的 TOAST)：序列化后超过 TOAST_TUPLE_THRESHOLD 的元组，
+ * 先从最长的 TEXT 列开始用 zlib 压缩，仍然超过就把最长的列移到表文件旁的 .toast 文件，
+ * 元组中只留一个外部指针，直到元组不超过 TOAST_TUPLE_TARGET。
+ *
+ * 序列化的 TEXT 列为 uint16 长度字 + 内容，长度字的高两位标记存储形式：
+ *   无标记          内容是字符串本身
+ *   TEXT_COMPRESSED 内容是 uint32 原长 + zlib 压缩数据
+ *   TEXT_EXTERNAL   内容是 ToastPointer
+ * 读取时只有调用方需要的列才解压或从 .toast 文件取回（见 page_get_tuple_attrs）。
+ *
+ * .toast 文件只追加，值的空间不随元组清理回收。
+ */
+#define TEXT_COMPRESSED  0x4000
+#define TEXT_EXTERNAL    0x8000
+#define TEXT_LEN_MASK    0x3FFF      // 行内内容最长 16383 字节
+
+#define TOAST_TUPLE_THRESHOLD (PAGE_DATA_SIZE / 4)
+#define TOAST_TUPLE_TARGET    TOAST_TUPLE_THRESHOLD
+#define TOAST_MIN_COMPRESS    32     // 短于此长度的值不尝试压缩
+
+// 外部存储指针，ext_size < raw_size 表示存的是压缩数据
+typedef struct ToastPointer {
+    uint64_t offset;     // 值在 .toast 文件中的偏移
+    uint32_t ext_size;   // 文件中的字节数
+    uint32_t raw_size;   // 原始字符串长度
+} ToastPointer;
+
+/**
+ * @brief 按需压缩、移出 TEXT 列后序列化元组 (类似 pg 的 heap_toast_insert_or_update)
+ *
+ * 表需已在存储管理层登记。元组本身不修改。
+ *
+ * @param buffer 至少 MAX_TUPLE_SIZE 字节
+ * @return 序列化后的字节数，写 .toast 文件失败或移出后仍超过 MAX_TUPLE_SIZE 时返回 0
+ */
+size_t heap_toast_serialize(uint32_t rel_oid, const Tuple* tuple, uint8_t* buffer);
+
+/**
+ * @brief 取出一个序列化的 TEXT 值（压缩的解压，外部存储的从 .toast 文件读回）
+ *
+ * @param header 长度字
+ * @param data 长度字之后的内容
+ * @return palloc 分配的字符串（在当前内存上下文中），出错返回 NULL
+ */
+char* detoast_text(uint32_t rel_oid, uint16_t header, const uint8_t* data);
+
+/**
+ * @brief 把所有 .toast 文件刷到磁盘（检查点在写回数据页之前调用）
+ */
+void toast_sync_all();
+
+/**
+ * @brief 关闭所有 .toast 文件
+ */
+void toast_shutdown();
+
+#endif // TOAST_H
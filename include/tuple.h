@@ -14,12 +14,69 @@ Tuple* copy_tuple(const Tuple* src);
 // 释放元组内存
 void free_tuple(Tuple* tuple);
 
-// 序列化元组
+// TEXT 列的序列化形式：长度字 + 内容（长度字的标记见 toast.h）
+typedef struct TextDatum {
+    uint16_t header;
+    const uint8_t* data;   // NULL 表示按元组中的字符串序列化
+} TextDatum;
+
+// 序列化元组头中 infomask 的偏移（布局见 serialize_tuple：oid, xmin, xmax, ctid, infomask, ...）
+#define TUPLE_INFOMASK_OFFSET (3 * sizeof(uint32_t) + sizeof(PageID) + sizeof(uint16_t))
+
+// 元组序列化后的字节数
+size_t tuple_serialized_size(const Tuple* tuple);
+
+// 按 datums 替换部分 TEXT 列的存储形式后的字节数，datums 为 NULL 或 col_count 项
+size_t tuple_serialized_size_datums(const Tuple* tuple, const TextDatum* datums);
+
+// 序列化元组，有 TEXT 列长度超过 TEXT_LEN_MASK 时返回 0（需先经 heap_toast_serialize）
 size_t serialize_tuple(const Tuple* tuple, uint8_t* buffer);
 
+// 序列化元组，部分 TEXT 列按 datums 写入
+size_t serialize_tuple_datums(const Tuple* tuple, const TextDatum* datums, uint8_t* buffer);
+
 // 反序列化元组
 size_t deserialize_tuple(Tuple* tuple, const uint8_t* buffer);
 
+/*
+ * 按需反序列化元组 (类似 pg 的 slot_getsomeattrs)：needed 为 NULL 表示所有列都需要，
+ * 否则只解析到最后一个 needed[i] 为真的列，col_count 为已解析的列数，
+ * 其中不需要的 TEXT 列不复制、不解压，str_val 为 NULL。rel_oid 用于读取 .toast 文件。
+ * 返回读过的字节数（只解析部分列时小于元组长度），失败返回 0。
+ */
+size_t deserialize_tuple_attrs(Tuple* tuple, const uint8_t* buffer, uint32_t rel_oid,
+                               const bool* needed);
+
+// 序列化元组头的长度：oid, xmin, xmax, ctid, infomask, deleted, col_count
+#define TUPLE_HEADER_SIZE (TUPLE_INFOMASK_OFFSET + 3)
+
+// 按列类型算出 meta->attcacheoff，建表和加载表元数据时调用
+void tuple_init_attcache(TableMeta* meta);
+
+// 在 length 字节的序列化元组上建立视图，数据不完整时返回 false
+bool tuple_view_init(TupleView* view, const uint8_t* data, uint16_t length, uint32_t rel_oid);
+
+// 按类型读列，列号越界或类型不符时返回 false
+bool tuple_view_get_int(const TupleView* view, int attno, int32_t* value);   // INT4 / DATE
+bool tuple_view_get_float(const TupleView* view, int attno, float* value);
+bool tuple_view_get_bool(const TupleView* view, int attno, bool* value);
+
+/*
+ * 读 TEXT 列：行内未压缩的值返回指向页面的指针（不以 '\0' 结尾），长度写入 len；
+ * 压缩或外部存储的值返回 NULL，需用 tuple_view_copy_text 取出
+ */
+const char* tuple_view_get_text(const TupleView* view, int attno, size_t* len);
+
+// 复制 TEXT 列为 palloc 分配的字符串（必要时解压或读 .toast 文件）
+char* tuple_view_copy_text(const TupleView* view, int attno);
+
+// 把视图转成 Tuple，needed 的含义同 deserialize_tuple_attrs
+Tuple* tuple_view_materialize(const TupleView* view, const bool* needed);
+
+// 同 is_tuple_visible / eval_condition，不复制元组
+bool tuple_view_is_visible(TransactionManager* txmgr, const TupleView* view, uint32_t current_xid);
+bool tuple_view_eval_condition(const Condition* cond, const TupleView* view, const TableMeta* meta);
+
 // 获取元组中指定列的值
 void* tuple_get_value(const Tuple* tuple, uint8_t col_index);
 
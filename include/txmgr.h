@@ -88,6 +88,8 @@ uint32_t txmgr_get_oldest_xid(const TransactionManager *txmgr);
 uint32_t txmgr_get_next_xid(const TransactionManager *txmgr);
 
 bool txmgr_is_committed(const TransactionManager* txmgr,uint32_t xid);
+// 事务是否仍在进行中（未提交也未中止）
+bool txmgr_is_in_progress(const TransactionManager* txmgr, uint32_t xid);
 
 bool save_tx_state(const TransactionManager* txmgr, const char* db_path) ;
 
@@ -17,9 +17,13 @@
 
 
 
-// 页面ID类型
-#define PAGE_SIZE 4096   // 4KB
-#define PAGE_HEADER_SIZE 32
+// 数据页大小，构建时由 cmake -DMINIDB_BLOCK_SIZE=... 选定（类似 pg 的 --with-blocksize），
+// 建库时记录在控制文件中，之后只能用同样页大小的构建打开
+#ifndef BLCKSZ
+#define BLCKSZ 4096
+#endif
+#define PAGE_SIZE BLCKSZ
+#define PAGE_HEADER_SIZE sizeof(PageHeader)
 #define INVALID_PAGE_ID 0xFFFFFFFF
 
 #define MAX_NAME_LEN 50
@@ -35,13 +39,14 @@
 #define MAX_RESULTS 1000  // 添加 MAX_RESULTS 定义
 typedef uint32_t PageID;
 
-#define MAX_SLOTS 64
-#define SLOT_ARRAY_SIZE (MAX_SLOTS * sizeof(Slot))
 #define PAGE_DATA_SIZE (PAGE_SIZE - sizeof(PageHeader))
+#define SLOT_UNUSED   0x00  // 空槽位（剪枝回收后），可被新元组重用
 #define SLOT_OCCUPIED 0x01
 #define SLOT_DELETED  0x02
 #define MAX_TUPLE_SIZE (PAGE_DATA_SIZE / 2)
 #define INVALID_SLOT 0xFFFF
+#define HEAP_DEFAULT_FILLFACTOR 100
+#define HEAP_MIN_FILLFACTOR 10
 #define MAX_XID 100000  // 最多支持 10 万个事务
 #define COMMIT_BITMAP_SIZE (MAX_XID / 8)  // 每个事务1bit
 
@@ -75,16 +80,46 @@ typedef struct {
     DataType type;
 } ColumnDef;
 
+// 元组在表中的位置 (类似 pg 的 ItemPointerData)
+typedef struct ItemPointer {
+    PageID page_id;
+    uint16_t slot;
+} ItemPointer;
+
+// Tuple.infomask 标志
+#define TUPLE_UPDATED      0x01  // 已被更新，ctid 指向新版本
+#define TUPLE_HOT_UPDATED  0x02  // 新版本与本版本在同一页 (HOT 更新)
+#define TUPLE_HEAP_ONLY    0x04  // 本版本由 HOT 更新产生，只能经更新链到达
+
 // 元组结构
 typedef struct {
     uint32_t oid;         // 元组唯一ID
     uint32_t xmin;        // 创建事务ID (MVCC)
     uint32_t xmax;        // 删除/更新事务ID (MVCC)
+    ItemPointer ctid;     // 更新链：infomask 含 TUPLE_UPDATED 时指向新版本
+    uint8_t infomask;     // TUPLE_* 标志
     bool deleted;         // 逻辑删除标志
     uint8_t col_count;    // 列数量
     Column* columns;      // 列数据数组
 } Tuple;
 
+/*
+ * 只读元组视图：直接指向缓冲区页面中的序列化元组，不分配内存。
+ * 头部字段在建立视图时复制出来；列数据仍在页面中，
+ * 调用方在读列期间需持有页面的 pin 和页锁，页面被修改（如插入时整理）后不能再读列。
+ */
+typedef struct TupleView {
+    const uint8_t* data;    // 序列化元组的起始
+    uint16_t length;
+    uint32_t rel_oid;       // 取外部存储的 TEXT 值时用
+    uint32_t oid;
+    uint32_t xmin;
+    uint32_t xmax;
+    ItemPointer ctid;
+    uint8_t infomask;
+    uint8_t col_count;
+    const uint16_t* attcacheoff;  // 表的缓存列偏移，NULL 表示逐列计算
+} TupleView;
 
 
 // 页头结构
@@ -112,12 +147,13 @@ typedef struct PageHeader {
     uint32_t checksum;
     PageID page_id;
     uint32_t lsn;
-    uint16_t free_start;     // 数据区当前偏移
-        uint16_t free_end;     // 数据区当前偏移
+    uint16_t free_start;     // 槽位数组末尾，即空闲区起点（数据区内偏移）
+    uint16_t free_end;       // 元组数据起点，即空闲区终点（数据区内偏移）
 
     uint16_t free_space;     // 剩余空间
     uint16_t tuple_count;    // 有效元组数量
     uint16_t slot_count;     // 槽位使用数量
+    uint32_t prune_xid;      // 页上最老的可剪枝 xmax，0 表示没有可剪枝的版本
     PageID next_page;
     PageID prev_page;
 } PageHeader;
@@ -169,9 +205,22 @@ typedef struct proclist_head {
 typedef struct LWLock {
     uint16_t tranche;
     atomic_uint state;        // bit0 = exclusive，bit1~ = shared count
+    atomic_uint nwaiters;     // 正在等待排他锁的线程数
     proclist_head waiters;
 } LWLock;
 
+typedef enum {
+    LW_EXCLUSIVE,
+    LW_SHARED
+} LWLockMode;
+
+// 按缓存行对齐的 LWLock，用于锁数组，避免相邻锁伪共享
+#define LWLOCK_PADDED_SIZE 64
+typedef union LWLockPadded {
+    LWLock lock;
+    char pad[LWLOCK_PADDED_SIZE];
+} LWLockPadded;
+
 typedef struct {
     char table_name[64];
     uint32_t oid;  // 该行的 OID（Tuple 中的 oid 字段）
@@ -190,20 +239,30 @@ typedef struct RowLock {
     struct RowLock *next;
 } RowLock;
 
+/*
+ * 磁盘页：恰好 PAGE_SIZE 字节，只含持久化内容；页锁等运行时状态在缓冲区描述符中。
+ * 数据区按 slotted page 组织：槽位数组从头部向后增长，元组数据从页尾向前增长，
+ * 两者之间为空闲区，每页能放多少元组只取决于元组大小。
+ */
 typedef struct Page {
     PageHeader header;
-    Slot slots[MAX_SLOTS];          // 槽位数组
-    uint8_t data[PAGE_DATA_SIZE];   // 数据区
-       // ✅ 每页一个锁
-    LWLock lock;
+    uint8_t data[PAGE_DATA_SIZE];   // 槽位数组 + 空闲区 + 元组数据
 } Page;
+_Static_assert(sizeof(Page) == PAGE_SIZE, "Page must be exactly PAGE_SIZE bytes");
+_Static_assert(PAGE_SIZE == 4096 || PAGE_SIZE == 8192 || PAGE_SIZE == 16384 || PAGE_SIZE == 32768,
+               "PAGE_SIZE must be 4, 8, 16 or 32 kB");
+// 页内偏移（槽位 offset/length、free_start/free_end）为 uint16_t
+_Static_assert(PAGE_DATA_SIZE <= UINT16_MAX, "page offsets must fit in uint16_t");
+
+// 页面的槽位数组，共 header.slot_count 项
+#define PageGetSlots(page) ((Slot*)(page)->data)
 
 
 // 表元数据
 typedef struct {
     uint32_t oid;
     char name[MAX_NAME_LEN];
-    char filename[MAX_NAME_LEN];
+    char filename[MAX_NAME_LEN + sizeof(".tbl")];  // 表名加 .tbl，表名最长时也放得下
     uint8_t col_count;
     ColumnDef cols[MAX_COLS];
     PageID first_page;   // 表的第一个页面ID
@@ -211,6 +270,15 @@ PageID last_page;    // 表的最后一个页面ID
 
   // ✅ 新增：元组的最大 OID
     uint32_t max_row_oid;
+    uint8_t fillfactor;  // 插入时每页最多填到的百分比，其余留给 HOT 更新
+    // 列在序列化元组中的固定偏移（类型字节处，类似 pg 的 attcacheoff），
+    // 只有第一个变长列及其之前的列有，0 表示需要逐列计算；见 tuple_init_attcache
+    uint16_t attcacheoff[MAX_COLS];
+
+    // 元组计数（类似 pg_stat 的 n_live_tup/n_dead_tup），只在内存中，自动清理据此选表
+    atomic_uint n_live_tup;   // 估计的存活元组数
+    atomic_uint n_dead_tup;   // 尚未回收的死元组数
+    atomic_flag vacuuming;    // 正在清理，同一张表同时只有一个清理
 
     LWLock fsm_lock;
     LWLock extension_lock;
@@ -265,7 +333,7 @@ typedef struct {
     int client_fd;             // 客户端 socket fd
     MiniDB* db;                // 指向数据库
     uint32_t current_xid;      // 当前连接的事务 ID
-    
+    struct MemoryContextData* memctx;  // 会话级内存上下文（见 memctx.h），语句的上下文挂在其下
 } Session;
 
 
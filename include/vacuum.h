@@ -0,0 +1,78 @@
+#ifndef VACUUM_H
+#define VACUUM_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "minidb.h"
+
+// 清理每页的代价（类似 pg 的 vacuum_cost_page_*），累计到 cost_limit 时休眠 cost_delay
+#define VACUUM_COST_PAGE_HIT   1   // 页面已在缓冲池
+#define VACUUM_COST_PAGE_MISS  10  // 页面需从磁盘读入
+#define VACUUM_COST_PAGE_DIRTY 20  // 清理弄脏了页面
+#define MAX_AUTOVACUUM_WORKERS 16
+
+/*
+ * 清理 (类似 pg 的 vacuumlazy.c)：逐页剪枝，回收对所有事务都已不可见的版本，
+ * 把每页的空闲空间记入空闲空间映射，全部可见的页记入可见性映射，
+ * 可见性映射中已置位的页没有可回收的版本，直接跳过。
+ * 扫描完后截掉表尾的空页，缩小表文件。
+ *
+ * 自动清理线程按各表的死元组计数选表：
+ * n_dead_tup > autovacuum_vacuum_threshold + autovacuum_vacuum_scale_factor * n_live_tup。
+ * 清理按页累计 I/O 代价，超过上限就休眠，避免影响前台查询的延迟。
+ */
+
+// 一次清理的参数
+typedef struct VacuumParams {
+    int cost_delay;              // 代价累计到 cost_limit 后休眠的毫秒数，0 表示不限速
+    int cost_limit;
+    const atomic_bool* cancel;   // 非 NULL 且置位时尽快结束（自动清理线程退出）
+} VacuumParams;
+
+// 一次清理的结果
+typedef struct VacuumStats {
+    PageID scanned_pages;    // 读过的页数
+    PageID skipped_pages;    // 按可见性映射跳过的全部可见页
+    int tuples_removed;      // 回收的死版本（含回滚删除的槽位）
+    int live_tuples;         // 读过的页上剩余的元组数
+    PageID truncated_pages;  // 从表尾截掉的空页数
+} VacuumStats;
+
+/**
+ * @brief 清理一张表
+ *
+ * 同一张表同时只有一个清理，另一个清理正在进行时等它结束。
+ *
+ * @param stats 非 NULL 时填入清理结果
+ * @return 表文件无法打开时返回 false
+ */
+bool vacuum_table(MiniDB* db, TableMeta* meta, const VacuumParams* params, VacuumStats* stats);
+
+/**
+ * @brief VACUUM 命令：按 vacuum_cost_delay/vacuum_cost_limit 清理一张表或所有表
+ *
+ * @param table_name 表名，NULL 表示所有表
+ * @return 清理的表数，表不存在返回 -1
+ */
+int db_vacuum(MiniDB* db, const char* table_name);
+
+/**
+ * @brief 启动自动清理线程，每个线程每隔 naptime_ms 毫秒检查一遍所有表
+ *
+ * @param max_workers 线程数（1..MAX_AUTOVACUUM_WORKERS）
+ * @return 是否已启动
+ */
+bool autovacuum_start(MiniDB* db, int max_workers, int naptime_ms);
+
+/**
+ * @brief 通知自动清理线程退出（正在进行的清理提前结束）并等待其结束
+ */
+void autovacuum_stop();
+
+// 元组计数，供自动清理选表
+void pgstat_count_heap_insert(TableMeta* meta);
+void pgstat_count_heap_dead(TableMeta* meta, int n);
+// 剪枝回收了 n 个死版本
+void pgstat_count_heap_prune(TableMeta* meta, int n);
+
+#endif // VACUUM_H
@@ -0,0 +1,71 @@
+#ifndef VM_H
+#define VM_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "types.h"
+#include "lock.h"
+
+#define TRANCHE_VM_LOCK 5
+#define VM_FILE_SUFFIX ".vm"         // 可见性映射文件 = 表文件名 + 后缀
+
+/*
+ * 可见性映射 (类似 pg 的 visibilitymap.c)：每个数据页 1 位，置位表示页上所有元组
+ * 对所有事务都可见（插入事务已提交且早于最老活动事务，也没有被删除/更新）。
+ * 扫描遇到置位的页不再逐行判断可见性，清理时可整页跳过。
+ *
+ * 置位的页被修改前必须先清位：修改页面的一方持有页面排他锁时调用
+ * visibilitymap_clear，置位的一方持有页面共享锁时调用 visibilitymap_set，
+ * 因此不会把正在被修改的页标为全部可见。
+ * 映射持久化在表文件旁的 .vm 文件中，置位在检查点时写回，清位立即写入文件，
+ * 保证磁盘上的映射不会比数据页更“乐观”。
+ */
+typedef struct VisibilityMap {
+    uint32_t rel_oid;
+    char path[256];       // .vm 文件路径
+    uint8_t* bits;        // 每页 1 位
+    PageID capacity;      // bits 能容纳的页数，8 的倍数
+    PageID file_nblocks;  // .vm 文件中已有的页数（清位时只需写这部分）
+    int fd;               // 清位写入用的文件描述符，-1 表示尚未打开；写回改名后重新打开
+    bool dirty;           // 自上次写回后是否有新置位
+    LWLock lock;
+} VisibilityMap;
+
+/**
+ * @brief 取表的可见性映射，首次访问时从 .vm 文件加载
+ *
+ * @param table_path 表数据文件路径
+ * @return 内存不足或登记已满时返回 NULL
+ */
+VisibilityMap* vm_open(uint32_t rel_oid, const char* table_path);
+
+/**
+ * @brief 页面是否已标记为全部可见，调用方需持有页面的内容锁
+ */
+bool visibilitymap_test(VisibilityMap* vm, PageID page_id);
+
+/**
+ * @brief 把页面标记为全部可见，调用方需持有页面的内容锁
+ */
+void visibilitymap_set(VisibilityMap* vm, PageID page_id);
+
+/**
+ * @brief 清除页面的全部可见标记，调用方修改页面前需以排他模式持有页面的内容锁
+ */
+void visibilitymap_clear(VisibilityMap* vm, PageID page_id);
+
+/**
+ * @brief 表被截断为 nblocks 页后，清除截掉的页的标记
+ */
+void visibilitymap_truncate(VisibilityMap* vm, PageID nblocks);
+
+/**
+ * @brief 把所有有新置位的映射写回 .vm 文件（检查点时调用）
+ */
+void vm_sync_all();
+
+/**
+ * @brief 释放所有映射并关闭文件（不写回）
+ */
+void vm_shutdown();
+
+#endif // VM_H
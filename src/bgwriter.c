@@ -0,0 +1,80 @@
+#include "bgwriter.h"
+#include "page.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+
+// 后台写进程状态
+static struct {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;   // 用于提前唤醒以便退出
+    bool running;
+    bool stop_requested;
+    int delay_ms;
+    int max_pages;
+} bgwriter = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void* bgwriter_main(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&bgwriter.mutex);
+    while (!bgwriter.stop_requested) {
+        pthread_mutex_unlock(&bgwriter.mutex);
+        BgBufferSync(bgwriter.max_pages);
+        pthread_mutex_lock(&bgwriter.mutex);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += bgwriter.delay_ms / 1000;
+        deadline.tv_nsec += (long)(bgwriter.delay_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!bgwriter.stop_requested &&
+               pthread_cond_timedwait(&bgwriter.cond, &bgwriter.mutex, &deadline) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&bgwriter.mutex);
+    return NULL;
+}
+
+bool bgwriter_start(int delay_ms, int max_pages) {
+    bgwriter_stop();
+    if (max_pages <= 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&bgwriter.mutex);
+    bgwriter.delay_ms = delay_ms > 0 ? delay_ms : 1;
+    bgwriter.max_pages = max_pages;
+    bgwriter.stop_requested = false;
+    if (pthread_create(&bgwriter.thread, NULL, bgwriter_main, NULL) != 0) {
+        pthread_mutex_unlock(&bgwriter.mutex);
+        perror("bgwriter: pthread_create failed");
+        return false;
+    }
+    bgwriter.running = true;
+    pthread_mutex_unlock(&bgwriter.mutex);
+    return true;
+}
+
+void bgwriter_stop() {
+    pthread_mutex_lock(&bgwriter.mutex);
+    if (!bgwriter.running) {
+        pthread_mutex_unlock(&bgwriter.mutex);
+        return;
+    }
+    bgwriter.stop_requested = true;
+    pthread_cond_signal(&bgwriter.cond);
+    pthread_mutex_unlock(&bgwriter.mutex);
+
+    pthread_join(bgwriter.thread, NULL);
+    pthread_mutex_lock(&bgwriter.mutex);
+    bgwriter.running = false;
+    pthread_mutex_unlock(&bgwriter.mutex);
+}
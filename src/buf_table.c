@@ -0,0 +1,93 @@
+#include "buf_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 初始化映射表
+bool buf_table_init(BufTable* table, int nbuffers) {
+    uint32_t nbuckets = NUM_BUFFER_PARTITIONS;
+    while (nbuckets < (uint32_t)nbuffers * 2) {
+        nbuckets <<= 1;
+    }
+
+    table->buckets = malloc(nbuckets * sizeof(int));
+    table->entries = malloc(nbuffers * sizeof(BufTableEntry));
+    if (!table->buckets || !table->entries) {
+        free(table->buckets);
+        free(table->entries);
+        table->buckets = NULL;
+        table->entries = NULL;
+        return false;
+    }
+
+    // 所有桶置空 (-1)
+    memset(table->buckets, 0xFF, nbuckets * sizeof(int));
+    for (int i = 0; i < nbuffers; i++) {
+        table->entries[i].next = -1;
+        table->entries[i].used = false;
+    }
+    table->bucket_mask = nbuckets - 1;
+    table->nbuffers = nbuffers;
+    return true;
+}
+
+void buf_table_destroy(BufTable* table) {
+    free(table->buckets);
+    free(table->entries);
+    table->buckets = NULL;
+    table->entries = NULL;
+    table->nbuffers = 0;
+}
+
+// 哈希函数：混合表 OID 和页号 (murmur3 finalizer)
+uint32_t buf_table_hash_code(const BufferTag* tag) {
+    uint32_t h = tag->rel_oid * 0x9E3779B1u ^ tag->page_id;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+int buf_table_lookup(const BufTable* table, const BufferTag* tag, uint32_t hashcode) {
+    int id = table->buckets[hashcode & table->bucket_mask];
+    while (id >= 0) {
+        const BufTableEntry* entry = &table->entries[id];
+        if (BUFFER_TAGS_EQUAL(&entry->tag, tag)) {
+            return id;
+        }
+        id = entry->next;
+    }
+    return -1;
+}
+
+int buf_table_insert(BufTable* table, const BufferTag* tag, uint32_t hashcode, int buf_id) {
+    int existing = buf_table_lookup(table, tag, hashcode);
+    if (existing >= 0) {
+        return existing;
+    }
+
+    // 挂到桶链表头部
+    int* bucket = &table->buckets[hashcode & table->bucket_mask];
+    BufTableEntry* entry = &table->entries[buf_id];
+    entry->tag = *tag;
+    entry->next = *bucket;
+    entry->used = true;
+    *bucket = buf_id;
+    return -1;
+}
+
+bool buf_table_delete(BufTable* table, const BufferTag* tag, uint32_t hashcode) {
+    int* link = &table->buckets[hashcode & table->bucket_mask];
+    while (*link >= 0) {
+        BufTableEntry* entry = &table->entries[*link];
+        if (BUFFER_TAGS_EQUAL(&entry->tag, tag)) {
+            *link = entry->next;
+            entry->next = -1;
+            entry->used = false;
+            return true;
+        }
+        link = &entry->next;
+    }
+    return false;
+}
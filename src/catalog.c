@@ -1,10 +1,17 @@
 #include "minidb.h"
+#include "catalog.h"
 #include <dirent.h>
 #include <fnmatch.h>
-#define MAX_COLUMNS 10
 // 初始化系统目录
 
 
+// 表的数据文件名：表名加 .tbl（filename 按最长的表名留足了空间）
+static void set_table_filename(TableMeta *meta) {
+    size_t len = strlen(meta->name);
+    memcpy(meta->filename, meta->name, len);
+    memcpy(meta->filename + len, ".tbl", sizeof(".tbl"));
+}
+
 void _dir_init_system_catalog(SystemCatalog *catalog, const char *db_path) {
     catalog->table_count = 0;
     catalog->next_oid = 1000;
@@ -21,7 +28,7 @@ void _dir_init_system_catalog(SystemCatalog *catalog, const char *db_path) {
         if (!fnmatch("*.meta", entry->d_name, 0)) {
             if (strcmp(entry->d_name, "catalog.meta") == 0) continue;
 
-            char full_path[256];
+            char full_path[512];
             snprintf(full_path, sizeof(full_path), "%s/%s", db_path, entry->d_name);
 
             FILE *fp = fopen(full_path, "rb");
@@ -31,11 +38,11 @@ void _dir_init_system_catalog(SystemCatalog *catalog, const char *db_path) {
             memset(meta, 0, sizeof(TableMeta));
 
             // 提取表名（去掉 .meta）
-            strncpy(meta->name, entry->d_name, MAX_NAME_LEN);
+            snprintf(meta->name, sizeof(meta->name), "%.*s", MAX_NAME_LEN - 1, entry->d_name);
             char *dot = strstr(meta->name, ".meta");
             if (dot) *dot = '\0';
 
-            snprintf(meta->filename, MAX_NAME_LEN, "%s.tbl", meta->name);
+            set_table_filename(meta);
 
             // 加载字段
             fread(&meta->oid, sizeof(uint32_t), 1, fp);
@@ -43,6 +50,7 @@ void _dir_init_system_catalog(SystemCatalog *catalog, const char *db_path) {
             fread(meta->cols, sizeof(ColumnDef), MAX_COLS, fp);
             fread(&meta->first_page, sizeof(PageID), 1, fp);
             fread(&meta->last_page, sizeof(PageID), 1, fp);
+            tuple_init_attcache(meta);
 
             fclose(fp);
 
@@ -73,7 +81,7 @@ void init_system_catalog(SystemCatalog *catalog, const char *db_path) {
         if (!fnmatch("*.meta", entry->d_name, 0)) {
             if (strcmp(entry->d_name, "catalog.meta") == 0) continue;
 
-            char full_path[256];
+            char full_path[512];
             snprintf(full_path, sizeof(full_path), "%s/%s", db_path, entry->d_name);
 
             FILE *fp = fopen(full_path, "rb");
@@ -84,11 +92,14 @@ void init_system_catalog(SystemCatalog *catalog, const char *db_path) {
 
             // 读取表名长度和表名
             uint8_t name_len;
-            fread(&name_len, sizeof(uint8_t), 1, fp);
+            if (fread(&name_len, sizeof(uint8_t), 1, fp) != 1 || name_len >= MAX_NAME_LEN) {
+                fclose(fp);
+                continue;
+            }
             fread(meta->name, 1, name_len, fp);
             meta->name[name_len] = '\0';
 
-            snprintf(meta->filename, MAX_NAME_LEN, "%s.tbl", meta->name);
+            set_table_filename(meta);
 
             // 读取列数
             fread(&meta->col_count, sizeof(uint8_t), 1, fp);
@@ -104,6 +115,12 @@ void init_system_catalog(SystemCatalog *catalog, const char *db_path) {
              fread(&meta->first_page, sizeof(uint32_t), 1, fp);
             fread(&meta->last_page, sizeof(uint32_t), 1, fp);
             fread(&meta->max_row_oid, sizeof(uint32_t), 1, fp);
+            // 旧的 .meta 文件没有 fillfactor
+            if (fread(&meta->fillfactor, sizeof(uint8_t), 1, fp) != 1 ||
+                meta->fillfactor < HEAP_MIN_FILLFACTOR || meta->fillfactor > 100) {
+                meta->fillfactor = HEAP_DEFAULT_FILLFACTOR;
+            }
+            tuple_init_attcache(meta);
 
             fclose(fp);
 
@@ -176,6 +193,7 @@ void init_system_catalog(SystemCatalog *catalog, const char *db_path) {
     fwrite(&meta->first_page, sizeof(uint32_t), 1, file);
      fwrite(&meta->last_page, sizeof(uint32_t), 1, file);
     fwrite(&meta->max_row_oid, sizeof(uint32_t), 1, file);
+    fwrite(&meta->fillfactor, sizeof(uint8_t), 1, file);
 
     fclose(file);
     return true;
@@ -211,16 +229,20 @@ int create_table(SystemCatalog *catalog, const char *table_name, ColumnDef *colu
     strncpy(meta->name, table_name, MAX_NAME_LEN);
     meta->name[MAX_NAME_LEN - 1] = '\0'; // 确保以null结尾
     
-    // 设置数据文件名（使用表名而不是OID）
-    snprintf(meta->filename, MAX_NAME_LEN, "%s.tbl", table_name);
+    // 设置数据文件名（使用截断后的表名而不是OID，与 .meta 文件名一致）
+    set_table_filename(meta);
     
     meta->col_count = col_count;
     meta->first_page = 0;
     meta->last_page = 0;
+    meta->fillfactor = HEAP_DEFAULT_FILLFACTOR;
+    atomic_store(&meta->n_live_tup, 0);
+    atomic_store(&meta->n_dead_tup, 0);
+    atomic_flag_clear(&meta->vacuuming);
     
     // 复制列定义（确保不溢出）
     for (int i = 0; i < col_count; i++) {
-        if (i >= MAX_COLUMNS) {
+        if (i >= MAX_COLS) {
             fprintf(stderr, "Too many columns for table %s\n", table_name);
             return -1;
         }
@@ -229,6 +251,7 @@ int create_table(SystemCatalog *catalog, const char *table_name, ColumnDef *colu
         meta->cols[i].name[MAX_NAME_LEN - 1] = '\0';
         meta->cols[i].type = columns[i].type;
     }
+    tuple_init_attcache(meta);
     
     // ===================================================
     // 保存元数据和创建数据文件
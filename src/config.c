@@ -0,0 +1,271 @@
+#include "config.h"
+#include "types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+MiniDBConfig db_config = {
+    .shared_buffers = DEFAULT_SHARED_BUFFERS,
+    .huge_pages = HUGE_PAGES_TRY,
+    .bgwriter_delay = DEFAULT_BGWRITER_DELAY,
+    .bgwriter_lru_maxpages = DEFAULT_BGWRITER_LRU_MAXPAGES,
+    .max_files_per_process = DEFAULT_MAX_FILES_PER_PROCESS,
+    .direct_io = false,
+    .io_method = IO_METHOD_IO_URING,
+    .effective_io_concurrency = DEFAULT_EFFECTIVE_IO_CONCURRENCY,
+    .mmap_scans = false,
+    .autoprewarm = true,
+    .autoprewarm_interval = DEFAULT_AUTOPREWARM_INTERVAL,
+    .autovacuum = true,
+    .autovacuum_max_workers = DEFAULT_AUTOVACUUM_MAX_WORKERS,
+    .autovacuum_naptime = DEFAULT_AUTOVACUUM_NAPTIME,
+    .autovacuum_vacuum_threshold = DEFAULT_AUTOVACUUM_VACUUM_THRESHOLD,
+    .autovacuum_vacuum_scale_factor = DEFAULT_AUTOVACUUM_VACUUM_SCALE_FACTOR,
+    .autovacuum_vacuum_cost_delay = DEFAULT_AUTOVACUUM_VACUUM_COST_DELAY,
+    .autovacuum_vacuum_cost_limit = DEFAULT_VACUUM_COST_LIMIT,
+    .vacuum_cost_delay = 0,
+    .vacuum_cost_limit = DEFAULT_VACUUM_COST_LIMIT,
+};
+
+void config_set_defaults(MiniDBConfig* config) {
+    config->shared_buffers = DEFAULT_SHARED_BUFFERS;
+    config->huge_pages = HUGE_PAGES_TRY;
+    config->bgwriter_delay = DEFAULT_BGWRITER_DELAY;
+    config->bgwriter_lru_maxpages = DEFAULT_BGWRITER_LRU_MAXPAGES;
+    config->max_files_per_process = DEFAULT_MAX_FILES_PER_PROCESS;
+    config->direct_io = false;
+    config->io_method = IO_METHOD_IO_URING;
+    config->effective_io_concurrency = DEFAULT_EFFECTIVE_IO_CONCURRENCY;
+    config->mmap_scans = false;
+    config->autoprewarm = true;
+    config->autoprewarm_interval = DEFAULT_AUTOPREWARM_INTERVAL;
+    config->autovacuum = true;
+    config->autovacuum_max_workers = DEFAULT_AUTOVACUUM_MAX_WORKERS;
+    config->autovacuum_naptime = DEFAULT_AUTOVACUUM_NAPTIME;
+    config->autovacuum_vacuum_threshold = DEFAULT_AUTOVACUUM_VACUUM_THRESHOLD;
+    config->autovacuum_vacuum_scale_factor = DEFAULT_AUTOVACUUM_VACUUM_SCALE_FACTOR;
+    config->autovacuum_vacuum_cost_delay = DEFAULT_AUTOVACUUM_VACUUM_COST_DELAY;
+    config->autovacuum_vacuum_cost_limit = DEFAULT_VACUUM_COST_LIMIT;
+    config->vacuum_cost_delay = 0;
+    config->vacuum_cost_limit = DEFAULT_VACUUM_COST_LIMIT;
+}
+
+// 去掉首尾空白和引号
+static char* trim(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    if (end - s >= 2 && (*s == '\'' || *s == '"') && end[-1] == *s) {
+        end[-1] = '\0';
+        s++;
+    }
+    return s;
+}
+
+static bool parse_bool(const char* value, bool* out) {
+    if (!strcasecmp(value, "on") || !strcasecmp(value, "true") ||
+        !strcasecmp(value, "yes") || !strcmp(value, "1")) {
+        *out = true;
+        return true;
+    }
+    if (!strcasecmp(value, "off") || !strcasecmp(value, "false") ||
+        !strcasecmp(value, "no") || !strcmp(value, "0")) {
+        *out = false;
+        return true;
+    }
+    return false;
+}
+
+// 解析页数：纯数字表示页数，带 kB/MB/GB 后缀时按 PAGE_SIZE 换算
+static bool parse_pages(const char* value, int* out) {
+    char* end;
+    long long n = strtoll(value, &end, 10);
+    if (end == value || n < 0) return false;
+    while (isspace((unsigned char)*end)) end++;
+
+    long long bytes;
+    if (*end == '\0') {
+        *out = (int)n;
+        return true;
+    } else if (!strcasecmp(end, "kB")) {
+        bytes = n * 1024LL;
+    } else if (!strcasecmp(end, "MB")) {
+        bytes = n * 1024LL * 1024LL;
+    } else if (!strcasecmp(end, "GB")) {
+        bytes = n * 1024LL * 1024LL * 1024LL;
+    } else {
+        return false;
+    }
+    long long pages = bytes / PAGE_SIZE;
+    if (pages > 0x7FFFFFFF) return false;
+    *out = (int)pages;
+    return true;
+}
+
+// 解析毫秒数：纯数字或带 ms/s 后缀
+static bool parse_ms(const char* value, int* out) {
+    char* end;
+    long n = strtol(value, &end, 10);
+    if (end == value || n < 0) return false;
+    while (isspace((unsigned char)*end)) end++;
+
+    if (*end == '\0' || !strcasecmp(end, "ms")) {
+        *out = (int)n;
+    } else if (!strcasecmp(end, "s")) {
+        *out = (int)(n * 1000);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parse_int(const char* value, int* out) {
+    char* end;
+    long n = strtol(value, &end, 10);
+    if (end == value || n < 0) return false;
+    while (isspace((unsigned char)*end)) end++;
+    if (*end != '\0') return false;
+    *out = (int)n;
+    return true;
+}
+
+static bool parse_real(const char* value, double* out) {
+    char* end;
+    double d = strtod(value, &end);
+    if (end == value || d < 0) return false;
+    while (isspace((unsigned char)*end)) end++;
+    if (*end != '\0') return false;
+    *out = d;
+    return true;
+}
+
+bool config_set_option(MiniDBConfig* config, const char* name, const char* value) {
+    if (!strcmp(name, "shared_buffers")) {
+        int pages;
+        if (!parse_pages(value, &pages)) return false;
+        config->shared_buffers = pages < MIN_SHARED_BUFFERS ? MIN_SHARED_BUFFERS : pages;
+        return true;
+    }
+    if (!strcmp(name, "huge_pages")) {
+        bool b;
+        if (!strcasecmp(value, "try")) {
+            config->huge_pages = HUGE_PAGES_TRY;
+        } else if (parse_bool(value, &b)) {
+            config->huge_pages = b ? HUGE_PAGES_ON : HUGE_PAGES_OFF;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (!strcmp(name, "bgwriter_delay")) {
+        int ms;
+        if (!parse_ms(value, &ms) || ms < 10) return false;
+        config->bgwriter_delay = ms;
+        return true;
+    }
+    if (!strcmp(name, "bgwriter_lru_maxpages")) {
+        return parse_int(value, &config->bgwriter_lru_maxpages);
+    }
+    if (!strcmp(name, "max_files_per_process")) {
+        return parse_int(value, &config->max_files_per_process);
+    }
+    if (!strcmp(name, "direct_io")) {
+        return parse_bool(value, &config->direct_io);
+    }
+    if (!strcmp(name, "io_method")) {
+        if (!strcasecmp(value, "io_uring")) {
+            config->io_method = IO_METHOD_IO_URING;
+        } else if (!strcasecmp(value, "sync")) {
+            config->io_method = IO_METHOD_SYNC;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (!strcmp(name, "effective_io_concurrency")) {
+        return parse_int(value, &config->effective_io_concurrency);
+    }
+    if (!strcmp(name, "mmap_scans")) {
+        return parse_bool(value, &config->mmap_scans);
+    }
+    if (!strcmp(name, "autoprewarm")) {
+        return parse_bool(value, &config->autoprewarm);
+    }
+    if (!strcmp(name, "autoprewarm_interval")) {
+        return parse_ms(value, &config->autoprewarm_interval);
+    }
+    if (!strcmp(name, "autovacuum")) {
+        return parse_bool(value, &config->autovacuum);
+    }
+    if (!strcmp(name, "autovacuum_max_workers")) {
+        int n;
+        if (!parse_int(value, &n) || n < 1) return false;
+        config->autovacuum_max_workers = n;
+        return true;
+    }
+    if (!strcmp(name, "autovacuum_naptime")) {
+        int ms;
+        if (!parse_ms(value, &ms) || ms < 1000) return false;
+        config->autovacuum_naptime = ms;
+        return true;
+    }
+    if (!strcmp(name, "autovacuum_vacuum_threshold")) {
+        return parse_int(value, &config->autovacuum_vacuum_threshold);
+    }
+    if (!strcmp(name, "autovacuum_vacuum_scale_factor")) {
+        return parse_real(value, &config->autovacuum_vacuum_scale_factor);
+    }
+    if (!strcmp(name, "autovacuum_vacuum_cost_delay")) {
+        return parse_ms(value, &config->autovacuum_vacuum_cost_delay);
+    }
+    if (!strcmp(name, "autovacuum_vacuum_cost_limit")) {
+        int n;
+        if (!parse_int(value, &n) || n < 1) return false;
+        config->autovacuum_vacuum_cost_limit = n;
+        return true;
+    }
+    if (!strcmp(name, "vacuum_cost_delay")) {
+        return parse_ms(value, &config->vacuum_cost_delay);
+    }
+    if (!strcmp(name, "vacuum_cost_limit")) {
+        int n;
+        if (!parse_int(value, &n) || n < 1) return false;
+        config->vacuum_cost_limit = n;
+        return true;
+    }
+    return false;
+}
+
+bool config_load_file(MiniDBConfig* config, const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return false;
+
+    char line[512];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char* s = trim(line);
+        if (*s == '\0') continue;
+
+        char* eq = strchr(s, '=');
+        if (!eq) {
+            fprintf(stderr, "%s:%d: syntax error, expected name = value\n", path, lineno);
+            continue;
+        }
+        *eq = '\0';
+        char* name = trim(s);
+        char* value = trim(eq + 1);
+        if (!config_set_option(config, name, value)) {
+            fprintf(stderr, "%s:%d: invalid setting %s = %s\n", path, lineno, name, value);
+        }
+    }
+
+    fclose(fp);
+    return true;
+}
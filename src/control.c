@@ -0,0 +1,79 @@
+#include "control.h"
+#include "types.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+
+static uint32_t control_file_crc(const ControlFileData* control) {
+    return crc32(0, (const Bytef*)control, offsetof(ControlFileData, crc));
+}
+
+bool control_file_read(const char* data_dir, ControlFileData* control) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", data_dir, CONTROL_FILE);
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+    size_t n = fread(control, sizeof(ControlFileData), 1, fp);
+    fclose(fp);
+    if (n != 1 || control->magic != CONTROL_MAGIC || control->crc != control_file_crc(control)) {
+        errno = EINVAL;  // 与文件不存在 (ENOENT) 区分
+        return false;
+    }
+    return true;
+}
+
+bool control_file_write(const char* data_dir) {
+    ControlFileData control = {
+        .magic = CONTROL_MAGIC,
+        .version = CONTROL_VERSION,
+        .blcksz = PAGE_SIZE,
+    };
+    control.crc = control_file_crc(&control);
+
+    char path[512], tmp_path[520];
+    snprintf(path, sizeof(path), "%s/%s", data_dir, CONTROL_FILE);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) return false;
+    bool ok = fwrite(&control, sizeof(control), 1, fp) == 1;
+    if (fclose(fp) != 0 || !ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+bool control_file_startup(const char* data_dir) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", data_dir, CONTROL_FILE);
+
+    ControlFileData control;
+    if (!control_file_read(data_dir, &control)) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Error: control file %s is corrupt\n", path);
+            return false;
+        }
+        // 新数据目录：记录本构建的页大小
+        if (!control_file_write(data_dir)) {
+            fprintf(stderr, "Error: could not write control file %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    if (control.blcksz != PAGE_SIZE) {
+        fprintf(stderr, "Error: database was initialized with page size %u, "
+                "but the server was built with page size %d\n", control.blcksz, PAGE_SIZE);
+        return false;
+    }
+    if (control.version != CONTROL_VERSION) {
+        fprintf(stderr, "Error: database page format version %u is not supported (expected %d)\n",
+                control.version, CONTROL_VERSION);
+        return false;
+    }
+    return true;
+}
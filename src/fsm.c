@@ -0,0 +1,271 @@
+#include "fsm.h"
+#include "page.h"
+#include "smgr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define FSM_MAGIC 0x46534D31  // "FSM1"
+#define MAX_FSM_RELS MAX_SMGR_RELS
+
+// .fsm 文件头，其后是 nblocks 个叶子档位
+typedef struct FSMFileHeader {
+    uint32_t magic;
+    uint32_t nblocks;
+} FSMFileHeader;
+
+// 已打开的映射，registry_lock 保护
+static struct {
+    FreeSpaceMap* maps[MAX_FSM_RELS];
+    int nmaps;
+    LWLock registry_lock;
+} fsm_registry;
+
+static pthread_once_t fsm_registry_once = PTHREAD_ONCE_INIT;
+
+static void fsm_registry_init(void) {
+    LWLockInit(&fsm_registry.registry_lock, TRANCHE_FSM_LOCK);
+}
+
+static uint8_t fsm_space_to_cat(size_t free_space) {
+    size_t cat = free_space / FSM_CAT_STEP;
+    return cat >= FSM_CATEGORIES ? FSM_CATEGORIES - 1 : (uint8_t)cat;
+}
+
+// 请求的档位向上取整，保证找到的页空间足够；至少为 1，不返回已满的页
+static uint8_t fsm_space_needed_to_cat(size_t needed) {
+    size_t cat = (needed + FSM_CAT_STEP - 1) / FSM_CAT_STEP;
+    if (cat == 0) cat = 1;
+    return cat >= FSM_CATEGORIES ? FSM_CATEGORIES - 1 : (uint8_t)cat;
+}
+
+static uint8_t fsm_max(uint8_t a, uint8_t b) {
+    return a > b ? a : b;
+}
+
+// 由叶子重建内部节点
+static void fsm_rebuild(FreeSpaceMap* fsm) {
+    for (int i = fsm->nleaves - 1; i >= 1; i--) {
+        fsm->tree[i] = fsm_max(fsm->tree[2 * i], fsm->tree[2 * i + 1]);
+    }
+}
+
+// 扩大叶子数以容纳 page_id，调用方需以排他模式持有 fsm->lock
+static bool fsm_extend(FreeSpaceMap* fsm, PageID page_id) {
+    if ((int64_t)page_id < fsm->nleaves) {
+        return true;
+    }
+    int nleaves = fsm->nleaves > 0 ? fsm->nleaves : FSM_MIN_LEAVES;
+    while ((int64_t)page_id >= nleaves) {
+        nleaves <<= 1;
+    }
+    uint8_t* tree = calloc(2 * (size_t)nleaves, 1);
+    if (!tree) return false;
+    if (fsm->tree) {
+        memcpy(tree + nleaves, fsm->tree + fsm->nleaves, fsm->nblocks);
+        free(fsm->tree);
+    }
+    fsm->tree = tree;
+    fsm->nleaves = nleaves;
+    fsm_rebuild(fsm);
+    return true;
+}
+
+// 设置叶子并向上更新，父节点不变时提前结束；调用方需以排他模式持有 fsm->lock
+static void fsm_set_cat(FreeSpaceMap* fsm, PageID page_id, uint8_t cat) {
+    if (!fsm_extend(fsm, page_id)) return;
+    if (page_id >= fsm->nblocks) {
+        fsm->nblocks = page_id + 1;
+    }
+    int idx = fsm->nleaves + (int)page_id;
+    if (fsm->tree[idx] == cat) return;
+    fsm->tree[idx] = cat;
+    fsm->dirty = true;
+    for (idx >>= 1; idx >= 1; idx >>= 1) {
+        uint8_t value = fsm_max(fsm->tree[2 * idx], fsm->tree[2 * idx + 1]);
+        if (fsm->tree[idx] == value) break;
+        fsm->tree[idx] = value;
+    }
+}
+
+// 从根向下找最左边满足档位的叶子；调用方需持有 fsm->lock
+static PageID fsm_search(const FreeSpaceMap* fsm, uint8_t cat) {
+    if (fsm->nleaves == 0 || fsm->tree[1] < cat) {
+        return INVALID_PAGE_ID;
+    }
+    int idx = 1;
+    while (idx < fsm->nleaves) {
+        idx = fsm->tree[2 * idx] >= cat ? 2 * idx : 2 * idx + 1;
+    }
+    return (PageID)(idx - fsm->nleaves);
+}
+
+// 从 .fsm 文件加载叶子，返回文件中记录的页数
+static PageID fsm_load_file(FreeSpaceMap* fsm) {
+    FILE* fp = fopen(fsm->path, "rb");
+    if (!fp) return 0;
+
+    FSMFileHeader header;
+    PageID nblocks = 0;
+    if (fread(&header, sizeof(header), 1, fp) == 1 && header.magic == FSM_MAGIC &&
+        fsm_extend(fsm, header.nblocks > 0 ? header.nblocks - 1 : 0)) {
+        nblocks = (PageID)fread(fsm->tree + fsm->nleaves, 1, header.nblocks, fp);
+    }
+    fclose(fp);
+    return nblocks;
+}
+
+/*
+ * 新建映射：先读 .fsm 文件，文件之后扩展出的页（检查点前崩溃、或尚无 .fsm 文件）
+ * 直接读表文件计算空闲空间，不经缓冲池。
+ */
+static FreeSpaceMap* fsm_create(uint32_t rel_oid, const char* table_path) {
+    FreeSpaceMap* fsm = calloc(1, sizeof(FreeSpaceMap));
+    if (!fsm) return NULL;
+    fsm->rel_oid = rel_oid;
+    snprintf(fsm->path, sizeof(fsm->path), "%s%s", table_path, FSM_FILE_SUFFIX);
+    LWLockInit(&fsm->lock, TRANCHE_FSM_LOCK);
+
+    PageID nblocks = fsm_load_file(fsm);
+    fsm->nblocks = nblocks;
+    fsm_rebuild(fsm);
+
+    PageID table_blocks = smgr_nblocks(rel_oid);
+    if (table_blocks > nblocks) {
+        Page* page = malloc(sizeof(Page));
+        for (PageID page_id = nblocks; page && page_id < table_blocks; page_id++) {
+            if (smgr_read(rel_oid, page_id, page)) {
+                size_t free_space = page_is_new(page) ? PAGE_EMPTY_FREE_SPACE : page_free_space(page);
+                fsm_set_cat(fsm, page_id, fsm_space_to_cat(free_space));
+            }
+        }
+        free(page);
+    }
+    return fsm;
+}
+
+FreeSpaceMap* fsm_open(uint32_t rel_oid, const char* table_path) {
+    pthread_once(&fsm_registry_once, fsm_registry_init);
+
+    LWLockAcquireShared(&fsm_registry.registry_lock);
+    for (int i = 0; i < fsm_registry.nmaps; i++) {
+        if (fsm_registry.maps[i]->rel_oid == rel_oid) {
+            FreeSpaceMap* fsm = fsm_registry.maps[i];
+            LWLockRelease(&fsm_registry.registry_lock);
+            return fsm;
+        }
+    }
+    LWLockRelease(&fsm_registry.registry_lock);
+
+    LWLockAcquireExclusive(&fsm_registry.registry_lock);
+    for (int i = 0; i < fsm_registry.nmaps; i++) {
+        if (fsm_registry.maps[i]->rel_oid == rel_oid) {
+            FreeSpaceMap* fsm = fsm_registry.maps[i];
+            LWLockRelease(&fsm_registry.registry_lock);
+            return fsm;
+        }
+    }
+    FreeSpaceMap* fsm = NULL;
+    if (fsm_registry.nmaps < MAX_FSM_RELS) {
+        fsm = fsm_create(rel_oid, table_path);
+        if (fsm) {
+            fsm_registry.maps[fsm_registry.nmaps++] = fsm;
+        }
+    }
+    LWLockRelease(&fsm_registry.registry_lock);
+    return fsm;
+}
+
+PageID GetPageWithFreeSpace(FreeSpaceMap* fsm, size_t needed) {
+    LWLockAcquireShared(&fsm->lock);
+    PageID page_id = fsm_search(fsm, fsm_space_needed_to_cat(needed));
+    LWLockRelease(&fsm->lock);
+    return page_id;
+}
+
+void RecordPageWithFreeSpace(FreeSpaceMap* fsm, PageID page_id, size_t free_space) {
+    LWLockAcquireExclusive(&fsm->lock);
+    fsm_set_cat(fsm, page_id, fsm_space_to_cat(free_space));
+    LWLockRelease(&fsm->lock);
+}
+
+PageID RecordAndGetPageWithFreeSpace(FreeSpaceMap* fsm, PageID old_page, size_t old_free, size_t needed) {
+    LWLockAcquireExclusive(&fsm->lock);
+    fsm_set_cat(fsm, old_page, fsm_space_to_cat(old_free));
+    PageID page_id = fsm_search(fsm, fsm_space_needed_to_cat(needed));
+    LWLockRelease(&fsm->lock);
+    return page_id;
+}
+
+// 截掉的页的空闲空间清零，写回时文件随之变短
+void FreeSpaceMapTruncateRel(FreeSpaceMap* fsm, PageID nblocks) {
+    LWLockAcquireExclusive(&fsm->lock);
+    if (nblocks < fsm->nblocks) {
+        memset(fsm->tree + fsm->nleaves + nblocks, 0, fsm->nblocks - nblocks);
+        fsm->nblocks = nblocks;
+        fsm->dirty = true;
+        fsm_rebuild(fsm);
+    }
+    LWLockRelease(&fsm->lock);
+}
+
+// 写回一个映射：先写临时文件再改名
+static void fsm_sync(FreeSpaceMap* fsm) {
+    LWLockAcquireShared(&fsm->lock);
+    if (!fsm->dirty) {
+        LWLockRelease(&fsm->lock);
+        return;
+    }
+    FSMFileHeader header = { .magic = FSM_MAGIC, .nblocks = fsm->nblocks };
+    uint8_t* leaves = malloc(header.nblocks ? header.nblocks : 1);
+    if (!leaves) {
+        LWLockRelease(&fsm->lock);
+        return;
+    }
+    memcpy(leaves, fsm->tree + fsm->nleaves, header.nblocks);
+    LWLockRelease(&fsm->lock);
+
+    char tmp_path[sizeof(fsm->path) + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", fsm->path);
+    FILE* fp = fopen(tmp_path, "wb");
+    bool ok = fp != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(leaves, 1, header.nblocks, fp) == header.nblocks;
+        ok = fclose(fp) == 0 && ok;
+    }
+    if (ok && rename(tmp_path, fsm->path) == 0) {
+        // 写回期间有新的修改时保留脏标记，下次检查点再写
+        LWLockAcquireExclusive(&fsm->lock);
+        if (fsm->nblocks == header.nblocks &&
+            memcmp(leaves, fsm->tree + fsm->nleaves, header.nblocks) == 0) {
+            fsm->dirty = false;
+        }
+        LWLockRelease(&fsm->lock);
+    } else {
+        fprintf(stderr, "fsm: could not write %s: %s\n", fsm->path, strerror(errno));
+        remove(tmp_path);
+    }
+    free(leaves);
+}
+
+void fsm_sync_all() {
+    pthread_once(&fsm_registry_once, fsm_registry_init);
+    LWLockAcquireShared(&fsm_registry.registry_lock);
+    for (int i = 0; i < fsm_registry.nmaps; i++) {
+        fsm_sync(fsm_registry.maps[i]);
+    }
+    LWLockRelease(&fsm_registry.registry_lock);
+}
+
+void fsm_shutdown() {
+    pthread_once(&fsm_registry_once, fsm_registry_init);
+    LWLockAcquireExclusive(&fsm_registry.registry_lock);
+    for (int i = 0; i < fsm_registry.nmaps; i++) {
+        free(fsm_registry.maps[i]->tree);
+        free(fsm_registry.maps[i]);
+    }
+    fsm_registry.nmaps = 0;
+    LWLockRelease(&fsm_registry.registry_lock);
+}
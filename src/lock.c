@@ -1,9 +1,13 @@
 
 #include "minidb.h"
 #include "lock.h"
+#include <assert.h>
 
 #define LWLOCK_EXCLUSIVE 0x1
 #define LWLOCK_SHARED_MASK 0xFFFE  // 共享锁位
+#define LWLOCK_SHARED_ONE 0x2      // 每个共享持有者占用的计数
+
+RowLockTable global_row_locks;
  proclist_init(proclist_head *list) {
     list->head = list->tail = NULL;
 }
@@ -29,6 +33,7 @@ PGPROC* proclist_pop_front(proclist_head *list) {
 
 void LWLockInit(LWLock *lock, uint16_t tranche_id) {
     atomic_store(&lock->state, 0);
+    atomic_store(&lock->nwaiters, 0);
     proclist_init(&lock->waiters);
     lock->tranche = tranche_id;
 }
@@ -37,15 +42,50 @@ void LWLockInit(LWLock *lock, uint16_t tranche_id) {
 bool LWLockAcquireExclusive(LWLock *lock) {
    // printf("LWLockAcquireExclusive ");
     uint32_t expected = 0;
-    while (!atomic_compare_exchange_weak(&lock->state, &expected, 1)) {
+    if (atomic_compare_exchange_strong(&lock->state, &expected, LWLOCK_EXCLUSIVE)) {
+        return true;
+    }
+    atomic_fetch_add(&lock->nwaiters, 1);
+    do {
         expected = 0;
         sched_yield(); // or sleep briefly
-    }
+    } while (!atomic_compare_exchange_weak(&lock->state, &expected, LWLOCK_EXCLUSIVE));
+    atomic_fetch_sub(&lock->nwaiters, 1);
     return true;
 }
 
+int LWLockWaiterCount(LWLock *lock) {
+    return (int)atomic_load(&lock->nwaiters);
+}
+
+// 共享模式：没有排他持有者时共享计数 +1，可与其他共享持有者并存
+bool LWLockAcquireShared(LWLock *lock) {
+    uint32_t expected = atomic_load(&lock->state);
+    while (true) {
+        if (expected & LWLOCK_EXCLUSIVE) {
+            sched_yield();
+            expected = atomic_load(&lock->state);
+            continue;
+        }
+        if (atomic_compare_exchange_weak(&lock->state, &expected, expected + LWLOCK_SHARED_ONE)) {
+            return true;
+        }
+    }
+}
+
+bool LWLockAcquire(LWLock *lock, LWLockMode mode) {
+    return mode == LW_SHARED ? LWLockAcquireShared(lock) : LWLockAcquireExclusive(lock);
+}
+
 void LWLockRelease(LWLock *lock) {
-    atomic_store(&lock->state, 0);
+    // 排他持有期间不会有共享持有者，state 恰为 LWLOCK_EXCLUSIVE
+    uint32_t state = atomic_load(&lock->state);
+    if (state & LWLOCK_EXCLUSIVE) {
+        atomic_store(&lock->state, 0);
+    } else {
+        assert(state >= LWLOCK_SHARED_ONE);
+        atomic_fetch_sub(&lock->state, LWLOCK_SHARED_ONE);
+    }
 }
 /*
 void LWLockAcquireExclusive(LWLock *lock, PGPROC *myproc) {
@@ -6,6 +6,7 @@
 #include <time.h>
 #include <parser.h>
 #include "executor.h"
+#include "memctx.h"
 // 示例程序
 int main() {
     MiniDB db;
@@ -20,6 +21,7 @@ int main() {
     //session.client_fd = client_fd;
     session.db = &db;
     session.current_xid = INVALID_XID;
+    session.memctx = NULL;
     /*      */
     // ================== 事务 1 ==================
     printf("\n===== Transaction 1: Create Table =====\n");
@@ -73,11 +75,11 @@ int main() {
     Tuple user1 = {0};
     uint8_t col_count = 3;
     user1.col_count = col_count;
-    user1.columns = (Column *)malloc(col_count * sizeof(Column));
+    user1.columns = (Column *)palloc(col_count * sizeof(Column));
 
 
     user1.columns[0].type = INT4_TYPE; user1.columns[0].value.int_val = 1;
-    user1.columns[1].type = TEXT_TYPE; user1.columns[1].value.str_val = strdup("Tom");
+    user1.columns[1].type = TEXT_TYPE; user1.columns[1].value.str_val = pstrdup("Tom");
     user1.columns[2].type = INT4_TYPE; user1.columns[2].value.int_val = 30;
 
     if (db_insert(&db, "users", &user1,session) < 0) {
@@ -86,15 +88,15 @@ int main() {
         return 1;
     }
     printf("Inserted user1\n");
-    free(user1.columns[1].value.str_val);
-    free(user1.columns);
+    pfree(user1.columns[1].value.str_val);
+    pfree(user1.columns);
   
     // 插入用户2
     Tuple user2 = {0};
     user2.col_count = col_count;
-    user2.columns = (Column *)malloc(col_count * sizeof(Column));
+    user2.columns = (Column *)palloc(col_count * sizeof(Column));
     user2.columns[0].type = INT4_TYPE; user2.columns[0].value.int_val = 2;
-    user2.columns[1].type = TEXT_TYPE; strcpy(user2.columns[1].value.str_val, "Jack");
+    user2.columns[1].type = TEXT_TYPE; user2.columns[1].value.str_val = pstrdup("Jack");
     user2.columns[2].type = INT4_TYPE; user2.columns[2].value.int_val = 25;
     
     if (db_insert(&db, "users", &user2,session) < 0) {
@@ -103,8 +105,8 @@ int main() {
         return 1;
     }
     printf("Inserted user2\n");
-  // free(user2.columns[1].value.str_val);
-//free(user2.columns);
+    pfree(user2.columns[1].value.str_val);
+    pfree(user2.columns);
    
 
     // 打印中间状态
@@ -229,10 +231,10 @@ stmt.values[0]=strdup("456");
     //int col_count=3;
     Tuple user3 = {0};
     user3.col_count = col_count;
-    user3.columns = (Column *)malloc(col_count * sizeof(Column));
+    user3.columns = (Column *)palloc(col_count * sizeof(Column));
 
     user3.columns[0].type = INT4_TYPE; user3.columns[0].value.int_val = 3;
-    user3.columns[1].type = TEXT_TYPE; strcpy(user3.columns[1].value.str_val, "Rollback_user");
+    user3.columns[1].type = TEXT_TYPE; user3.columns[1].value.str_val = pstrdup("Rollback_user");
     user3.columns[2].type = INT4_TYPE; user3.columns[2].value.int_val = 35;
     
     if (db_insert(&db, "users", &user3,session) < 0) {
@@ -241,6 +243,8 @@ stmt.values[0]=strdup("456");
         return 1;
     }
     printf("Inserted user3 (will be rolled back)\n");
+    pfree(user3.columns[1].value.str_val);
+    pfree(user3.columns);
     
     // 回滚事务
     if (session_rollback_transaction(&db,&session)) {
@@ -286,8 +290,8 @@ stmt.values[0]=strdup("456");
 
      
     
-    // 创建检查点
-    db_create_checkpoint(&db);
+    // 关闭数据库（写回所有脏页并创建检查点）
+    close_db(&db);
     
     // 打印最终状态
     printf("\nFinal database status:\n");
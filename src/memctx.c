@@ -0,0 +1,187 @@
+#include "memctx.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMCTX_ALIGN          16
+#define MEMCTX_ALIGNED(x)     (((x) + MEMCTX_ALIGN - 1) & ~(size_t)(MEMCTX_ALIGN - 1))
+#define ALLOC_BLOCK_INIT_SIZE (8 * 1024)      // 与上下文一起分配的第一块
+#define ALLOC_BLOCK_MAX_SIZE  (1024 * 1024)   // 之后的块逐次翻倍，不超过此值
+#define ALLOC_CHUNK_LIMIT     (ALLOC_BLOCK_INIT_SIZE / 4)  // 更大的分配单独占一块
+
+_Thread_local MemoryContext CurrentMemoryContext = NULL;
+
+// 一块从 malloc 得到的内存，块头之后的空间按顺序切分
+typedef struct MemoryBlock {
+    struct MemoryBlock* next;
+    char* free_ptr;    // 下一个分配的位置
+    char* end;
+} MemoryBlock;
+
+// 每个分配之前的头，pfree 据此判断内存来自 malloc 还是上下文
+typedef struct MemoryChunk {
+    MemoryContext context;   // NULL 表示单独 malloc
+    size_t size;
+} MemoryChunk;
+
+#define BLOCK_HDRSZ MEMCTX_ALIGNED(sizeof(MemoryBlock))
+#define CHUNK_HDRSZ MEMCTX_ALIGNED(sizeof(MemoryChunk))
+
+struct MemoryContextData {
+    const char* name;
+    MemoryContext parent;
+    MemoryContext first_child;
+    MemoryContext prev_sibling;
+    MemoryContext next_sibling;
+    MemoryBlock* blocks;      // 链首是正在切分的块
+    MemoryBlock* keeper;      // 与上下文一起分配，重置时保留
+    size_t next_block_size;
+    size_t mem_allocated;     // 本上下文已申请的块大小之和
+};
+
+#define CONTEXT_HDRSZ MEMCTX_ALIGNED(sizeof(struct MemoryContextData))
+
+static void block_init(MemoryBlock* block, size_t size) {
+    block->free_ptr = (char*)block + BLOCK_HDRSZ;
+    block->end = (char*)block + size;
+}
+
+MemoryContext MemoryContextCreate(MemoryContext parent, const char* name) {
+    MemoryContext context = malloc(CONTEXT_HDRSZ + ALLOC_BLOCK_INIT_SIZE);
+    if (!context) return NULL;
+
+    context->name = name;
+    context->parent = parent;
+    context->first_child = NULL;
+    context->prev_sibling = NULL;
+    context->next_sibling = NULL;
+    context->keeper = (MemoryBlock*)((char*)context + CONTEXT_HDRSZ);
+    block_init(context->keeper, ALLOC_BLOCK_INIT_SIZE);
+    context->keeper->next = NULL;
+    context->blocks = context->keeper;
+    context->next_block_size = ALLOC_BLOCK_INIT_SIZE * 2;
+    context->mem_allocated = ALLOC_BLOCK_INIT_SIZE;
+
+    if (parent) {
+        context->next_sibling = parent->first_child;
+        if (parent->first_child) parent->first_child->prev_sibling = context;
+        parent->first_child = context;
+    }
+    return context;
+}
+
+// 释放除 keeper 以外的块，keeper 清空后重新作为链首
+static void context_free_blocks(MemoryContext context) {
+    MemoryBlock* block = context->blocks;
+    while (block) {
+        MemoryBlock* next = block->next;
+        if (block != context->keeper) free(block);
+        block = next;
+    }
+    block_init(context->keeper, ALLOC_BLOCK_INIT_SIZE);
+    context->keeper->next = NULL;
+    context->blocks = context->keeper;
+    context->next_block_size = ALLOC_BLOCK_INIT_SIZE * 2;
+    context->mem_allocated = ALLOC_BLOCK_INIT_SIZE;
+}
+
+void MemoryContextReset(MemoryContext context) {
+    if (!context) return;
+    while (context->first_child) {
+        MemoryContextDelete(context->first_child);
+    }
+    context_free_blocks(context);
+}
+
+void MemoryContextDelete(MemoryContext context) {
+    if (!context) return;
+    MemoryContextReset(context);
+
+    if (context->parent) {
+        if (context->prev_sibling) {
+            context->prev_sibling->next_sibling = context->next_sibling;
+        } else {
+            context->parent->first_child = context->next_sibling;
+        }
+        if (context->next_sibling) {
+            context->next_sibling->prev_sibling = context->prev_sibling;
+        }
+    }
+    if (CurrentMemoryContext == context) {
+        CurrentMemoryContext = context->parent;
+    }
+    free(context);
+}
+
+void* MemoryContextAlloc(MemoryContext context, size_t size) {
+    MemoryChunk* chunk;
+    if (!context) {
+        chunk = malloc(CHUNK_HDRSZ + size);
+        if (!chunk) return NULL;
+        chunk->context = NULL;
+        chunk->size = size;
+        return (char*)chunk + CHUNK_HDRSZ;
+    }
+
+    size_t need = CHUNK_HDRSZ + MEMCTX_ALIGNED(size);
+    MemoryBlock* block = context->blocks;
+    if (need > ALLOC_CHUNK_LIMIT) {
+        // 大分配单独一块，接在链首之后，不影响正在切分的块
+        block = malloc(BLOCK_HDRSZ + need);
+        if (!block) return NULL;
+        block_init(block, BLOCK_HDRSZ + need);
+        block->next = context->blocks->next;
+        context->blocks->next = block;
+        context->mem_allocated += BLOCK_HDRSZ + need;
+    } else if ((size_t)(block->end - block->free_ptr) < need) {
+        size_t block_size = context->next_block_size;
+        block = malloc(block_size);
+        if (!block) return NULL;
+        block_init(block, block_size);
+        block->next = context->blocks;
+        context->blocks = block;
+        context->mem_allocated += block_size;
+        if (context->next_block_size < ALLOC_BLOCK_MAX_SIZE) context->next_block_size *= 2;
+    }
+
+    chunk = (MemoryChunk*)block->free_ptr;
+    block->free_ptr += need;
+    chunk->context = context;
+    chunk->size = size;
+    return (char*)chunk + CHUNK_HDRSZ;
+}
+
+void* palloc(size_t size) {
+    return MemoryContextAlloc(CurrentMemoryContext, size);
+}
+
+void* palloc0(size_t size) {
+    void* ptr = palloc(size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+char* pstrdup(const char* str) {
+    size_t len = strlen(str);
+    char* copy = palloc(len + 1);
+    if (copy) memcpy(copy, str, len + 1);
+    return copy;
+}
+
+void pfree(void* ptr) {
+    if (!ptr) return;
+    MemoryChunk* chunk = (MemoryChunk*)((char*)ptr - CHUNK_HDRSZ);
+    if (!chunk->context) {
+        free(chunk);
+    }
+    // 上下文中的分配等重置时回收
+}
+
+size_t MemoryContextMemAllocated(MemoryContext context) {
+    if (!context) return 0;
+    size_t total = context->mem_allocated;
+    for (MemoryContext child = context->first_child; child; child = child->next_sibling) {
+        total += MemoryContextMemAllocated(child);
+    }
+    return total;
+}
@@ -11,14 +11,43 @@
 #include "lock.h"
 #include "executor.h"
 #include "txmgr.h"
+#include "bgwriter.h"
+#include "smgr.h"
+#include "prewarm.h"
+#include "fsm.h"
+#include "control.h"
+#include "vm.h"
+#include "prune.h"
+#include "vacuum.h"
+#include "toast.h"
+#include "memctx.h"
 
 const char *DATADIR=NULL;
-// 初始化数据库
+// 初始化数据库：参数取自数据目录下的 minidb.conf（不存在则用默认值）
 void init_db(MiniDB *db, const char *data_dir) {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+
+    char conf_path[512];
+    snprintf(conf_path, sizeof(conf_path), "%s/%s", data_dir, CONFIG_FILE);
+    config_load_file(&config, conf_path);
+
+    init_db_with_config(db, data_dir, &config);
+}
+
+// 以给定参数初始化数据库（忽略配置文件）
+void init_db_with_config(MiniDB *db, const char *data_dir, const MiniDBConfig *config) {
+    db_config = *config;
+
     // 设置数据目录
     strncpy(db->data_dir, data_dir, sizeof(db->data_dir));
     mkdir(data_dir, 0755);
     DATADIR=data_dir;
+
+    // 新数据目录写入控制文件，已有的检查页大小与本构建一致
+    if (!control_file_startup(data_dir)) {
+        exit(1);
+    }
     
     // 初始化系统目录
     init_system_catalog(&db->catalog,db->data_dir);
@@ -30,13 +59,31 @@ void init_db(MiniDB *db, const char *data_dir) {
     db->current_xid = INVALID_XID;
     db->next_page_id = 0;  // 如果是新数据库
     
-    init_page_cache();
+    smgr_init(db_config.max_files_per_process, db_config.direct_io, db_config.io_method);
+    if (!init_page_cache(db_config.shared_buffers, db_config.huge_pages)) {
+        fprintf(stderr, "Error: failed to allocate buffer pool of %d pages\n", db_config.shared_buffers);
+        exit(1);
+    }
+    bgwriter_start(db_config.bgwriter_delay, db_config.bgwriter_lru_maxpages);
+    // 预热线程按文件名找到表的 OID 再读页，先把所有表登记到存储管理层
+    for (int i = 0; i < db->catalog.table_count; i++) {
+        const TableMeta *meta = &db->catalog.tables[i];
+        char fullpath[256];
+        snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
+        smgr_open(meta->oid, fullpath);
+    }
+    if (db_config.autoprewarm) {
+        autoprewarm_start(data_dir, db_config.autoprewarm_interval);
+    }
     init_row_lock_table();
     // 初始化WAL
     init_wal();
     
     // 从WAL恢复
    // recover_from_wal(db);
+    if (db_config.autovacuum) {
+        autovacuum_start(db, db_config.autovacuum_max_workers, db_config.autovacuum_naptime);
+    }
 }
 
 
@@ -174,32 +221,42 @@ int session_rollback_transaction(MiniDB *db, Session* session) {
         char fullpath[256];
         snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
 
-        for (PageID page_id = 0; page_id < db->next_page_id; page_id++) {
-            Page* page = page_cache_load_or_fetch(page_id, fullpath);
-            if (!page) continue;
+        VisibilityMap* vm = vm_open(meta->oid, fullpath);
+        ReadStream stream;
+        Buffer buf;
+        BufferAccessStrategy strategy = GetScanAccessStrategy(meta->last_page - meta->first_page + 1);
+        read_stream_begin(&stream, meta->oid, fullpath, meta->first_page, meta->last_page,
+                          db_config.effective_io_concurrency, strategy);
+        while (read_stream_next(&stream, &buf, NULL)) {
+            if (!BufferIsValid(buf)) continue;
+            Page* page = BufferGetPage(buf);
 
             int modified = 0;
-            LWLockAcquireExclusive(&page->lock);
+            LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
             for (int j = 0; j < page->header.slot_count; j++) {
-                Tuple* tuple = page_get_tuple(page, j, meta);
-                if (!tuple) continue;
+                TupleView view;
+                if (!page_get_tuple_view(page, j, meta, &view)) continue;
 
-                if (tuple->xmin == xid) {
+                if (view.xmin == xid) {
                     page_delete_tuple(page, j);
+                    pgstat_count_heap_dead(meta, 1);
                     modified = 1;
                     printf("[rollback] Removed tuple with oid=%u from table '%s'\n",
-                           tuple->oid, meta->name);
+                           view.oid, meta->name);
                 }
-
-                free_tuple(tuple);
             }
-            LWLockRelease(&page->lock);
+            if (modified && vm) {
+                visibilitymap_clear(vm, page->header.page_id);
+            }
+            LockBuffer(buf, BUFFER_LOCK_UNLOCK);
 
             if (modified) {
-                page_cache_mark_dirty(page_id);
-                page_cache_flush(page_id, fullpath);
+                MarkBufferDirty(buf);
             }
+            ReleaseBuffer(buf);
         }
+        read_stream_end(&stream);
+        FreeAccessStrategy(strategy);
     }
 
     txmgr_abort_transaction(db, xid);
@@ -311,19 +368,15 @@ bool nocache_db_insert(MiniDB *db, const char *table_name,   const Tuple * value
     
     while (fread(&page, sizeof(Page), 1, table_file) == 1) {
         // 检查空闲空间
-        size_t required_space = new_tuple->col_count * sizeof(Column) + 128; // 估算大小
+        size_t required_space = tuple_serialized_size(new_tuple) + sizeof(Slot);
         
         if (page_free_space(&page) >= required_space) {
-              // === 加锁：页锁 ===
-            LWLockAcquireExclusive(&page.lock);
             // 尝试插入
             if (page_insert_tuple(&page, new_tuple, &slot_index)) {
                 found_space = true;
                 insert_pos = ftell(table_file) - sizeof(Page);
-                     LWLockRelease(&page.lock);
                 break;
             }
-            LWLockRelease(&page.lock);
         }
     }
     LWLockRelease(&meta->fsm_lock);
@@ -333,7 +386,6 @@ bool nocache_db_insert(MiniDB *db, const char *table_name,   const Tuple * value
        
         PageID new_page_id = db->next_page_id++;
         page_init(&page, new_page_id);
-        LWLockInit(&page.lock, 0);  // 初始化新页锁
         if (!page_insert_tuple(&page, new_tuple, &slot_index)) {
             fprintf(stderr, "Failed to insert into new page\n");
             fclose(table_file);
@@ -366,70 +418,187 @@ bool nocache_db_insert(MiniDB *db, const char *table_name,   const Tuple * value
     return true;
 }
 
-//with cache
-bool old_cache_db_insert(MiniDB *db, const char *table_name, const Tuple *values, Session session) {
-    if (!db || !table_name || !values || session.current_xid == INVALID_XID) return false;
+// 每个会话线程缓存各表上次插入的页（类似 pg 的 rd_targblock），下标与目录中的表一致
+static _Thread_local struct {
+    uint32_t rel_oid;
+    PageID page_id;
+} insert_target[MAX_TABLES];
 
-    int idx = find_table(&db->catalog, table_name);
-    TableMeta *meta = &db->catalog.tables[idx];
-    if (!meta) return false;
+#define EXTEND_PAGES_PER_WAITER 20  // 每个等待扩展锁的线程多扩展的页数
+#define MAX_EXTEND_PAGES 512        // 一次最多多扩展的页数
 
-    Tuple *new_tuple = (Tuple *)values;
-    new_tuple->oid = ++meta->max_row_oid;
-    new_tuple->xmin = session.current_xid;
+/*
+ * 扩展表，返回供调用方使用的新页号，调用方需持有 extension_lock。
+ * 有其他线程在等扩展锁时按等待数成批扩展（类似 pg 的 RelationAddExtraBlocks），
+ * 多出的页用 fallocate 预分配并登记到空闲空间映射，不进缓冲池，第一次插入时才初始化。
+ * 新的表尾写入元数据文件，否则重启后扫描看不到扩展出的页。
+ */
+static PageID db_extend_table(MiniDB *db, TableMeta *meta, FreeSpaceMap *fsm) {
+    PageID first = meta->last_page + 1;
+    int extra = LWLockWaiterCount(&meta->extension_lock) * EXTEND_PAGES_PER_WAITER;
+    if (extra > MAX_EXTEND_PAGES) extra = MAX_EXTEND_PAGES;
+    if (extra > 0 && (!fsm || !smgr_extend(meta->oid, first, 1 + extra))) {
+        extra = 0;
+    }
+    meta->last_page = first + extra;
+    save_table_meta_to_file(meta, db->data_dir);
+    for (int i = 1; i <= extra; i++) {
+        RecordPageWithFreeSpace(fsm, first + i, PAGE_EMPTY_FREE_SPACE);
+    }
+    return first;
+}
+
+/*
+ * 把元组放入表中，位置写入 tid：先试本线程上次插入的页，空间不够再按空闲空间映射找页，
+ * 映射中没有合适的页时扩展表。已有页只在放入后仍保留 (100 - fillfactor)% 的空间时
+ * 才使用，留下的空间给 HOT 更新。批量写入时传入 BAS_BULKWRITE 策略，
+ * 只在该策略的环中使用缓冲区。
+ */
+static bool db_heap_insert_data(MiniDB *db, TableMeta *meta, const uint8_t *data, size_t data_size,
+                                BufferAccessStrategy strategy, ItemPointer *tid) {
+    int idx = (int)(meta - db->catalog.tables);
 
     char fullpath[256];
     snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
 
-    LWLockAcquireExclusive(&meta->fsm_lock);
-    Page *page = NULL;
-    PageID page_id;
-    bool inserted = false;
+    // 空表先写入第 0 页（文件不存在时由 smgr 创建）
+    smgr_open(meta->oid, fullpath);
+    if (smgr_nblocks(meta->oid) == 0) {
+        Page empty;
+        page_init(&empty, 0);
+        smgr_write(meta->oid, 0, &empty);
+    }
 
-    for (page_id = 0; page_id < db->next_page_id; page_id++) {
-        page = page_cache_load_or_fetch(page_id, fullpath);
-        if (!page) continue;
-
-        size_t required_space = new_tuple->col_count * sizeof(Column) + 128;
-        if (page_free_space(page) >= required_space) {
-            LWLockAcquireExclusive(&page->lock);
-            uint16_t slot_index;
-            if (page_insert_tuple(page, new_tuple, &slot_index)) {
-                page_cache_mark_dirty(page_id);
-                inserted = true;
-                LWLockRelease(&page->lock);
-                break;
+    // 所需空间只取决于元组本身大小：元组数据加一个槽位
+    size_t required_space = data_size + sizeof(Slot);
+    size_t reserved_space = (size_t)PAGE_DATA_SIZE * (100 - meta->fillfactor) / 100;
+    FreeSpaceMap *fsm = fsm_open(meta->oid, fullpath);
+    VisibilityMap *vm = vm_open(meta->oid, fullpath);
+    PageID page_id = INVALID_PAGE_ID;
+    if (insert_target[idx].rel_oid == meta->oid) {
+        page_id = insert_target[idx].page_id;
+    } else if (fsm) {
+        page_id = GetPageWithFreeSpace(fsm, required_space + reserved_space);
+    }
+
+    Buffer buf = InvalidBuffer;
+    size_t free_space = 0;
+    uint16_t slot_index = INVALID_SLOT;
+    bool inserted = false;
+    while (!inserted) {
+        while (page_id != INVALID_PAGE_ID) {
+            free_space = 0;
+            if (page_id >= meta->first_page && page_id <= meta->last_page) {
+                buf = ReadBufferExtended(meta->oid, page_id, fullpath, RBM_NORMAL, strategy);
+            }
+            if (BufferIsValid(buf)) {
+                Page *page = BufferGetPage(buf);
+                LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+                // 取到页锁之前该页可能已被清理从表尾截掉，不能再用
+                bool usable = page_id <= meta->last_page;
+                if (!usable) {
+                    free_space = 0;
+                } else if (page_is_new(page)) {
+                    // 批量扩展时预分配的页，第一次使用时初始化
+                    page_init(page, page_id);
+                    MarkBufferDirty(buf);
+                } else {
+                    int pruned = heap_page_prune_opt(page, &db->tx_mgr, required_space + reserved_space);
+                    if (pruned >= 0) {
+                        if (pruned > 0) pgstat_count_heap_prune(meta, pruned);
+                        MarkBufferDirty(buf);
+                    }
+                }
+                if (usable) free_space = page_free_space(page);
+                if (usable && free_space >= required_space + reserved_space) {
+                    inserted = page_insert_tuple_data(page, data, data_size, &slot_index);
+                    // 槽位用尽时空间虽够也插不进，记为已满
+                    free_space = inserted ? page_free_space(page) : 0;
+                }
+                if (inserted) {
+                    if (vm) visibilitymap_clear(vm, page_id);
+                    MarkBufferDirty(buf);
+                }
+                LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+                if (inserted) break;
+                ReleaseBuffer(buf);
+                buf = InvalidBuffer;
             }
-            LWLockRelease(&page->lock);
+            // 映射过时：记下该页的实际空闲空间，另找一页
+            page_id = fsm ? RecordAndGetPageWithFreeSpace(fsm, page_id, free_space,
+                                                          required_space + reserved_space)
+                          : INVALID_PAGE_ID;
         }
-    }
-    LWLockRelease(&meta->fsm_lock);
+        if (inserted) break;
 
-    if (!inserted) {
+        // 等扩展锁期间其他线程可能已扩展出空闲页，拿到锁后先再查一次映射
         LWLockAcquireExclusive(&meta->extension_lock);
-        page_id = db->next_page_id++;
-        page = page_cache_load_or_fetch(page_id, fullpath);
-        if (!page) {
-            page_init(page, page_id);
-            LWLockInit(&page->lock, 0);
+        if (fsm) {
+            page_id = GetPageWithFreeSpace(fsm, required_space + reserved_space);
+            if (page_id != INVALID_PAGE_ID) {
+                LWLockRelease(&meta->extension_lock);
+                continue;
+            }
+        }
+        page_id = db_extend_table(db, meta, fsm);
+        buf = ReadBufferExtended(meta->oid, page_id, fullpath, RBM_ZERO, strategy);
+        if (!BufferIsValid(buf)) {
+            LWLockRelease(&meta->extension_lock);
+            return false;
         }
-        LWLockAcquireExclusive(&page->lock);
-        uint16_t slot_index;
-        if (!page_insert_tuple(page, new_tuple, &slot_index)) {
-            LWLockRelease(&page->lock);
+        Page *page = BufferGetPage(buf);
+        LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+        if (page_is_new(page)) {
+            page_init(page, page_id);  // 扫描可能已从预分配的文件中读入了全 0 的页
+        }
+        if (!page_insert_tuple_data(page, data, data_size, &slot_index)) {
+            LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+            ReleaseBuffer(buf);
             LWLockRelease(&meta->extension_lock);
             return false;
         }
-        page_cache_mark_dirty(page_id);
-        LWLockRelease(&page->lock);
+        free_space = page_free_space(page);
+        if (vm) visibilitymap_clear(vm, page_id);
+        MarkBufferDirty(buf);
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
         LWLockRelease(&meta->extension_lock);
+        inserted = true;
     }
 
-    page_cache_flush(page_id, fullpath);
+    if (fsm) {
+        RecordPageWithFreeSpace(fsm, page_id, free_space);
+    }
+    insert_target[idx].rel_oid = meta->oid;
+    insert_target[idx].page_id = page_id;
+
+    // 只标记为脏，由后台写进程写回
+    ReleaseBuffer(buf);
+    if (tid) {
+        tid->page_id = page_id;
+        tid->slot = slot_index;
+    }
     return true;
 }
 
-bool db_insert(MiniDB *db, const char *table_name, const Tuple *values, Session session) {
+bool db_heap_insert(MiniDB *db, TableMeta *meta, Tuple *tuple, BufferAccessStrategy strategy,
+                    ItemPointer *tid) {
+    char fullpath[256];
+    snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
+    smgr_open(meta->oid, fullpath);
+
+    // 大元组先压缩、移出 TEXT 列
+    uint8_t data[MAX_TUPLE_SIZE];
+    size_t data_size = heap_toast_serialize(meta->oid, tuple, data);
+    if (data_size == 0) {
+        fprintf(stderr, "Error: tuple too large for table '%s'\n", meta->name);
+        return false;
+    }
+    return db_heap_insert_data(db, meta, data, data_size, strategy, tid);
+}
+
+// 插入一行新数据：分配行 OID 后放入表中
+static bool db_insert_with_strategy(MiniDB *db, const char *table_name, const Tuple *values,
+                                    Session session, BufferAccessStrategy strategy) {
     if (!db || !table_name || !values || session.current_xid == INVALID_XID) return false;
 
     int idx = find_table(&db->catalog, table_name);
@@ -439,133 +608,361 @@ bool db_insert(MiniDB *db, const char *table_name, const Tuple *values, Session
     Tuple *new_tuple = (Tuple *)values;
     new_tuple->oid = ++meta->max_row_oid;
     new_tuple->xmin = session.current_xid;
+    new_tuple->ctid.page_id = INVALID_PAGE_ID;
+    new_tuple->ctid.slot = INVALID_SLOT;
+    new_tuple->infomask = 0;
+
+    if (!db_heap_insert(db, meta, new_tuple, strategy, NULL)) return false;
+    pgstat_count_heap_insert(meta);
+    return true;
+}
+
+bool db_insert(MiniDB *db, const char *table_name, const Tuple *values, Session session) {
+    return db_insert_with_strategy(db, table_name, values, session, NULL);
+}
+
+int db_insert_batch(MiniDB *db, const char *table_name, const Tuple *values, int count, Session session) {
+    BufferAccessStrategy strategy = GetAccessStrategy(BAS_BULKWRITE);
+    int inserted = 0;
+    for (int i = 0; i < count; i++) {
+        if (db_insert_with_strategy(db, table_name, &values[i], session, strategy)) {
+            inserted++;
+        }
+    }
+    FreeAccessStrategy(strategy);
+    return inserted;
+}
 
+Tuple* db_heap_fetch(MiniDB *db, TableMeta *meta, ItemPointer tid) {
     char fullpath[256];
     snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
 
-    FILE* fp = fopen(fullpath, "r+b");
-    if (!fp) {
-        fp = fopen(fullpath, "w+b");
-    }
-    fseek(fp, 0, SEEK_END);
-    if (ftell(fp) == 0) {
-        Page empty;
-        page_init(&empty, 0);
-        fwrite(&empty, sizeof(Page), 1, fp);
-     
-    }
-    fclose(fp);
+    Buffer buf = ReadBuffer(meta->oid, tid.page_id, fullpath);
+    if (!BufferIsValid(buf)) return NULL;
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    Tuple *tuple = page_get_tuple(BufferGetPage(buf), tid.slot, meta);
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+    return tuple;
+}
 
-    LWLockAcquireExclusive(&meta->fsm_lock);
-    Page *page = NULL;
-    PageID page_id;
-    bool inserted = false;
+Tuple* db_heap_fetch_latest(MiniDB *db, TableMeta *meta, uint32_t oid, ItemPointer *tid) {
+    char fullpath[256];
+    snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
 
-    //for (page_id = 0; page_id < db->next_page_id; page_id++) {
-    for (page_id = meta->first_page; page_id <= meta->last_page; page_id++) {
-        page = page_cache_load_or_fetch(page_id, fullpath);
-        if (!page) continue;
-
-        size_t required_space = new_tuple->col_count * sizeof(Column) + 128;
-        if (page_free_space(page) >= required_space) {
-            LWLockAcquireExclusive(&page->lock);
-            uint16_t slot_index;
-            if (page_insert_tuple(page, new_tuple, &slot_index)) {
-                page_cache_mark_dirty(page_id);
-                inserted = true;
-                LWLockRelease(&page->lock);
-                break;
+    Tuple *latest = NULL;
+    ReadStream stream;
+    Buffer buf;
+    BufferAccessStrategy strategy = GetScanAccessStrategy(meta->last_page - meta->first_page + 1);
+    read_stream_begin(&stream, meta->oid, fullpath, meta->first_page, meta->last_page,
+                      db_config.effective_io_concurrency, strategy);
+    while (!latest && read_stream_next(&stream, &buf, NULL)) {
+        if (!BufferIsValid(buf)) continue;
+        Page *page = BufferGetPage(buf);
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+        for (uint16_t i = 0; i < page->header.slot_count && !latest; i++) {
+            TupleView view;
+            if (page_get_tuple_view(page, i, meta, &view) && view.oid == oid &&
+                !txmgr_is_committed(&db->tx_mgr, view.xmax) &&
+                (txmgr_is_committed(&db->tx_mgr, view.xmin) ||
+                 txmgr_is_in_progress(&db->tx_mgr, view.xmin))) {
+                latest = tuple_view_materialize(&view, NULL);
+                tid->page_id = page->header.page_id;
+                tid->slot = i;
             }
-            LWLockRelease(&page->lock);
         }
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        ReleaseBuffer(buf);
     }
-    LWLockRelease(&meta->fsm_lock);
+    // 提前结束时放掉预读中的缓冲区
+    read_stream_end(&stream);
+    FreeAccessStrategy(strategy);
+    return latest;
+}
 
-    if (!inserted) {
-        LWLockAcquireExclusive(&meta->extension_lock);
-        //page_id = db->next_page_id++;
-         PageID new_page_id = ++meta->last_page;
-        page = page_cache_load_or_fetch(page_id, fullpath);
-        if (!page) {
-            Page new_page;
-            //page_init(&new_page, page_id);
-            page_init(&new_page, new_page_id);
-            LWLockInit(&new_page.lock, 0);
-            global_page_cache.entries[page_id % PAGE_CACHE_SIZE].page = new_page;
-            //global_page_cache.entries[page_id % PAGE_CACHE_SIZE].oid = page_id;//oid 表示page_id
-            global_page_cache.entries[new_page_id % PAGE_CACHE_SIZE].oid = new_page_id;
-            global_page_cache.entries[page_id % PAGE_CACHE_SIZE].valid = true;
-            global_page_cache.entries[page_id % PAGE_CACHE_SIZE].dirty = true;
-            page = &global_page_cache.entries[page_id % PAGE_CACHE_SIZE].page;
+/*
+ * 检查 otid 处的版本能否被 session 更新，能更新时返回 HEAP_UPDATE_OK。
+ * 中止事务留下的 xmax 视为无效。
+ */
+static HeapUpdateResult db_heap_update_check(MiniDB *db, const TupleView *old, Session session,
+                                             ItemPointer *otid) {
+    if (old->xmax == 0 || old->xmax == session.current_xid) {
+        return old->xmax == 0 ? HEAP_UPDATE_OK : HEAP_UPDATE_SELF;
+    }
+    if (txmgr_is_committed(&db->tx_mgr, old->xmax)) {
+        if (!(old->infomask & TUPLE_UPDATED)) {
+            return HEAP_UPDATE_DELETED;
         }
-        LWLockAcquireExclusive(&page->lock);
-        uint16_t slot_index;
-        if (!page_insert_tuple(page, new_tuple, &slot_index)) {
-            LWLockRelease(&page->lock);
-            LWLockRelease(&meta->extension_lock);
-            return false;
+        *otid = old->ctid;
+        return HEAP_UPDATE_UPDATED;
+    }
+    if (txmgr_is_in_progress(&db->tx_mgr, old->xmax)) {
+        return HEAP_UPDATE_BEING_UPDATED;
+    }
+    return HEAP_UPDATE_OK;
+}
+
+// 把旧版本标记为被 session 更新，ctid 指向新版本（旧版本计为死元组）；调用方持有页面排他锁
+static void db_heap_link_version(TableMeta *meta, Page *page, uint16_t slot, const TupleView *old,
+                                 ItemPointer new_tid, bool hot, Session session) {
+    Tuple header = { .xmax = session.current_xid, .ctid = new_tid,
+                     .infomask = old->infomask | TUPLE_UPDATED };
+    PageSetPrunable(page, session.current_xid);
+    if (hot) {
+        header.infomask |= TUPLE_HOT_UPDATED;
+    } else {
+        header.infomask &= ~TUPLE_HOT_UPDATED;
+    }
+    // 只改元组头，列数据（可能含压缩或外部存储的值）原样保留
+    page_update_tuple_header(page, slot, &header);
+    pgstat_count_heap_dead(meta, 1);
+}
+
+/*
+ * 更新一行 (类似 pg 的 heap_update)：
+ * 旧版本所在页放得下新版本时做 HOT 更新，新版本标记为 TUPLE_HEAP_ONLY，
+ * 可使用 fillfactor 预留的空间；否则先放开旧页，按插入的规则把新版本放到其他页，
+ * 再回到旧页链接。两种情况旧版本的 ctid 都指向新版本，形成更新链。
+ * 旧版本已被其他已提交事务更新时返回 HEAP_UPDATE_UPDATED 并把 otid 改为新版本的位置，
+ * 调用方可沿链取出最新版本重试，不必重新扫描表。
+ * 取页时空闲空间不足会先剪枝；otid 处的版本已被剪枝回收时返回 HEAP_UPDATE_PRUNED，
+ * 调用方可用 db_heap_fetch_latest 按 OID 重新定位该行。
+ * 调用方需持有该行的行锁。
+ */
+HeapUpdateResult db_heap_update(MiniDB *db, TableMeta *meta, ItemPointer *otid, Tuple *newtup,
+                                Session session) {
+    char fullpath[256];
+    snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
+    VisibilityMap *vm = vm_open(meta->oid, fullpath);
+
+    Buffer buf = ReadBuffer(meta->oid, otid->page_id, fullpath);
+    if (!BufferIsValid(buf)) return HEAP_UPDATE_FAILED;
+    Page *page = BufferGetPage(buf);
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+    // 页面快满时先回收死版本，让新版本尽量留在本页做 HOT 更新（按未压缩的大小估计）
+    size_t estimated_size = tuple_serialized_size(newtup);
+    if (estimated_size > TOAST_TUPLE_TARGET) estimated_size = TOAST_TUPLE_TARGET;
+    int pruned = heap_page_prune_opt(page, &db->tx_mgr, estimated_size + sizeof(Slot));
+    if (pruned > 0) {
+        FreeSpaceMap *fsm = fsm_open(meta->oid, fullpath);
+        pgstat_count_heap_prune(meta, pruned);
+        if (fsm) RecordPageWithFreeSpace(fsm, otid->page_id, page_free_space(page));
+    }
+    if (pruned >= 0) {
+        MarkBufferDirty(buf);
+    }
+
+    // 只用到旧版本的元组头（视图中已复制出来，之后本页被整理也不受影响）
+    TupleView old;
+    HeapUpdateResult result;
+    if (!page_get_tuple_view(page, otid->slot, meta, &old) || old.oid != newtup->oid) {
+        result = HEAP_UPDATE_PRUNED;
+    } else {
+        result = db_heap_update_check(db, &old, session, otid);
+    }
+    if (result != HEAP_UPDATE_OK) {
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        ReleaseBuffer(buf);
+        return result;
+    }
+
+    newtup->oid = old.oid;
+    newtup->xmin = session.current_xid;
+    newtup->xmax = 0;
+    newtup->ctid.page_id = INVALID_PAGE_ID;
+    newtup->ctid.slot = INVALID_SLOT;
+    newtup->infomask = TUPLE_HEAP_ONLY;
+
+    // 大元组在持有页锁时写 .toast 文件，只有需要移出列的更新付出这个代价
+    uint8_t data[MAX_TUPLE_SIZE];
+    size_t data_size = heap_toast_serialize(meta->oid, newtup, data);
+    if (data_size == 0) {
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        ReleaseBuffer(buf);
+        return HEAP_UPDATE_FAILED;
+    }
+
+    ItemPointer new_tid = { .page_id = otid->page_id };
+    if (page_free_space(page) >= data_size + sizeof(Slot) &&
+        page_insert_tuple_data(page, data, data_size, &new_tid.slot)) {
+        if (vm) visibilitymap_clear(vm, otid->page_id);
+        db_heap_link_version(meta, page, otid->slot, &old, new_tid, true, session);
+        MarkBufferDirty(buf);
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        ReleaseBuffer(buf);
+        return HEAP_UPDATE_OK;
+    }
+
+    // 本页放不下：放开旧页再插入，避免同时持有两页的排他锁（行锁保证旧版本不会被别人更新）
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    newtup->infomask = 0;
+    data[TUPLE_INFOMASK_OFFSET] = 0;
+    if (!db_heap_insert_data(db, meta, data, data_size, NULL, &new_tid)) {
+        ReleaseBuffer(buf);
+        return HEAP_UPDATE_FAILED;
+    }
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    if (vm) visibilitymap_clear(vm, otid->page_id);
+    db_heap_link_version(meta, page, otid->slot, &old, new_tid, false, session);
+    MarkBufferDirty(buf);
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+    return HEAP_UPDATE_OK;
+}
+
+bool db_set_fillfactor(MiniDB *db, const char *table_name, int fillfactor) {
+    int idx = find_table(&db->catalog, table_name);
+    if (idx < 0 || fillfactor < HEAP_MIN_FILLFACTOR || fillfactor > 100) return false;
+    TableMeta *meta = &db->catalog.tables[idx];
+    meta->fillfactor = (uint8_t)fillfactor;
+    return save_table_meta_to_file(meta, db->data_dir);
+}
+
+
+/*
+ * 收集一页中对 session 可见的元组，调用方需保证页面在访问期间不被修改。
+ * all_visible 表示页面在可见性映射中已标记为全部可见，此时不再逐行判断可见性。
+ * 可见性和 qual 条件在页面中的元组视图上判断，只有满足的行才复制出来；
+ * needed 为查询输出的列，见 deserialize_tuple_attrs。
+ * 返回页上元组是否都对所有事务可见（插入事务已提交且早于最老活动事务、未被删除）。
+ */
+static bool db_query_page(MiniDB *db, TableMeta *meta, const Page *page, bool all_visible,
+                          const bool *needed, const Condition *qual, Session session,
+                          Tuple **results, int *total_tuples) {
+    if (page->header.page_id == INVALID_PAGE_ID) {
+        return false;
+    }
+    uint32_t oldest_xid = db->tx_mgr.oldest_xid;
+    bool page_all_visible = true;
+    for (int i = 0; i < page->header.slot_count; i++) {
+        TupleView view;
+        if (!page_get_tuple_view(page, i, meta, &view)) {
+            // 回滚删除的槽位要等清理回收，这样的页不能记为全部可见，否则清理会跳过它
+            if (PageGetSlots(page)[i].flags & SLOT_DELETED) page_all_visible = false;
+            continue;
+        }
+        bool visible = all_visible;
+        if (!all_visible) {
+            if (page_all_visible &&
+                !(view.xmax == 0 && view.xmin < oldest_xid &&
+                  txmgr_is_committed(&db->tx_mgr, view.xmin))) {
+                page_all_visible = false;
+            }
+            visible = tuple_view_is_visible(&db->tx_mgr, &view, session.current_xid);
+        }
+        if (visible && qual && !tuple_view_eval_condition(qual, &view, meta)) {
+            continue;
+        }
+        // 只有满足条件的可见行才复制出来
+        if (visible && *total_tuples < MAX_RESULTS) {
+            Tuple* t = tuple_view_materialize(&view, needed);
+            if (t) results[(*total_tuples)++] = t;
         }
-        //page_cache_mark_dirty(page_id);
-        page_cache_mark_dirty(new_page_id);
-        LWLockRelease(&page->lock);
-        LWLockRelease(&meta->extension_lock);
     }
+    return all_visible || page_all_visible;
+}
 
-    page_cache_flush(page_id, fullpath);
-   
-    //save_tx_state(&db->tx_mgr, db->data_dir);
-    return true;
+// 扫描一个缓冲区，顺带把新发现的全部可见页记入可见性映射
+static void db_query_buffer(MiniDB *db, TableMeta *meta, VisibilityMap *vm, Buffer buf,
+                            const bool *needed, const Condition *qual, Session session,
+                            Tuple **results, int *total_tuples) {
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    Page *page = BufferGetPage(buf);
+    PageID page_id = page->header.page_id;
+    bool all_visible = vm && page_id != INVALID_PAGE_ID && visibilitymap_test(vm, page_id);
+    if (db_query_page(db, meta, page, all_visible, needed, qual, session, results, total_tuples) &&
+        !all_visible && vm) {
+        visibilitymap_set(vm, page_id);
+    }
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
 }
 
+/*
+ * 通过只读内存映射扫描表：调用方已先写回表的脏页。缓冲池中已有的页可能比文件新，
+ * 仍从缓冲池读；其余页直接读映射，不拷贝进缓冲池，也不调用 read。
+ * 文件中的页只会在缓冲池中被修改后写回，读完映射页若发现它已被装入缓冲池，
+ * 可能读到了写了一半的页，丢弃结果改从缓冲池读。
+ * 映射建立之后扩展出的页经缓冲池读取。
+ */
+static void db_query_mapped(MiniDB *db, TableMeta *meta, VisibilityMap *vm, SMgrMap *map,
+                            const char *fullpath, const bool *needed, const Condition *qual,
+                            Session session, Tuple **results, int *total_tuples) {
+    for (PageID page_id = meta->first_page; page_id <= meta->last_page; page_id++) {
+        Buffer buf = ReadBufferIfCached(meta->oid, page_id);
+        if (BufferIsValid(buf)) {
+            db_query_buffer(db, meta, vm, buf, needed, qual, session, results, total_tuples);
+            continue;
+        }
+        // 映射中的页不受页面锁保护，不能依据可见性映射跳过判断
+        const Page* page = smgr_map_page(map, page_id);
+        if (page) {
+            int before = *total_tuples;
+            db_query_page(db, meta, page, false, needed, qual, session, results, total_tuples);
+            buf = ReadBufferIfCached(meta->oid, page_id);
+            if (BufferIsValid(buf)) {
+                while (*total_tuples > before) {
+                    free_tuple(results[--(*total_tuples)]);
+                }
+                db_query_buffer(db, meta, vm, buf, needed, qual, session, results, total_tuples);
+            }
+            continue;
+        }
+        buf = ReadBuffer(meta->oid, page_id, fullpath);
+        if (BufferIsValid(buf)) {
+            db_query_buffer(db, meta, vm, buf, needed, qual, session, results, total_tuples);
+        }
+    }
+}
 
 Tuple** db_query(MiniDB *db, const char *table_name, int *result_count, Session session) {
+    return db_query_attrs(db, table_name, result_count, session, NULL, NULL);
+}
+
+Tuple** db_query_attrs(MiniDB *db, const char *table_name, int *result_count, Session session,
+                       const bool *needed, const Condition *qual) {
     if (!db || !table_name || !result_count) return NULL;
 
     *result_count = 0;
     int idx = find_table(&db->catalog, table_name);
+    if (idx < 0) return NULL;
     TableMeta *meta = &db->catalog.tables[idx];
-    if (!meta) return NULL;
 
     char fullpath[256];
     snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
 
-    Tuple** results = malloc(MAX_RESULTS * sizeof(Tuple*));
+    // 结果数组和元组都在调用方的当前内存上下文中分配
+    Tuple** results = palloc(MAX_RESULTS * sizeof(Tuple*));
     if (!results) return NULL;
 
     int total_tuples = 0;
-    //for (PageID page_id = 0; page_id < db->next_page_id; page_id++) {
-    for (PageID page_id = meta->first_page; page_id <= meta->last_page; page_id++) {
-        Page* page = page_cache_load_or_fetch(page_id, fullpath);
-        if (!page || page->header.page_id == INVALID_PAGE_ID) continue;
-
-        Slot* slots = page->slots;
-        for (int i = 0; i < page->header.slot_count; i++) {
-            Tuple* t = page_get_tuple(page, i, meta);
-            if (!t) continue;
-            bool visible = false;
-            uint32_t xid = session.current_xid;
-           // if (!t->deleted && t->xmin <= xid && (t->xmax == 0 || t->xmax > xid)) {
-            //    visible = true;
-           // }
-            visible = is_tuple_visible(&db->tx_mgr, t, session.current_xid);
-            if (visible) {
-                if (total_tuples < MAX_RESULTS) {
-                    results[total_tuples++] = t;
-                } else {
-                    free_tuple(t);
-                }
-            } else {
-                free_tuple(t);
-            }
+    VisibilityMap *vm = vm_open(meta->oid, fullpath);
+    SMgrMap* map = NULL;
+    // 表还有写不回的脏页时文件内容不可信，不走映射
+    if (db_config.mmap_scans && smgr_open(meta->oid, fullpath) && FlushRelationBuffers(meta->oid)) {
+        map = smgr_map(meta->oid);
+    }
+    if (map) {
+        db_query_mapped(db, meta, vm, map, fullpath, needed, qual, session, results, &total_tuples);
+        smgr_unmap(map);
+    } else {
+        ReadStream stream;
+        Buffer buf;
+        BufferAccessStrategy strategy = GetScanAccessStrategy(meta->last_page - meta->first_page + 1);
+        read_stream_begin(&stream, meta->oid, fullpath, meta->first_page, meta->last_page,
+                          db_config.effective_io_concurrency, strategy);
+        while (read_stream_next(&stream, &buf, NULL)) {
+            if (!BufferIsValid(buf)) continue;
+            db_query_buffer(db, meta, vm, buf, needed, qual, session, results, &total_tuples);
         }
+        read_stream_end(&stream);
+        FreeAccessStrategy(strategy);
     }
 
     if (total_tuples == 0) {
-        free(results);
+        pfree(results);
         return NULL;
-    } else {
-        Tuple** tmp = realloc(results, total_tuples * sizeof(Tuple*));
-        if (tmp) results = tmp;
     }
     *result_count = total_tuples;
    // save_table_meta_to_file(meta, db->data_dir);
@@ -582,13 +979,33 @@ void free_query_results(Tuple** results, int count) {
             free_tuple(results[i]);
         }
     }
-    free(results);
+    pfree(results);
 }
 // 创建检查点
 void db_create_checkpoint(MiniDB *db) {
+    // 数据页可能引用 .toast 文件中的值，先把它们刷盘
+    toast_sync_all();
+    // 检查点前写回所有脏页
+    if (!FlushAllBuffers()) {
+        fprintf(stderr, "Warning: checkpoint could not write all dirty buffers\n");
+    }
+    fsm_sync_all();
+    vm_sync_all();
     wal_log_checkpoint();
 }
 
+// 关闭数据库：停止后台写进程并写回所有脏页
+void close_db(MiniDB *db) {
+    autovacuum_stop();
+    autoprewarm_stop();
+    bgwriter_stop();
+    db_create_checkpoint(db);
+    fsm_shutdown();
+    vm_shutdown();
+    toast_shutdown();
+    smgr_shutdown();
+}
+
 // 打印数据库状态
 void print_db_status(const MiniDB *db) {
     printf("\n===== Database Status =====\n");
@@ -612,4 +1029,7 @@ void print_db_status(const MiniDB *db) {
     
     // 打印事务管理器状态
     txmgr_print_status(&db->tx_mgr);
+
+    // 打印页缓存命中率
+    page_cache_print_stats();
 }
@@ -1,47 +1,21 @@
 #include "page.h"
 #include "tuple.h"
 #include "lock.h"
+#include "smgr.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
 #include <stddef.h> // 添加这行以支持ptrdiff_t
+#include <sys/mman.h>
+#include <sched.h>
+#include <time.h>
 extern const char *DATADIR;
 
 
-// 计算槽位数组起始位置
-//static Slot* page_slots(Page* page) {
- //   return (Slot*)(page->data);
-//}
-
-// 计算槽位数组结束位置
-//static uint8_t* page_slots_end(Page* page) {
-//    return (uint8_t*)(page_slots(page) + page->header.slot_count);
-//}
+// 槽位数组位于数据区开头
 static Slot* page_slots(Page* page) {
-    return page->slots;
-}
-
-// 计算槽位数组结束位置（固定为 slots + MAX_SLOTS）
-static uint8_t* page_slots_end(Page* page) {
-    return (uint8_t*)(page->slots + MAX_SLOTS);
-}
-
-
-static uint8_t* page_data_start(Page* page) {
-    return ((uint8_t*)page) + PAGE_DATA_OFFSET + page->header.free_start;
-}
-// 计算数据区起始位置
-//static uint8_t* page_data_start(Page* page) {
-//    return page->data + page->header.free_start;
-//}
-
-// 计算数据区结束位置
-//static uint8_t* page_data_end(Page* page) {
- //   return page->data + page->header.free_end;
-//}
-static uint8_t* page_data_end(Page* page) {
-    return ((uint8_t*)page) + PAGE_DATA_OFFSET + page->header.free_end;
+    return PageGetSlots(page);
 }
 
 // 初始化页面
@@ -51,66 +25,78 @@ void page_init(Page* page, PageID page_id) {
     page->header.checksum = 0;
     page->header.page_id = page_id;
     page->header.lsn = 0;
-    page->header.free_start = 0;  // 数据区起始位置（初始为0）
-    page->header.free_end = sizeof(page->data); // 数据区结束位置（初始为末尾）
+    page->header.free_start = 0;                  // 还没有槽位
+    page->header.free_end = sizeof(page->data);   // 还没有元组数据
     page->header.slot_count = 0;
     page->header.tuple_count = 0;
+    page->header.prune_xid = 0;
     page->header.next_page = INVALID_PAGE_ID;
     page->header.prev_page = INVALID_PAGE_ID;
 }
 
-// 计算页面空闲空间
+bool page_is_new(const Page* page) {
+    return page->header.free_end == 0 && page->header.slot_count == 0;
+}
+
+// 计算页面空闲空间：槽位数组末尾与元组数据起点之间的空隙
 size_t page_free_space(const Page* page) {
-    // 空闲空间 = 数据区可用空间 + 未使用的槽位空间
-    size_t data_space = page->header.free_end - page->header.free_start;
-    size_t slot_space = (MAX_SLOTS - page->header.slot_count) * sizeof(Slot);
-    return data_space + slot_space;
+    return page->header.free_end - page->header.free_start;
 }
 
 void free_page(Page* page) {
     if (page) free(page);
 }
-// 压缩页面（回收删除的空间）
+
+// 整理页面：把仍占用的元组紧凑地移到页尾，回收已删除元组的空间（槽位号保持不变）
 void page_compact(Page* page) {
-    uint8_t* new_data_start = page_slots_end(page);
-    uint8_t* old_data_start = page_data_start(page);
-    uint8_t* old_data_end = page_data_end(page);
-    
-    size_t data_size = old_data_end - old_data_start;
-    
-    if (new_data_start > old_data_start) {
-        // 移动数据到新位置
-        memmove(new_data_start, old_data_start, data_size);
-        
-        // 更新槽位的偏移量
-        Slot* slots = page_slots(page);
-        ptrdiff_t offset_diff = new_data_start - old_data_start;
-        
-        for (int i = 0; i < page->header.slot_count; i++) {
-            if (slots[i].flags & SLOT_OCCUPIED) {
-                slots[i].offset += offset_diff;
-            }
+    uint8_t buffer[PAGE_DATA_SIZE];
+    Slot* slots = page_slots(page);
+    uint16_t upper = sizeof(page->data);
+
+    for (int i = 0; i < page->header.slot_count; i++) {
+        if (!(slots[i].flags & SLOT_OCCUPIED)) {
+            slots[i].length = 0;
+            continue;
         }
-        
-        // 更新空闲空间指针
-        page->header.free_start = (new_data_start - page->data) + data_size;
-        page->header.free_end = sizeof(page->data);
+        upper -= slots[i].length;
+        memcpy(buffer + upper, page->data + slots[i].offset, slots[i].length);
+        slots[i].offset = upper;
     }
+    memcpy(page->data + upper, buffer + upper, sizeof(page->data) - upper);
+    page->header.free_end = upper;
 }
 
 // 插入元组到页面
 bool page_insert_tuple(Page* page, const Tuple* tuple, uint16_t* slot_out) {
     if (!page || !tuple || !slot_out) return false;
-    if (page->header.slot_count >= MAX_SLOTS) return false;
-
     
-    // 序列化元组以确定所需空间
+    // 序列化元组以确定所需空间，超过 MAX_TUPLE_SIZE 的需先经 heap_toast_serialize
+    if (tuple_serialized_size(tuple) > MAX_TUPLE_SIZE) return false;
     uint8_t buffer[MAX_TUPLE_SIZE];
     size_t tuple_size = serialize_tuple(tuple, buffer);
     if (tuple_size == 0) return false;
-    
+    return page_insert_tuple_data(page, buffer, tuple_size, slot_out);
+}
+
+// 把已序列化的元组放入页面
+bool page_insert_tuple_data(Page* page, const uint8_t* data, size_t tuple_size, uint16_t* slot_out) {
+    if (!page || !data || tuple_size == 0 || tuple_size > MAX_TUPLE_SIZE || !slot_out) return false;
+
+    // 优先重用剪枝回收的空槽位（有效元组数少于槽位数时才可能有），否则在槽位数组末尾追加
+    Slot* slots = page_slots(page);
+    uint16_t slot_index = page->header.slot_count;
+    if (page->header.tuple_count < page->header.slot_count) {
+        for (uint16_t i = 0; i < page->header.slot_count; i++) {
+            if (slots[i].flags == SLOT_UNUSED) {
+                slot_index = i;
+                break;
+            }
+        }
+    }
+    bool reuse = slot_index < page->header.slot_count;
+
     // 检查是否有足够空间
-    size_t required_space = tuple_size + sizeof(Slot);
+    size_t required_space = tuple_size + (reuse ? 0 : sizeof(Slot));
     if (page_free_space(page) < required_space) {
         // 尝试压缩页面以释放空间
         page_compact(page);
@@ -119,16 +105,17 @@ bool page_insert_tuple(Page* page, const Tuple* tuple, uint16_t* slot_out) {
         }
     }
     
-    // 分配新槽位
-    uint16_t slot_index = page->header.slot_count;
-    page->header.slot_count++;
-    
-    Slot* slots = page_slots(page);
+    // 分配槽位
     Slot* new_slot = &slots[slot_index];
-    
-    // 在数据区分配空间（从空闲空间开始处分配）
-    uint16_t data_offset = page->header.free_start;
-    page->header.free_start += tuple_size;
+    memset(new_slot, 0, sizeof(Slot));
+    if (!reuse) {
+        page->header.slot_count++;
+        page->header.free_start += sizeof(Slot);
+    }
+
+    // 元组数据从空闲区末尾向前分配
+    page->header.free_end -= tuple_size;
+    uint16_t data_offset = page->header.free_end;
     
     // 设置槽位信息
     new_slot->offset = data_offset;
@@ -136,7 +123,7 @@ bool page_insert_tuple(Page* page, const Tuple* tuple, uint16_t* slot_out) {
     new_slot->flags = SLOT_OCCUPIED;
     
     // 复制元组数据到页面
-    memcpy(page->data + data_offset, buffer, tuple_size);
+    memcpy(page->data + data_offset, data, tuple_size);
     
     // 更新页面元数据
     page->header.tuple_count++;
@@ -158,42 +145,67 @@ bool page_delete_tuple(Page* page, uint16_t slot) {
         return false; // 槽位未被占用
     }
     
-    // 标记为已删除（不立即回收空间）
+    // 标记为已删除（不立即回收空间，下次剪枝时回收槽位和数据）
     target_slot->flags |= SLOT_DELETED;
     target_slot->flags &= ~SLOT_OCCUPIED;
     
     // 更新页面元数据
     page->header.tuple_count--;
+    PageSetPrunable(page, 1);  // 已删除的槽位对任何事务都不可见，随时可回收
     
     return true;
 }
 
 // 从页面获取元组
 Tuple* page_get_tuple(const Page* page, uint16_t slot, const TableMeta* meta) {
+    return page_get_tuple_attrs(page, slot, meta, NULL);
+}
+
+Tuple* page_get_tuple_attrs(const Page* page, uint16_t slot, const TableMeta* meta,
+                            const bool* needed) {
+    TupleView view;
+    if (!page_get_tuple_view(page, slot, meta, &view)) {
+        return NULL; // 槽位未被占用
+    }
+    return tuple_view_materialize(&view, needed);
+}
+
+bool page_get_tuple_view(const Page* page, uint16_t slot, const TableMeta* meta, TupleView* view) {
     if (!page || slot >= page->header.slot_count) {
-        return NULL;
+        return false;
     }
-    
-    const Slot* slots = page_slots(page);
-    const Slot* target_slot = &slots[slot];
-    
+    const Slot* target_slot = &page_slots(page)[slot];
     if (!(target_slot->flags & SLOT_OCCUPIED)) {
-        return NULL; // 槽位未被占用
+        return false;
     }
-    
-    // 从页面数据区读取元组
-    const uint8_t* tuple_data = page->data + target_slot->offset;
-    
-    // 反序列化元组
-    Tuple* tuple = (Tuple*)malloc(sizeof(Tuple));
-    if (!tuple) return NULL;
-    
-    if (deserialize_tuple(tuple, tuple_data) != target_slot->length) {
-        free(tuple);
-        return NULL; // 反序列化失败
+    if (!tuple_view_init(view, page->data + target_slot->offset, target_slot->length,
+                         meta ? meta->oid : 0)) {
+        return false;
     }
-    
-    return tuple;
+    // 列数与表定义一致时才能用表的缓存偏移
+    if (meta && view->col_count == meta->col_count) view->attcacheoff = meta->attcacheoff;
+    return true;
+}
+
+// 原地覆盖元组头（xmax、ctid、infomask），不动列数据
+bool page_update_tuple_header(Page* page, uint16_t slot, const Tuple* tuple) {
+    if (!page || !tuple || slot >= page->header.slot_count) {
+        return false;
+    }
+    Slot* target_slot = &page_slots(page)[slot];
+    if (!(target_slot->flags & SLOT_OCCUPIED)) {
+        return false;
+    }
+    // 头部布局见 serialize_tuple：oid, xmin, xmax, ctid.page_id, ctid.slot, infomask
+    uint8_t* ptr = page->data + target_slot->offset + 2 * sizeof(uint32_t);
+    memcpy(ptr, &tuple->xmax, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, &tuple->ctid.page_id, sizeof(PageID));
+    ptr += sizeof(PageID);
+    memcpy(ptr, &tuple->ctid.slot, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    *ptr = tuple->infomask;
+    return true;
 }
 
 // 更新页面中的元组
@@ -210,6 +222,7 @@ bool page_update_tuple(Page* page, uint16_t slot, const Tuple* new_tuple) {
     }
     
     // 序列化新元组
+    if (tuple_serialized_size(new_tuple) > MAX_TUPLE_SIZE) return false;
     uint8_t buffer[MAX_TUPLE_SIZE];
     size_t new_size = serialize_tuple(new_tuple, buffer);
     if (new_size == 0) return false;
@@ -221,7 +234,15 @@ bool page_update_tuple(Page* page, uint16_t slot, const Tuple* new_tuple) {
         return true;
     }
     
-    // 新元组更大，需要重新分配空间
+    // 新元组更大，需要重新分配空间。先确保放得下（整理页面时旧元组仍占用，
+    // 不会被回收），失败时旧元组原样保留
+    if (page_free_space(page) < new_size + sizeof(Slot)) {
+        page_compact(page);
+        if (page_free_space(page) < new_size + sizeof(Slot)) {
+            return false;
+        }
+    }
+
     // 先删除旧元组
     target_slot->flags |= SLOT_DELETED;
     target_slot->flags &= ~SLOT_OCCUPIED;
@@ -272,11 +293,10 @@ void page_print_info(const Page* page) {
     }
     
     printf("Page ID: %u\n", page->header.page_id);
-    printf("Tuples: %u/%u (slots used: %u/%u)\n", 
-           page->header.tuple_count, MAX_SLOTS,
-           page->header.slot_count, MAX_SLOTS);
+    printf("Tuples: %u (slots used: %u)\n",
+           page->header.tuple_count, page->header.slot_count);
     printf("Free space: %zu bytes\n", page_free_space(page));
-    printf("Data range: [%u, %u]\n", page->header.free_start, page->header.free_end);
+    printf("Free range: [%u, %u)\n", page->header.free_start, page->header.free_end);
     printf("LSN: %u\n", page->header.lsn);
     printf("Prev page: %u, Next page: %u\n", 
            page->header.prev_page, page->header.next_page);
@@ -295,265 +315,869 @@ void page_print_info(const Page* page) {
 }
 
 // ========== 新增：从文件中读取页面 ==========
-// ========== 新增：从文件中读取页面（使用路径） ==========
-Page* read_page(const char* table_path, PageID page_id) {
-    if (!table_path) return NULL;
-    
-    FILE* file = fopen(table_path, "rb");
-    if (!file) return NULL;
+// ========== 通过存储管理层读取页面（表需已登记） ==========
+Page* read_page(uint32_t rel_oid, PageID page_id) {
+    Page* page = malloc(sizeof(Page));
+    if (!page) return NULL;
 
-    size_t page_size = sizeof(Page);
-    if (fseek(file, page_id * page_size, SEEK_SET) != 0) {
-        fclose(file);
+    if (!smgr_read(rel_oid, page_id, page)) {
+        free(page);
         return NULL;
     }
+    return page;
+}
 
-    Page* page = malloc(page_size);
-    if (!page) {
-        fclose(file);
-        return NULL;
+PageCache global_page_cache;
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+// 分配缓冲池内存区：优先 MAP_HUGETLB，按模式决定是否退回普通页
+static void* page_cache_alloc_region(size_t* size, HugePagesMode mode, bool* huge) {
+    *huge = false;
+    if (mode != HUGE_PAGES_OFF) {
+        size_t huge_size = (*size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void* region = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED) {
+            *size = huge_size;
+            *huge = true;
+            return region;
+        }
+        if (mode == HUGE_PAGES_ON) {
+            perror("init_page_cache: mmap with MAP_HUGETLB failed");
+            return NULL;
+        }
     }
 
-    if (fread(page, 1, page_size, file) != page_size) {
-        free(page);
-        fclose(file);
+    void* region = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        perror("init_page_cache: mmap failed");
         return NULL;
     }
-
-    fclose(file);
-    return page;
+#ifdef MADV_HUGEPAGE
+    if (mode == HUGE_PAGES_TRY) {
+        madvise(region, *size, MADV_HUGEPAGE);  // 退而求其次：透明大页
+    }
+#endif
+    return region;
 }
 
-void init_page_cache() {
+bool init_page_cache(int nbuffers, HugePagesMode huge_pages) {
+    destroy_page_cache();
     memset(&global_page_cache, 0, sizeof(global_page_cache));
+    if (nbuffers < MIN_SHARED_BUFFERS) nbuffers = MIN_SHARED_BUFFERS;
+
+    // 页面数组放在区域开头（按页对齐），描述符数组紧随其后
+    size_t pages_size = (size_t)nbuffers * sizeof(Page);
+    pages_size = (pages_size + PAGE_SIZE - 1) & ~((size_t)PAGE_SIZE - 1);
+    size_t region_size = pages_size + (size_t)nbuffers * sizeof(BufferDesc);
+    bool huge = false;
+    void* region = page_cache_alloc_region(&region_size, huge_pages, &huge);
+    if (!region) {
+        return false;
+    }
+    global_page_cache.region = region;
+    global_page_cache.region_size = region_size;
+    global_page_cache.huge_pages = huge;
+    global_page_cache.pages = (Page*)region;
+    global_page_cache.descriptors = (BufferDesc*)((char*)region + pages_size);
+    global_page_cache.nbuffers = nbuffers;
+
     //pthread_mutex_init(&global_page_cache.lock, NULL);
-     for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        global_page_cache.entries[i].dirty=false;
-        global_page_cache.entries[i].valid=false;
-        LWLockInit(&global_page_cache.entries[i].page.lock, TRANCHE_PAGE_LOCK);
+     for (int i = 0; i < nbuffers; i++) {
+        BufferDesc* desc = &global_page_cache.descriptors[i];
+        desc->buf_id = i;
+        atomic_init(&desc->refcount, 0);
+        atomic_flag_clear(&desc->hdr_lock);
+        desc->dirty = false;
+        desc->valid = false;
+        desc->usage_count = 0;
+        desc->free_next = (i + 1 < nbuffers) ? i + 1 : -1;
+        LWLockInit(&desc->io_lock, TRANCHE_PAGE_LOCK);
+        LWLockInit(&desc->content_lock, TRANCHE_PAGE_LOCK);
     }
-    LWLockInit(&global_page_cache.lock, TRANCHE_PAGE_LOCK);  // 全局锁也初始化
+    global_page_cache.first_free = 0;
+    atomic_init(&global_page_cache.next_victim, 0);
+    if (!buf_table_init(&global_page_cache.mapping, nbuffers)) {
+        fprintf(stderr, "init_page_cache: failed to allocate buffer mapping table\n");
+        destroy_page_cache();
+        return false;
+    }
+    for (int i = 0; i < NUM_BUFFER_PARTITIONS; i++) {
+        LWLockInit(&global_page_cache.partition_locks[i].lock, TRANCHE_PAGE_LOCK);
+    }
+    LWLockInit(&global_page_cache.strategy_lock, TRANCHE_PAGE_LOCK);
+    printf("Page cache initialized: %d buffers (%zu kB, huge pages %s)\n",
+           nbuffers, region_size / 1024, huge ? "on" : "off");
+    return true;
+}
 
+void destroy_page_cache() {
+    if (global_page_cache.region) {
+        munmap(global_page_cache.region, global_page_cache.region_size);
+    }
+    buf_table_destroy(&global_page_cache.mapping);
+    global_page_cache.region = NULL;
+    global_page_cache.pages = NULL;
+    global_page_cache.descriptors = NULL;
+    global_page_cache.nbuffers = 0;
+}
 
+#define BufferGetDescriptor(buffer) (&global_page_cache.descriptors[(buffer) - 1])
+#define BufferDescriptorGetPage(desc) (&global_page_cache.pages[(desc)->buf_id])
+#define BufferDescriptorGetBuffer(desc) ((desc)->buf_id + 1)
+#define BufMappingPartitionLock(hashcode) \
+    (&global_page_cache.partition_locks[BufTableHashPartition(hashcode)].lock)
+#define FREENEXT_END_OF_LIST (-1)
+#define FREENEXT_NOT_IN_LIST (-2)
+#define page_cache_count(counter) \
+    atomic_fetch_add_explicit(&global_page_cache.stats.counter, 1, memory_order_relaxed)
 
+/*
+ * 加锁顺序：io_lock -> 内容锁 -> 分区锁 -> 描述符头锁。
+ * 描述符头锁只保护几个字段的短暂读写，持有期间不做 I/O、不取其他锁。
+ */
+static inline void LockBufHdr(BufferDesc* desc) {
+    while (atomic_flag_test_and_set_explicit(&desc->hdr_lock, memory_order_acquire)) {
+        sched_yield();
+    }
+}
 
+static inline void UnlockBufHdr(BufferDesc* desc) {
+    atomic_flag_clear_explicit(&desc->hdr_lock, memory_order_release);
 }
 
-Page* page_cache_get(uint32_t oid, TableMeta* meta, FILE* table_file) {
-    //pthread_mutex_lock(&global_page_cache.lock);
-      LWLockAcquireExclusive(&global_page_cache.lock);
-    // 查找缓存
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        if (global_page_cache.entries[i].valid && global_page_cache.entries[i].oid == oid) {
-            //pthread_mutex_unlock(&global_page_cache.lock);
-            LWLockRelease(&global_page_cache.lock);
-            return &global_page_cache.entries[i].page;
-        }
+/*
+ * 写回一个已 pin 的缓冲区，返回 1 表示写了一页，0 表示不脏，-1 表示失败。
+ * 在共享内容锁下拷贝页面并清除脏标记，之后的修改会重新置脏；I/O 不持有其他锁。
+ */
+static int page_cache_sync_pinned(BufferDesc* desc) {
+    Page* page = BufferDescriptorGetPage(desc);
+    Page copy;
+    bool dirty = false;
+
+    LWLockAcquireExclusive(&desc->io_lock);
+    LWLockAcquireShared(&desc->content_lock);
+    LockBufHdr(desc);
+    if (desc->dirty) {
+        desc->dirty = false;
+        dirty = true;
     }
+    UnlockBufHdr(desc);
+    if (dirty) {
+        copy = *page;
+    }
+    LWLockRelease(&desc->content_lock);
 
-    // 没命中，从磁盘读取
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        if (!global_page_cache.entries[i].valid) {
-            long offset = (long)oid * sizeof(Page);
-            fseek(table_file, offset, SEEK_SET);
-            fread(&global_page_cache.entries[i].page, sizeof(Page), 1, table_file);
-            global_page_cache.entries[i].oid = oid;
-            global_page_cache.entries[i].valid = true;
-            global_page_cache.entries[i].dirty = false;
+    int result = 0;
+    if (dirty) {
+        result = 1;
+        if (!smgr_write(desc->tag.rel_oid, desc->tag.page_id, &copy)) {
+            LockBufHdr(desc);
+            desc->dirty = true;
+            UnlockBufHdr(desc);
+            result = -1;
+        }
+    }
+    LWLockRelease(&desc->io_lock);
+    return result;
+}
 
-            //pthread_mutex_unlock(&global_page_cache.lock);
-             LWLockRelease(&global_page_cache.lock);
-            return &global_page_cache.entries[i].page;
+// pin 住缓冲区并提升使用计数；按访问策略读取的页最多计为 1，不会因扫描变成热点
+static void page_cache_pin(BufferDesc* desc, BufferAccessStrategy strategy) {
+    LockBufHdr(desc);
+    atomic_fetch_add(&desc->refcount, 1);
+    if (!strategy) {
+        if (desc->usage_count < BM_MAX_USAGE_COUNT) {
+            desc->usage_count++;
         }
+    } else if (desc->usage_count == 0) {
+        desc->usage_count = 1;
     }
+    UnlockBufHdr(desc);
+}
 
-    //pthread_mutex_unlock(&global_page_cache.lock);
-    LWLockRelease(&global_page_cache.lock);
-    return NULL;  // 缓存满未命中
+// 把未映射的缓冲区放回空闲链表（已在链表中则不重复加入）并释放 pin
+static void page_cache_free_buffer(BufferDesc* desc) {
+    LWLockAcquireExclusive(&global_page_cache.strategy_lock);
+    if (desc->free_next == FREENEXT_NOT_IN_LIST) {
+        desc->free_next = global_page_cache.first_free;
+        global_page_cache.first_free = desc->buf_id;
+    }
+    LWLockRelease(&global_page_cache.strategy_lock);
+    atomic_fetch_sub(&desc->refcount, 1);
 }
-//page_id
-void page_cache_mark_dirty(uint32_t page_id) {
-    LWLockAcquireExclusive(&global_page_cache.lock);
 
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        PageCacheEntry* entry = &global_page_cache.entries[i];
-        if (entry->valid && entry->page.header.page_id == page_id) {
-            entry->dirty = true;
-            break;
+// 从空闲链表取一个缓冲区并 pin 住；链表中的项可能已被 clock-sweep 拿走，需重新检查
+static BufferDesc* page_cache_pop_free(void) {
+    while (true) {
+        LWLockAcquireExclusive(&global_page_cache.strategy_lock);
+        int slot = global_page_cache.first_free;
+        if (slot < 0) {
+            LWLockRelease(&global_page_cache.strategy_lock);
+            return NULL;
         }
-    }
+        BufferDesc* desc = &global_page_cache.descriptors[slot];
+        global_page_cache.first_free = desc->free_next;
+        desc->free_next = FREENEXT_NOT_IN_LIST;
+        LWLockRelease(&global_page_cache.strategy_lock);
 
-    LWLockRelease(&global_page_cache.lock);
+        LockBufHdr(desc);
+        if (atomic_load(&desc->refcount) == 0 && !desc->valid) {
+            atomic_store(&desc->refcount, 1);
+            UnlockBufHdr(desc);
+            return desc;
+        }
+        UnlockBufHdr(desc);
+    }
 }
-Page* page_cache_load_or_fetch(uint32_t page_id, const char* filename) {
-    LWLockAcquireExclusive(&global_page_cache.lock);
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        if (global_page_cache.entries[i].valid && global_page_cache.entries[i].page.header.page_id == page_id) {
-            LWLockRelease(&global_page_cache.lock);
-            return &global_page_cache.entries[i].page;
+
+/*
+ * 淘汰已由调用方在描述符头锁下 pin 住（refcount 置 1）的缓冲区中的页面。
+ * 脏页先写回，写回失败则放弃；删除旧映射时持有旧标签所在分区的排他锁并重新检查，
+ * 期间有人 pin 住或弄脏了它则放弃，保证被淘汰的页没有其他使用者。
+ * 成功时缓冲区不在映射表中且仍被 pin 住，失败时释放 pin 并返回 false。
+ */
+static bool page_cache_evict_pinned(BufferDesc* victim, bool valid, bool dirty, BufferTag old_tag) {
+    // 无效的缓冲区不在映射表中，可直接使用
+    if (!valid) {
+        return true;
+    }
+
+    if (dirty) {
+        if (page_cache_sync_pinned(victim) < 0) {
+            atomic_fetch_sub(&victim->refcount, 1);
+            return false;
         }
+        page_cache_count(dirty_writebacks);
     }
-    FILE* fp = fopen(filename, "r+b");
-    if (!fp) {
-        perror("fopen failed");
-        LWLockRelease(&global_page_cache.lock);
-        return NULL;
+
+    uint32_t old_hash = buf_table_hash_code(&old_tag);
+    LWLock* partition_lock = BufMappingPartitionLock(old_hash);
+    LWLockAcquireExclusive(partition_lock);
+    LockBufHdr(victim);
+    if (atomic_load(&victim->refcount) == 1 && !victim->dirty) {
+        victim->valid = false;
+        victim->usage_count = 0;
+        UnlockBufHdr(victim);
+        buf_table_delete(&global_page_cache.mapping, &old_tag, old_hash);
+        LWLockRelease(partition_lock);
+        page_cache_count(evictions);
+        return true;
+    }
+    UnlockBufHdr(victim);
+    LWLockRelease(partition_lock);
+    atomic_fetch_sub(&victim->refcount, 1);
+    return false;
+}
+
+/*
+ * 从访问策略的环中取下一个缓冲区：只有未被 pin 且使用计数不超过 1
+ * （即只被本策略用过）的缓冲区才能复用，否则返回 NULL，由调用方另取一个放入环中。
+ */
+static BufferDesc* page_cache_get_from_ring(BufferAccessStrategy strategy) {
+    if (++strategy->current >= strategy->nbuffers) {
+        strategy->current = 0;
     }
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    if ((long)(page_id * sizeof(Page)) >= file_size) {
-        fclose(fp);
-        LWLockRelease(&global_page_cache.lock);
+    Buffer buffer = strategy->buffers[strategy->current];
+    if (!BufferIsValid(buffer)) {
         return NULL;
     }
-    fseek(fp, page_id * sizeof(Page), SEEK_SET);
-    Page page;
-    if (fread(&page, sizeof(Page), 1, fp) != 1) {
-        fclose(fp);
-        LWLockRelease(&global_page_cache.lock);
+
+    BufferDesc* desc = BufferGetDescriptor(buffer);
+    LockBufHdr(desc);
+    if (atomic_load(&desc->refcount) > 0 || desc->usage_count > 1) {
+        UnlockBufHdr(desc);
         return NULL;
     }
-    fclose(fp);
-    int slot = -1;
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        if (!global_page_cache.entries[i].valid) {
-            slot = i;
-            break;
+    atomic_store(&desc->refcount, 1);
+    bool valid = desc->valid;
+    bool dirty = desc->dirty;
+    BufferTag old_tag = desc->tag;
+    UnlockBufHdr(desc);
+
+    return page_cache_evict_pinned(desc, valid, dirty, old_tag) ? desc : NULL;
+}
+
+/*
+ * 取一个可用缓冲区并 pin 住（refcount 为 1，不在映射表中）。
+ * 有访问策略时优先复用环中的缓冲区；否则用空闲链表，再否则执行 clock-sweep：
+ * 被 pin 住的缓冲区直接跳过；指针扫过的未 pin 有效项使用计数减一，
+ * 减到 0 的项成为牺牲者。新取得的缓冲区放入策略的环中。失败返回 NULL。
+ */
+static BufferDesc* page_cache_get_victim(BufferAccessStrategy strategy) {
+    BufferDesc* desc;
+    if (strategy) {
+        desc = page_cache_get_from_ring(strategy);
+        if (desc) {
+            return desc;
         }
     }
-    if (slot == -1) slot = rand() % PAGE_CACHE_SIZE;
 
-    global_page_cache.entries[slot].page = page;
-    global_page_cache.entries[slot].oid = page_id;
-    global_page_cache.entries[slot].valid = true;
-    global_page_cache.entries[slot].dirty = false;
+    desc = page_cache_pop_free();
+    if (!desc) {
+        // 最多扫 (BM_MAX_USAGE_COUNT + 1) 圈，保证计数能降到 0
+        int nbuffers = global_page_cache.nbuffers;
+        int max_steps = nbuffers * (BM_MAX_USAGE_COUNT + 2);
+        for (int step = 0; step < max_steps && !desc; step++) {
+            int slot = atomic_fetch_add(&global_page_cache.next_victim, 1) % nbuffers;
+            BufferDesc* victim = &global_page_cache.descriptors[slot];
 
-    LWLockRelease(&global_page_cache.lock);
-    return &global_page_cache.entries[slot].page;
-}
-
-bool page_cache_flush(uint32_t page_id, const char* filename) {
-    LWLockAcquireExclusive(&global_page_cache.lock);
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        if (global_page_cache.entries[i].valid && global_page_cache.entries[i].page.header.page_id == page_id) {
-            if (!global_page_cache.entries[i].dirty) {
-                LWLockRelease(&global_page_cache.lock);
-                return true;
+            LockBufHdr(victim);
+            if (atomic_load(&victim->refcount) > 0) {
+                UnlockBufHdr(victim);
+                continue;
             }
-            FILE* fp = fopen(filename, "r+b");
-            if (!fp) {
-                perror("flush fopen failed");
-                LWLockRelease(&global_page_cache.lock);
-                return false;
+            if (victim->valid && victim->usage_count > 0) {
+                victim->usage_count--;
+                UnlockBufHdr(victim);
+                continue;
             }
-            fseek(fp, page_id  * sizeof(Page), SEEK_SET);
-            if (fwrite(&global_page_cache.entries[i].page, sizeof(Page), 1, fp) != 1) {
-                fclose(fp);
-                LWLockRelease(&global_page_cache.lock);
-                return false;
+            atomic_store(&victim->refcount, 1);
+            bool valid = victim->valid;
+            bool dirty = victim->dirty;
+            BufferTag old_tag = victim->tag;
+            UnlockBufHdr(victim);
+
+            if (page_cache_evict_pinned(victim, valid, dirty, old_tag)) {
+                desc = victim;
             }
-            fflush(fp);  // ✅ 可选：确保数据立即写入磁盘
-            fclose(fp);
-            global_page_cache.entries[i].dirty = false;
-            LWLockRelease(&global_page_cache.lock);
-            return true;
         }
     }
-    LWLockRelease(&global_page_cache.lock);
-    return false;
+
+    if (!desc) {
+        fprintf(stderr, "page cache: no evictable page found (all pinned?)\n");
+        return NULL;
+    }
+    if (strategy) {
+        strategy->buffers[strategy->current] = BufferDescriptorGetBuffer(desc);
+    }
+    return desc;
+}
+
+// 等待其他线程装入页面；装入失败则释放 pin 并返回 InvalidBuffer
+static Buffer page_cache_wait_valid(BufferDesc* desc) {
+    LockBufHdr(desc);
+    bool valid = desc->valid;
+    UnlockBufHdr(desc);
+    if (!valid) {
+        // 装入方持有 io_lock 直到页面可用
+        LWLockAcquireExclusive(&desc->io_lock);
+        LWLockRelease(&desc->io_lock);
+        LockBufHdr(desc);
+        valid = desc->valid;
+        UnlockBufHdr(desc);
+    }
+    if (!valid) {
+        ReleaseBuffer(BufferDescriptorGetBuffer(desc));
+        return InvalidBuffer;
+    }
+    return BufferDescriptorGetBuffer(desc);
+}
+
+/*
+ * 开始读取一页：返回已 pin 的缓冲区。
+ * 查找只持有标签所在分区的共享锁；未命中时先取牺牲者，在分区排他锁下建立映射，
+ * 此时 *need_io 为 true，调用方持有 io_lock，须在锁外装入页面后调用
+ * page_cache_finish_read。同时装入同一页的线程只有一个会成功建立映射，
+ * 其余线程 pin 住已有的缓冲区，需经 page_cache_wait_valid 等待其装入完成。
+ */
+static Buffer page_cache_start_read(uint32_t rel_oid, PageID page_id, const char* filename,
+                                    BufferAccessStrategy strategy, bool* need_io) {
+    BufferTag tag;
+    INIT_BUFFER_TAG(tag, rel_oid, page_id);
+    uint32_t hashcode = buf_table_hash_code(&tag);
+    LWLock* partition_lock = BufMappingPartitionLock(hashcode);
+    *need_io = false;
+
+    LWLockAcquireShared(partition_lock);
+    int buf_id = buf_table_lookup(&global_page_cache.mapping, &tag, hashcode);
+    if (buf_id >= 0) {
+        BufferDesc* desc = &global_page_cache.descriptors[buf_id];
+        page_cache_pin(desc, strategy);
+        LWLockRelease(partition_lock);
+        page_cache_count(hits);
+        return BufferDescriptorGetBuffer(desc);
+    }
+    LWLockRelease(partition_lock);
+
+    if (filename) {
+        smgr_open(rel_oid, filename);
+    }
+    BufferDesc* desc = page_cache_get_victim(strategy);
+    if (!desc) {
+        return InvalidBuffer;
+    }
+    LWLockAcquireExclusive(&desc->io_lock);
+
+    LWLockAcquireExclusive(partition_lock);
+    buf_id = buf_table_insert(&global_page_cache.mapping, &tag, hashcode, desc->buf_id);
+    if (buf_id >= 0) {
+        // 其他线程抢先装入了同一页
+        BufferDesc* existing = &global_page_cache.descriptors[buf_id];
+        page_cache_pin(existing, strategy);
+        LWLockRelease(partition_lock);
+        LWLockRelease(&desc->io_lock);
+        page_cache_free_buffer(desc);
+        page_cache_count(hits);
+        return BufferDescriptorGetBuffer(existing);
+    }
+    LockBufHdr(desc);
+    desc->tag = tag;
+    desc->valid = false;
+    desc->dirty = false;
+    desc->usage_count = 1;
+    UnlockBufHdr(desc);
+    LWLockRelease(partition_lock);
+
+    *need_io = true;
+    return BufferDescriptorGetBuffer(desc);
 }
 
+// 结束 page_cache_start_read 发起的装入并释放 io_lock；装入失败时撤销映射
+static Buffer page_cache_finish_read(BufferDesc* desc, bool ok, bool extend) {
+    if (!ok) {
+        BufferTag tag = desc->tag;
+        uint32_t hashcode = buf_table_hash_code(&tag);
+        LWLock* partition_lock = BufMappingPartitionLock(hashcode);
+        LWLockAcquireExclusive(partition_lock);
+        buf_table_delete(&global_page_cache.mapping, &tag, hashcode);
+        LWLockRelease(partition_lock);
+        LWLockRelease(&desc->io_lock);
+        page_cache_free_buffer(desc);
+        return InvalidBuffer;
+    }
 
-Page* old_page_cache_load_or_fetch(uint32_t oid, const char* filename) {
-    //pthread_mutex_lock(&global_page_cache.lock);
-    LWLockAcquireExclusive(&global_page_cache.lock);
+    LockBufHdr(desc);
+    desc->valid = true;
+    desc->dirty = extend;
+    UnlockBufHdr(desc);
+    LWLockRelease(&desc->io_lock);
+    if (!extend) {
+        page_cache_count(misses);
+    }
+    return BufferDescriptorGetBuffer(desc);
+}
 
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        PageCacheEntry* entry = &global_page_cache.entries[i];
-        if (entry->valid && entry->oid == oid) {
-            //pthread_mutex_unlock(&global_page_cache.lock);
-            LWLockRelease(&global_page_cache.lock);
-            return &entry->page;
+Buffer ReadBufferExtended(uint32_t rel_oid, PageID page_id, const char* filename,
+                          ReadBufferMode mode, BufferAccessStrategy strategy) {
+    bool extend = mode == RBM_ZERO;
+    bool need_io;
+    Buffer buffer = page_cache_start_read(rel_oid, page_id, filename, strategy, &need_io);
+    if (!BufferIsValid(buffer)) {
+        return InvalidBuffer;
+    }
+    BufferDesc* desc = BufferGetDescriptor(buffer);
+    if (!need_io) {
+        buffer = page_cache_wait_valid(desc);
+        if (extend && BufferIsValid(buffer)) {
+            // 清理截断表尾时仍被 pin 住的页保留了映射，内容已过时，同样初始化为空页
+            LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+            page_init(BufferGetPage(buffer), page_id);
+            MarkBufferDirty(buffer);
+            LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
         }
+        return buffer;
     }
 
-    // 没找到，装入缓存
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        PageCacheEntry* entry = &global_page_cache.entries[i];
-        if (!entry->valid) {
-            //char file_path[MAX_NAME_LEN * 2];
-          //  snprintf(file_path, sizeof(file_path), "%s/%s.tbl", DATADIR,filename);
-            FILE* file = fopen(filename, "r+b");
-            if (!file) {
-                perror("Failed to open file for page cache fetch");
-                //pthread_mutex_unlock(&global_page_cache.lock);
-                 LWLockRelease(&global_page_cache.lock);
-                return NULL;
-            }
+    Page* page = BufferDescriptorGetPage(desc);
+    bool ok = true;
+    if (extend) {
+        page_init(page, page_id);
+    } else {
+        ok = smgr_read(rel_oid, page_id, page);
+    }
+    return page_cache_finish_read(desc, ok, extend);
+}
 
-            if (fseek(file, oid * sizeof(Page), SEEK_SET) != 0) {
-                perror("fseek error");
-                fclose(file);
-                //pthread_mutex_unlock(&global_page_cache.lock);
-                 LWLockRelease(&global_page_cache.lock);
-                return NULL;
-            }
+Buffer ReadBufferIfCached(uint32_t rel_oid, PageID page_id) {
+    BufferTag tag;
+    INIT_BUFFER_TAG(tag, rel_oid, page_id);
+    uint32_t hashcode = buf_table_hash_code(&tag);
+    LWLock* partition_lock = BufMappingPartitionLock(hashcode);
 
-            if (fread(&entry->page, sizeof(Page), 1, file) != 1) {
-                perror("fread error");
-                fclose(file);
-               // pthread_mutex_unlock(&global_page_cache.lock);
-                LWLockRelease(&global_page_cache.lock);
-                return NULL;
-            }
+    LWLockAcquireShared(partition_lock);
+    int buf_id = buf_table_lookup(&global_page_cache.mapping, &tag, hashcode);
+    if (buf_id < 0) {
+        LWLockRelease(partition_lock);
+        return InvalidBuffer;
+    }
+    BufferDesc* desc = &global_page_cache.descriptors[buf_id];
+    page_cache_pin(desc, NULL);
+    LWLockRelease(partition_lock);
+    page_cache_count(hits);
+    return page_cache_wait_valid(desc);
+}
+
+Buffer ReadBuffer(uint32_t rel_oid, PageID page_id, const char* filename) {
+    return ReadBufferExtended(rel_oid, page_id, filename, RBM_NORMAL, NULL);
+}
+
+Buffer ReadBufferNew(uint32_t rel_oid, PageID page_id, const char* filename) {
+    return ReadBufferExtended(rel_oid, page_id, filename, RBM_ZERO, NULL);
+}
+
+#define BULKREAD_RING_SIZE (256 * 1024 / PAGE_SIZE)
+#define BULKWRITE_RING_SIZE (16 * 1024 * 1024 / PAGE_SIZE)
+
+BufferAccessStrategy GetAccessStrategy(BufferAccessStrategyType type) {
+    int ring_size = type == BAS_BULKWRITE ? BULKWRITE_RING_SIZE : BULKREAD_RING_SIZE;  // BAS_VACUUM 同 BULKREAD
+    if (ring_size > global_page_cache.nbuffers / 8) {
+        ring_size = global_page_cache.nbuffers / 8;
+    }
+    if (ring_size < 1) ring_size = 1;
+
+    BufferAccessStrategy strategy = calloc(1, sizeof(BufferAccessStrategyData) + ring_size * sizeof(Buffer));
+    if (!strategy) return NULL;
+    strategy->type = type;
+    strategy->nbuffers = ring_size;
+    strategy->current = 0;
+    return strategy;
+}
+
+BufferAccessStrategy GetScanAccessStrategy(uint32_t nblocks) {
+    if (nblocks <= (uint32_t)global_page_cache.nbuffers / 4) {
+        return NULL;
+    }
+    return GetAccessStrategy(BAS_BULKREAD);
+}
+
+void FreeAccessStrategy(BufferAccessStrategy strategy) {
+    free(strategy);
+}
+
+void ReleaseBuffer(Buffer buffer) {
+    if (!BufferIsValid(buffer)) return;
+    BufferDesc* desc = BufferGetDescriptor(buffer);
+    unsigned int prev = atomic_fetch_sub(&desc->refcount, 1);
+    assert(prev > 0);
+    (void)prev;
+}
+
+Page* BufferGetPage(Buffer buffer) {
+    if (!BufferIsValid(buffer)) return NULL;
+    return BufferDescriptorGetPage(BufferGetDescriptor(buffer));
+}
+
+void LockBuffer(Buffer buffer, int mode) {
+    if (!BufferIsValid(buffer)) return;
+    BufferDesc* desc = BufferGetDescriptor(buffer);
+    assert(atomic_load(&desc->refcount) > 0);
+    if (mode == BUFFER_LOCK_UNLOCK) {
+        LWLockRelease(&desc->content_lock);
+    } else if (mode == BUFFER_LOCK_SHARE) {
+        LWLockAcquireShared(&desc->content_lock);
+    } else {
+        LWLockAcquireExclusive(&desc->content_lock);
+    }
+}
+
+void MarkBufferDirty(Buffer buffer) {
+    if (!BufferIsValid(buffer)) return;
+    BufferDesc* desc = BufferGetDescriptor(buffer);
+    assert(atomic_load(&desc->refcount) > 0);
+    LockBufHdr(desc);
+    desc->dirty = true;
+    UnlockBufHdr(desc);
+}
+
+bool FlushBuffer(Buffer buffer) {
+    if (!BufferIsValid(buffer)) return false;
+    BufferDesc* desc = BufferGetDescriptor(buffer);
+    assert(atomic_load(&desc->refcount) > 0);
+    return page_cache_sync_pinned(desc) >= 0;
+}
+
+// 待写回的脏缓冲区，按标签排序后顺序写，使 I/O 尽量连续
+typedef struct BufferSyncItem {
+    BufferTag tag;
+    int buf_id;
+} BufferSyncItem;
 
-            fclose(file);
-            entry->oid = oid;
-            entry->valid = true;
-            entry->dirty = false;
-            // 初始化页面锁
-            entry->page.lock.state = 0;
-            //pthread_mutex_unlock(&global_page_cache.lock);
-            LWLockRelease(&global_page_cache.lock);
-            return &entry->page;
+static int buffer_sync_item_cmp(const void* a, const void* b) {
+    const BufferTag* ta = &((const BufferSyncItem*)a)->tag;
+    const BufferTag* tb = &((const BufferSyncItem*)b)->tag;
+    if (ta->rel_oid != tb->rel_oid) return ta->rel_oid < tb->rel_oid ? -1 : 1;
+    if (ta->page_id != tb->page_id) return ta->page_id < tb->page_id ? -1 : 1;
+    return 0;
+}
+
+// 写回脏缓冲区（rel_oid 为 0 时写回所有表），failed 返回写失败的页数
+static int page_cache_sync_dirty(int max_pages, uint32_t rel_oid, int* failed) {
+    *failed = 0;
+    int nbuffers = global_page_cache.nbuffers;
+    BufferSyncItem* items = malloc(nbuffers * sizeof(BufferSyncItem));
+    if (!items) return 0;
+
+    int count = 0;
+    for (int i = 0; i < nbuffers; i++) {
+        BufferDesc* desc = &global_page_cache.descriptors[i];
+        LockBufHdr(desc);
+        if (desc->valid && desc->dirty && (rel_oid == 0 || desc->tag.rel_oid == rel_oid)) {
+            items[count].tag = desc->tag;
+            items[count].buf_id = i;
+            count++;
         }
+        UnlockBufHdr(desc);
     }
+    qsort(items, count, sizeof(BufferSyncItem), buffer_sync_item_cmp);
+
+    int written = 0;
+    for (int i = 0; i < count && (max_pages <= 0 || written < max_pages); i++) {
+        BufferDesc* desc = &global_page_cache.descriptors[items[i].buf_id];
 
-    //pthread_mutex_unlock(&global_page_cache.lock);
-    LWLockRelease(&global_page_cache.lock);
-    fprintf(stderr, "Page cache full, cannot load page with oid=%u\n", oid);
-    return NULL;
+        // 收集之后缓冲区可能已被淘汰或复用，pin 之前重新确认
+        LockBufHdr(desc);
+        if (!desc->valid || !desc->dirty || !BUFFER_TAGS_EQUAL(&desc->tag, &items[i].tag)) {
+            UnlockBufHdr(desc);
+            continue;
+        }
+        atomic_fetch_add(&desc->refcount, 1);  // 不提升使用计数
+        UnlockBufHdr(desc);
+
+        int result = page_cache_sync_pinned(desc);
+        if (result > 0) {
+            written++;
+        } else if (result < 0) {
+            (*failed)++;
+        }
+        ReleaseBuffer(BufferDescriptorGetBuffer(desc));
+    }
+    free(items);
+
+    atomic_fetch_add(&global_page_cache.stats.buffers_written, written);
+    return written;
 }
 
-bool old_flush_page_cache(uint32_t oid, const char* filename) {
-    LWLockAcquireExclusive(&global_page_cache.lock);
-    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
-        if (global_page_cache.entries[i].valid && global_page_cache.entries[i].oid == oid) {
-            if (!global_page_cache.entries[i].dirty) {
-                LWLockRelease(&global_page_cache.lock);
-                return true;
-            }
-            //char file_path[MAX_NAME_LEN * 2];
-            //snprintf(file_path, sizeof(file_path), "%s/%s.tbl", DATADIR,filename);
-           // FILE* file = fopen(file_path, "rb");
-            FILE* fp = fopen(filename, "r+b");
-            if (!fp) {
-                perror("flush fopen failed");
-                LWLockRelease(&global_page_cache.lock);
-                return false;
+int BgBufferSync(int max_pages) {
+    int failed;
+    return page_cache_sync_dirty(max_pages, 0, &failed);
+}
+
+bool FlushAllBuffers() {
+    int failed;
+    page_cache_sync_dirty(0, 0, &failed);
+    return failed == 0;
+}
+
+bool FlushRelationBuffers(uint32_t rel_oid) {
+    int failed;
+    page_cache_sync_dirty(0, rel_oid, &failed);
+    return failed == 0;
+}
+
+void DropRelationBuffers(uint32_t rel_oid, PageID first_page) {
+    for (int i = 0; i < global_page_cache.nbuffers; i++) {
+        BufferDesc* desc = &global_page_cache.descriptors[i];
+        LockBufHdr(desc);
+        BufferTag tag = desc->tag;
+        bool match = desc->valid && tag.rel_oid == rel_oid && tag.page_id >= first_page;
+        UnlockBufHdr(desc);
+        if (!match) continue;
+
+        // 与淘汰相同：持有分区排他锁删除映射，期间标签可能已变，需重新检查
+        uint32_t hash = buf_table_hash_code(&tag);
+        LWLock* partition_lock = BufMappingPartitionLock(hash);
+        LWLockAcquireExclusive(partition_lock);
+        LockBufHdr(desc);
+        if (!desc->valid || !BUFFER_TAGS_EQUAL(&desc->tag, &tag)) {
+            UnlockBufHdr(desc);
+            LWLockRelease(partition_lock);
+            continue;
+        }
+        desc->dirty = false;
+        if (atomic_load(&desc->refcount) > 0) {
+            UnlockBufHdr(desc);
+            LWLockRelease(partition_lock);
+            continue;
+        }
+        desc->valid = false;
+        desc->usage_count = 0;
+        atomic_store(&desc->refcount, 1);
+        UnlockBufHdr(desc);
+        buf_table_delete(&global_page_cache.mapping, &tag, hash);
+        LWLockRelease(partition_lock);
+        page_cache_free_buffer(desc);
+    }
+}
+
+// ========== 顺序扫描读流 ==========
+
+#define READ_STREAM_SPIN_RETRIES 1000    // 缓冲池耗尽时先让出 CPU 重试的次数
+#define READ_STREAM_MAX_SLEEP_US 10000   // 之后改为睡眠等待，间隔逐次翻倍到此值
+#define READ_STREAM_MAX_WAIT_US 1000000  // 睡眠等待的总时长上限，超过后放弃这一页
+
+void read_stream_begin(ReadStream* stream, uint32_t rel_oid, const char* filename,
+                       PageID first_page, PageID last_page, int max_distance,
+                       BufferAccessStrategy strategy) {
+    // 预读的缓冲区一直 pin 到被取出，不能占满缓冲池，也不能占满策略的环
+    int limit = strategy ? strategy->nbuffers / 2 : global_page_cache.nbuffers / 4;
+    if (max_distance > limit) max_distance = limit;
+    if (max_distance > MAX_PREFETCH_DISTANCE) max_distance = MAX_PREFETCH_DISTANCE;
+    if (max_distance < 1) max_distance = 1;
+
+    stream->rel_oid = rel_oid;
+    stream->filename = filename;
+    stream->next_page = first_page;
+    stream->end_page = last_page;
+    stream->distance = 1;
+    stream->max_distance = max_distance;
+    stream->strategy = strategy;
+    stream->head = 0;
+    stream->count = 0;
+    if (first_page == INVALID_PAGE_ID || last_page == INVALID_PAGE_ID || first_page > last_page) {
+        stream->next_page = 1;
+        stream->end_page = 0;
+    }
+}
+
+/*
+ * 发起一批读请求：命中的页直接入队，未命中的页由本线程装入。
+ * 本批所有读请求一起提交，全部完成后才返回，保证返回时不持有 io_lock。
+ */
+static void read_stream_fill(ReadStream* stream) {
+    SMgrIO ios[MAX_PREFETCH_DISTANCE];
+    int io_slots[MAX_PREFETCH_DISTANCE];
+    int nios = 0;
+    int retries = 0;
+    int sleep_us = 100;
+    long waited_us = 0;
+
+    stream->head = 0;
+    stream->count = 0;
+    while (stream->count < stream->distance && stream->next_page <= stream->end_page) {
+        PageID page_id = stream->next_page;
+        bool need_io;
+        Buffer buffer = page_cache_start_read(stream->rel_oid, page_id, stream->filename,
+                                              stream->strategy, &need_io);
+        if (!BufferIsValid(buffer) && !need_io) {
+            /*
+             * 没有可用缓冲区（多半被其他扫描的预读 pin 住）：缩小预读距离，
+             * 先处理已入队的页；队列为空时等其他线程释放 pin 后重试。
+             * 不能轻易把这一页当作不存在跳过，否则扫描、UPDATE 和回滚会漏掉整页；
+             * 但 pin 可能正被等待本扫描的线程持有，等待超过上限后按读失败处理，
+             * 返回 InvalidBuffer，不无限等下去。
+             */
+            stream->distance = 1;
+            if (stream->count > 0) break;
+            if (++retries < READ_STREAM_SPIN_RETRIES) {
+                sched_yield();
+                continue;
             }
-            fseek(fp, oid * sizeof(Page), SEEK_SET);
-            if (fwrite(&global_page_cache.entries[i].page, sizeof(Page), 1, fp) != 1) {
-                fclose(fp);
-                LWLockRelease(&global_page_cache.lock);
-                return false;
+            if (waited_us < READ_STREAM_MAX_WAIT_US) {
+                struct timespec ts = { 0, (long)sleep_us * 1000 };
+                nanosleep(&ts, NULL);
+                waited_us += sleep_us;
+                if (sleep_us < READ_STREAM_MAX_SLEEP_US) sleep_us *= 2;
+                continue;
             }
-            fclose(fp);
-            global_page_cache.entries[i].dirty = false;
-            LWLockRelease(&global_page_cache.lock);
-            return true;
+            fprintf(stderr, "read stream: no free buffer for page %u of relation %u, giving up\n",
+                    page_id, stream->rel_oid);
+            retries = 0;
+            sleep_us = 100;
+            waited_us = 0;
         }
+        stream->next_page++;
+
+        ReadStreamEntry* entry = &stream->entries[stream->count++];
+        entry->buffer = buffer;
+        entry->page_id = page_id;
+        entry->wait = BufferIsValid(buffer) && !need_io;
+        if (!need_io) {
+            if (stream->distance > 1) stream->distance--;
+            continue;
+        }
+
+        BufferDesc* desc = BufferGetDescriptor(buffer);
+        if (smgr_start_read(stream->rel_oid, page_id, BufferDescriptorGetPage(desc), &ios[nios])) {
+            io_slots[nios++] = stream->count - 1;
+        } else {
+            entry->buffer = page_cache_finish_read(desc, false, false);
+        }
+        stream->distance *= 2;
+        if (stream->distance > stream->max_distance) stream->distance = stream->max_distance;
     }
-    LWLockRelease(&global_page_cache.lock);
-    return false;
-}
\ No newline at end of file
+
+    smgr_submit();
+    for (int i = 0; i < nios; i++) {
+        ReadStreamEntry* entry = &stream->entries[io_slots[i]];
+        bool ok = smgr_finish_read(&ios[i]);
+        entry->buffer = page_cache_finish_read(BufferGetDescriptor(entry->buffer), ok, false);
+    }
+}
+
+bool read_stream_next(ReadStream* stream, Buffer* buffer, PageID* page_id) {
+    if (stream->head >= stream->count) {
+        if (stream->next_page > stream->end_page) {
+            return false;
+        }
+        read_stream_fill(stream);
+    }
+
+    ReadStreamEntry* entry = &stream->entries[stream->head++];
+    if (entry->wait) {
+        entry->buffer = page_cache_wait_valid(BufferGetDescriptor(entry->buffer));
+    }
+    *buffer = entry->buffer;
+    if (page_id) *page_id = entry->page_id;
+    return true;
+}
+
+void read_stream_end(ReadStream* stream) {
+    while (stream->head < stream->count) {
+        ReleaseBuffer(stream->entries[stream->head++].buffer);
+    }
+    stream->next_page = 1;
+    stream->end_page = 0;
+}
+
+int page_cache_get_resident_tags(BufferTag* tags, int max_tags) {
+    int count = 0;
+    for (int i = 0; i < global_page_cache.nbuffers && count < max_tags; i++) {
+        BufferDesc* desc = &global_page_cache.descriptors[i];
+        LockBufHdr(desc);
+        if (desc->valid) {
+            tags[count++] = desc->tag;
+        }
+        UnlockBufHdr(desc);
+    }
+    return count;
+}
+
+bool page_cache_have_free_buffer() {
+    LWLockAcquireShared(&global_page_cache.strategy_lock);
+    bool have_free = global_page_cache.first_free >= 0;
+    LWLockRelease(&global_page_cache.strategy_lock);
+    return have_free;
+}
+
+void page_cache_get_stats(PageCacheStats* out) {
+    out->hits = atomic_load(&global_page_cache.stats.hits);
+    out->misses = atomic_load(&global_page_cache.stats.misses);
+    out->evictions = atomic_load(&global_page_cache.stats.evictions);
+    out->dirty_writebacks = atomic_load(&global_page_cache.stats.dirty_writebacks);
+    out->buffers_written = atomic_load(&global_page_cache.stats.buffers_written);
+}
+
+// 命中率 = hits / (hits + misses)，尚无访问时返回 0
+double page_cache_hit_ratio() {
+    PageCacheStats stats;
+    page_cache_get_stats(&stats);
+    uint64_t total = stats.hits + stats.misses;
+    return total ? (double)stats.hits / (double)total : 0.0;
+}
+
+void page_cache_print_stats() {
+    PageCacheStats stats;
+    page_cache_get_stats(&stats);
+    uint64_t total = stats.hits + stats.misses;
+    printf("\nPage Cache Status:\n");
+    printf("  Hits: %llu, Misses: %llu, Hit ratio: %.2f%%\n",
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           total ? 100.0 * (double)stats.hits / (double)total : 0.0);
+    printf("  Evictions: %llu (dirty writebacks: %llu)\n",
+           (unsigned long long)stats.evictions, (unsigned long long)stats.dirty_writebacks);
+    printf("  Buffers written by bgwriter/checkpoint: %llu\n",
+           (unsigned long long)stats.buffers_written);
+}
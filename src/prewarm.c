@@ -0,0 +1,235 @@
+#include "prewarm.h"
+#include "page.h"
+#include "smgr.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+// 预热线程状态
+static struct {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;   // 用于提前唤醒以便退出
+    bool running;
+    bool stop_requested;
+    int interval_ms;
+    char data_dir[256];
+} autoprewarm = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static int buffer_tag_cmp(const void* a, const void* b) {
+    const BufferTag* x = a;
+    const BufferTag* y = b;
+    if (x->rel_oid != y->rel_oid) return x->rel_oid < y->rel_oid ? -1 : 1;
+    if (x->page_id != y->page_id) return x->page_id < y->page_id ? -1 : 1;
+    return 0;
+}
+
+static bool autoprewarm_stop_requested(void) {
+    pthread_mutex_lock(&autoprewarm.mutex);
+    bool stop = autoprewarm.stop_requested;
+    pthread_mutex_unlock(&autoprewarm.mutex);
+    return stop;
+}
+
+/*
+ * 表文件相对数据目录的路径，表未在存储管理层登记时返回 false。
+ * 表 OID 每次启动按目录顺序重新分配，转储中只能记表文件名。
+ */
+static bool autoprewarm_relname(const char* data_dir, uint32_t rel_oid, char* name, size_t size) {
+    char path[SMGR_MAX_PATH];
+    if (!smgr_relpath(rel_oid, path, sizeof(path))) return false;
+    size_t len = strlen(data_dir);
+    const char* relname = path;
+    if (strncmp(path, data_dir, len) == 0 && path[len] == '/') relname = path + len + 1;
+    snprintf(name, size, "%s", relname);
+    return true;
+}
+
+int autoprewarm_dump(const char* data_dir) {
+    int nbuffers = global_page_cache.nbuffers;
+    BufferTag* tags = malloc((size_t)nbuffers * sizeof(BufferTag));
+    if (!tags) return -1;
+    int ntags = page_cache_get_resident_tags(tags, nbuffers);
+    qsort(tags, ntags, sizeof(BufferTag), buffer_tag_cmp);
+
+    // 去掉没有登记文件的表（已删除）的页
+    char name[SMGR_MAX_PATH];
+    int count = 0;
+    bool registered = false;
+    for (int i = 0; i < ntags; i++) {
+        if (i == 0 || tags[i].rel_oid != tags[i - 1].rel_oid) {
+            registered = autoprewarm_relname(data_dir, tags[i].rel_oid, name, sizeof(name));
+        }
+        if (registered) tags[count++] = tags[i];
+    }
+
+    // 先写临时文件再改名，崩溃时不会留下半个转储文件
+    char path[512], tmp_path[520];
+    snprintf(path, sizeof(path), "%s/%s", data_dir, AUTOPREWARM_FILE);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) {
+        fprintf(stderr, "autoprewarm: could not create %s: %s\n", tmp_path, strerror(errno));
+        free(tags);
+        return -1;
+    }
+    fprintf(fp, "<<%d>>\n", count);
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || tags[i].rel_oid != tags[i - 1].rel_oid) {
+            autoprewarm_relname(data_dir, tags[i].rel_oid, name, sizeof(name));
+        }
+        fprintf(fp, "%u,%s\n", tags[i].page_id, name);
+    }
+    free(tags);
+    if (fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "autoprewarm: could not write %s: %s\n", path, strerror(errno));
+        remove(tmp_path);
+        return -1;
+    }
+    return count;
+}
+
+int autoprewarm_load(const char* data_dir) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", data_dir, AUTOPREWARM_FILE);
+    FILE* fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    int count = 0;
+    if (fscanf(fp, "<<%d>>\n", &count) != 1 || count <= 0) {
+        fclose(fp);
+        return 0;
+    }
+    BufferTag* tags = malloc((size_t)count * sizeof(BufferTag));
+    if (!tags) {
+        fclose(fp);
+        return 0;
+    }
+    // 每行为 "页号,表文件名"，按文件名找到本次启动时的表 OID，跳过已删除的表
+    char line[SMGR_MAX_PATH + 16];
+    char relname[SMGR_MAX_PATH] = "";
+    uint32_t rel_oid = 0;
+    bool registered = false;
+    int ntags = 0;
+    while (ntags < count && fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = '\0';
+        char* name = strchr(line, ',');
+        if (!name) continue;
+        *name++ = '\0';
+        if (strcmp(name, relname) != 0) {
+            snprintf(relname, sizeof(relname), "%s", name);
+            if (name[0] == '/') {
+                snprintf(path, sizeof(path), "%s", name);
+            } else {
+                snprintf(path, sizeof(path), "%s/%s", data_dir, name);
+            }
+            registered = smgr_lookup_path(path, &rel_oid);
+        }
+        if (!registered) continue;
+        tags[ntags].rel_oid = rel_oid;
+        tags[ntags].page_id = (PageID)strtoul(line, NULL, 10);
+        ntags++;
+    }
+    fclose(fp);
+
+    // 按 (表, 页号) 顺序读，可利用内核预读
+    qsort(tags, ntags, sizeof(BufferTag), buffer_tag_cmp);
+    int loaded = 0;
+    PageID nblocks = 0;
+    for (int i = 0; i < ntags; i++) {
+        if (!page_cache_have_free_buffer() || autoprewarm_stop_requested()) {
+            break;
+        }
+        // 跳过已不存在的页
+        if (i == 0 || tags[i].rel_oid != tags[i - 1].rel_oid) {
+            nblocks = smgr_nblocks(tags[i].rel_oid);
+        }
+        if (tags[i].page_id >= nblocks) {
+            continue;
+        }
+        Buffer buf = ReadBuffer(tags[i].rel_oid, tags[i].page_id, NULL);
+        if (BufferIsValid(buf)) {
+            ReleaseBuffer(buf);
+            loaded++;
+        }
+    }
+    free(tags);
+    return loaded;
+}
+
+static void* autoprewarm_main(void* arg) {
+    (void)arg;
+    int loaded = autoprewarm_load(autoprewarm.data_dir);
+    if (loaded > 0) {
+        printf("autoprewarm: loaded %d pages\n", loaded);
+    }
+
+    pthread_mutex_lock(&autoprewarm.mutex);
+    while (!autoprewarm.stop_requested) {
+        if (autoprewarm.interval_ms <= 0) {
+            pthread_cond_wait(&autoprewarm.cond, &autoprewarm.mutex);
+            continue;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += autoprewarm.interval_ms / 1000;
+        deadline.tv_nsec += (long)(autoprewarm.interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!autoprewarm.stop_requested &&
+               pthread_cond_timedwait(&autoprewarm.cond, &autoprewarm.mutex, &deadline) != ETIMEDOUT) {
+        }
+        if (autoprewarm.stop_requested) break;
+
+        pthread_mutex_unlock(&autoprewarm.mutex);
+        autoprewarm_dump(autoprewarm.data_dir);
+        pthread_mutex_lock(&autoprewarm.mutex);
+    }
+    pthread_mutex_unlock(&autoprewarm.mutex);
+
+    autoprewarm_dump(autoprewarm.data_dir);
+    return NULL;
+}
+
+bool autoprewarm_start(const char* data_dir, int interval_ms) {
+    autoprewarm_stop();
+
+    pthread_mutex_lock(&autoprewarm.mutex);
+    snprintf(autoprewarm.data_dir, sizeof(autoprewarm.data_dir), "%s", data_dir);
+    autoprewarm.interval_ms = interval_ms;
+    autoprewarm.stop_requested = false;
+    if (pthread_create(&autoprewarm.thread, NULL, autoprewarm_main, NULL) != 0) {
+        pthread_mutex_unlock(&autoprewarm.mutex);
+        perror("autoprewarm: pthread_create failed");
+        return false;
+    }
+    autoprewarm.running = true;
+    pthread_mutex_unlock(&autoprewarm.mutex);
+    return true;
+}
+
+void autoprewarm_stop() {
+    pthread_mutex_lock(&autoprewarm.mutex);
+    if (!autoprewarm.running) {
+        pthread_mutex_unlock(&autoprewarm.mutex);
+        return;
+    }
+    autoprewarm.stop_requested = true;
+    pthread_cond_signal(&autoprewarm.cond);
+    pthread_mutex_unlock(&autoprewarm.mutex);
+
+    pthread_join(autoprewarm.thread, NULL);
+    pthread_mutex_lock(&autoprewarm.mutex);
+    autoprewarm.running = false;
+    // 之后直接调用 autoprewarm_load 时不能被这次的停止请求打断
+    autoprewarm.stop_requested = false;
+    pthread_mutex_unlock(&autoprewarm.mutex);
+}
@@ -0,0 +1,84 @@
+#include "prune.h"
+#include "page.h"
+#include "txmgr.h"
+#include <string.h>
+
+// 直接从序列化的元组头读取 xmin/xmax（布局见 serialize_tuple：oid, xmin, xmax, ...）
+#define TUPLE_XMIN_OFFSET sizeof(uint32_t)
+#define TUPLE_XMAX_OFFSET (2 * sizeof(uint32_t))
+
+int heap_page_prune(Page* page, const TransactionManager* txmgr, uint32_t oldest_xid,
+                    PruneResult* presult) {
+    Slot* slots = PageGetSlots(page);
+    uint32_t prune_xid = 0;
+    int nreclaimed = 0;
+    int nlive = 0;
+    bool all_visible = true;
+
+    for (uint16_t i = 0; i < page->header.slot_count; i++) {
+        Slot* slot = &slots[i];
+        bool dead;
+        if (slot->flags & SLOT_OCCUPIED) {
+            const uint8_t* data = page->data + slot->offset;
+            uint32_t xmin, xmax;
+            memcpy(&xmin, data + TUPLE_XMIN_OFFSET, sizeof(uint32_t));
+            memcpy(&xmax, data + TUPLE_XMAX_OFFSET, sizeof(uint32_t));
+
+            // 中止事务留下的 xmax 无效，该版本仍然存活
+            bool committed = xmax != 0 && txmgr_is_committed(txmgr, xmax);
+            bool xmax_valid = committed || (xmax != 0 && txmgr_is_in_progress(txmgr, xmax));
+            dead = committed && xmax < oldest_xid;
+            if (!dead && xmax_valid && (prune_xid == 0 || xmax < prune_xid)) {
+                // 还不能回收，记下最老的 xmax，最老活动事务越过它之后再剪枝
+                prune_xid = xmax;
+            }
+            if (dead) {
+                page->header.tuple_count--;
+            } else {
+                nlive++;
+                all_visible = all_visible && xmax == 0 && xmin < oldest_xid &&
+                              txmgr_is_committed(txmgr, xmin);
+            }
+        } else {
+            dead = slot->flags != SLOT_UNUSED;
+        }
+
+        if (dead) {
+            memset(slot, 0, sizeof(Slot));
+            nreclaimed++;
+        }
+    }
+
+    // 截掉槽位数组末尾的空槽位
+    while (page->header.slot_count > 0 &&
+           slots[page->header.slot_count - 1].flags == SLOT_UNUSED) {
+        page->header.slot_count--;
+    }
+    page->header.free_start = page->header.slot_count * sizeof(Slot);
+    page->header.prune_xid = prune_xid;
+
+    if (nreclaimed > 0) {
+        page_compact(page);
+    }
+    if (presult) {
+        presult->nlive = nlive;
+        presult->all_visible = all_visible;
+    }
+    return nreclaimed;
+}
+
+int heap_page_prune_opt(Page* page, const TransactionManager* txmgr, size_t minfree) {
+    uint32_t prune_xid = page->header.prune_xid;
+    uint32_t oldest_xid = txmgr->oldest_xid;
+    if (prune_xid == 0 || prune_xid >= oldest_xid) {
+        return -1;
+    }
+
+    if (minfree < PRUNE_MIN_FREE_SPACE) minfree = PRUNE_MIN_FREE_SPACE;
+    if (page_free_space(page) >= minfree) {
+        return -1;
+    }
+    // 即使没有回收任何版本（例如记下的 xmax 已中止），也会重新计算 prune_xid
+
+    return heap_page_prune(page, txmgr, oldest_xid, NULL);
+}
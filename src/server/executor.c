@@ -1,6 +1,7 @@
 // executor.c
 #include "server/executor.h"
 #include "tuple.h"
+#include "memctx.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -11,41 +12,65 @@
 bool db_select(MiniDB* db, const SelectStmt* stmt, ResultSet* result, Session session) {
     int count = 0;
     printf("[debug] select %d columns from table %s\n", stmt->num_columns, stmt->table_name);
-    Tuple** tuples = db_query(db, stmt->table_name, &count,session);
-    if (!tuples || count == 0) return false;
-
     //TableMeta* meta = find_table_meta(db, stmt->table_name);
      int idx= find_table(&db->catalog, stmt->table_name);
       printf("[debug] find_table[%d]  \n",idx);
+    if (idx < 0) return false;
     TableMeta *meta =&(db->catalog.tables[idx]);
-    if (!meta) return false;
+
+    // 每个输出列在表中的下标，只解析这些列；WHERE 在页面上判断，条件列不必解析
+    bool needed[MAX_COLS] = {false};
+    int col_index[MAX_COLUMNS];
+    for (int j = 0; j < stmt->num_columns; j++) {
+        col_index[j] = -1;
+        for (int k = 0; k < meta->col_count; k++) {
+            if (strcmp(meta->cols[k].name, stmt->columns[j]) == 0) {
+                col_index[j] = k;
+                needed[k] = true;
+                break;
+            }
+        }
+    }
+    const Condition *qual = NULL;
+    if (stmt->has_where) {
+        bool found = false;
+        for (int k = 0; k < meta->col_count && !found; k++) {
+            found = strcmp(meta->cols[k].name, stmt->where.column) == 0;
+        }
+        if (!found) {
+            fprintf(stderr, "Select failed: unknown column '%s' in WHERE\n", stmt->where.column);
+            return false;
+        }
+        qual = &stmt->where;
+    }
+    /*
+     * 结果集在调用方的上下文中；扫描出的元组放在子上下文里，转成字符串后整体释放。
+     * db_query_attrs 一次返回所有行（最多 MAX_RESULTS），整个扫描就是一个批次，
+     * 不再按批重置；需要分批时应让扫描逐页交出元组。
+     */
+    MemoryContext result_ctx = CurrentMemoryContext;
+    MemoryContext scan_ctx = MemoryContextCreate(result_ctx, "select scan");
+    if (!scan_ctx) return false;
+    MemoryContextSwitchTo(scan_ctx);
+    Tuple** tuples = db_query_attrs(db, stmt->table_name, &count, session, needed, qual);
+    MemoryContextSwitchTo(result_ctx);
 
     result->num_cols = stmt->num_columns;
     result->num_rows = count;
-    result->rows = malloc(sizeof(char**) * count);
+    result->rows = count > 0 ? palloc(sizeof(char**) * count) : NULL;
 
 
     printf("[debug]   rows %d from file %s\n", count, meta->filename);
     for (int i = 0; i < count; i++) {
         Tuple* t = tuples[i];
-        char** row = malloc(sizeof(char*) * result->num_cols);
+        char** row = palloc(sizeof(char*) * result->num_cols);
         for (int j = 0; j < result->num_cols; j++) {
-            const char* colname = stmt->columns[j];
-
-            // 查找列索引
-            int col_index = -1;
-            for (int k = 0; k < meta->col_count; k++) {
-                if (strcmp(meta->cols[k].name, colname) == 0) {
-                    col_index = k;
-                    break;
-                }
-            }
-            if (col_index == -1) {
-                row[j] = strdup("<invalid>");
+            if (col_index[j] == -1) {
+                row[j] = pstrdup("<invalid>");
                 continue;
             }
 
-            Column* col = &t->columns[col_index];
+            Column* col = &t->columns[col_index[j]];
             char buf[128];
             switch (col->type) {
                 case INT4_TYPE: snprintf(buf, sizeof(buf), "%d", col->value.int_val); break;
@@ -56,15 +81,14 @@ bool db_select(MiniDB* db, const SelectStmt* stmt, ResultSet* result, Session se
                 default: strcpy(buf, "<unknown>"); break;
             }
 
-            row[j] = strdup(buf);
+            row[j] = pstrdup(buf);
        
         }
            
         result->rows[i] = row;
-        free_tuple(t);  // ✅释放每条 Tuple
     }
 
-    free(tuples);
+    MemoryContextDelete(scan_ctx);
       save_tx_state(&db->tx_mgr, db->data_dir);
     return true;
 }
@@ -94,10 +118,9 @@ bool old_db_update(MiniDB* db, const UpdateStmt* stmt, Session* session) {
     long pos = 0;
 
     while (fread(&page, sizeof(Page), 1, fp) == 1) {
-        LWLockAcquireExclusive(&page.lock);
 
         for (int i = 0; i < page.header.slot_count; i++) {
-            Slot* slot = &page.slots[i];
+            Slot* slot = &PageGetSlots(&page)[i];
             if (slot->status != SLOT_OCCUPIED) continue;
 
             Tuple* t = page_get_tuple(&page, i,meta); // 假设有个方法能解析 tuple
@@ -119,7 +142,6 @@ bool old_db_update(MiniDB* db, const UpdateStmt* stmt, Session* session) {
             uint16_t new_slot;
             if (!page_insert_tuple(&page, &new_tuple, &new_slot)) {
                 fprintf(stderr, "Update failed: No space for new version.\n");
-                LWLockRelease(&page.lock);
                 fclose(fp);
                 return false;
             }
@@ -132,7 +154,6 @@ bool old_db_update(MiniDB* db, const UpdateStmt* stmt, Session* session) {
         fseek(fp, pos, SEEK_SET);
         fwrite(&page, sizeof(Page), 1, fp);
         fflush(fp);
-        LWLockRelease(&page.lock);
     }
 
     fclose(fp);
@@ -171,7 +192,7 @@ int  nocache_db_update(MiniDB *db,const UpdateStmt* stmt,Session session) {
         fprintf(stderr, "in fread for loop:orig_slot_count=%d,session.current_xid=%d \n", orig_slot_count, session.current_xid);
         for (int i = 0; i < orig_slot_count; i++) {
             //fprintf(stderr, "in fread for loop:orig_slot_count i=%d\n", i);
-            Slot *slot = &page.slots[i];
+            Slot *slot = &PageGetSlots(&page)[i];
             if (slot->flags  != SLOT_OCCUPIED) continue;
 
             Tuple *t = page_get_tuple(&page, i, meta);
@@ -231,7 +252,7 @@ int  nocache_db_update(MiniDB *db,const UpdateStmt* stmt,Session session) {
   save_tx_state(&db->tx_mgr, db->data_dir);
 
     for (int i = 0; i < page.header.slot_count; i++) {
-    Slot* s = &page.slots[i];
+    Slot* s = &PageGetSlots(&page)[i];
     fprintf(stderr, "Slot[%d] flags=%d offset=%d len=%d\n", i, s->flags, s->offset, s->length);
     
     Tuple* t = page_get_tuple(&page, i, meta);
@@ -247,6 +268,65 @@ int  nocache_db_update(MiniDB *db,const UpdateStmt* stmt,Session session) {
     return result_count;
 }
 
+// 待更新的行：扫描时记下的版本位置和内容
+typedef struct UpdateTarget {
+    ItemPointer tid;
+    Tuple *tuple;
+} UpdateTarget;
+
+// 按 stmt 的赋值构造新版本
+static Tuple *build_updated_tuple(const TableMeta *meta, const UpdateStmt *stmt, const Tuple *old) {
+    Tuple *new_t = copy_tuple(old);
+    if (!new_t) return NULL;
+    for (int j = 0; j < meta->col_count; j++) {
+        for (int k = 0; k < stmt->num_assignments; k++) {
+            if (strcmp(meta->cols[j].name, stmt->columns[k]) == 0) {
+                set_column_value(&new_t->columns[j], stmt->values[k]);
+            }
+        }
+    }
+    return new_t;
+}
+
+/*
+ * 更新一行：目标版本已被其他已提交事务更新时沿 ctid 链取出最新版本，
+ * 重新检查 WHERE 条件后在最新版本上更新，不必重新扫描表。
+ * 链上的版本已被剪枝回收时才按 OID 扫描表找最新版本。
+ */
+static bool update_row(MiniDB *db, TableMeta *meta, const UpdateStmt *stmt, UpdateTarget *target,
+                       Session session) {
+    ItemPointer tid = target->tid;
+    Tuple *cur = target->tuple;
+    bool updated = false;
+    while (cur) {
+        Tuple *new_t = build_updated_tuple(meta, stmt, cur);
+        if (!new_t) break;
+        HeapUpdateResult result = db_heap_update(db, meta, &tid, new_t, session);
+        free_tuple(new_t);
+        if (cur != target->tuple) free_tuple(cur);
+        cur = NULL;
+
+        if (result == HEAP_UPDATE_OK) {
+            updated = true;
+        } else if (result == HEAP_UPDATE_UPDATED || result == HEAP_UPDATE_PRUNED) {
+            cur = result == HEAP_UPDATE_UPDATED ? db_heap_fetch(db, meta, tid) : NULL;
+            if (!cur || cur->oid != target->tuple->oid) {
+                // 链上的版本已被剪枝回收（槽位可能已被其他行重用），按 OID 重新定位
+                free_tuple(cur);
+                cur = db_heap_fetch_latest(db, meta, target->tuple->oid, &tid);
+            }
+            if (cur && stmt->has_where && !eval_condition(&(stmt->where), cur, meta)) {
+                free_tuple(cur);
+                cur = NULL;
+            }
+        } else if (result == HEAP_UPDATE_BEING_UPDATED) {
+            fprintf(stderr, "xid:%d,行正在被其他事务更新，跳过 oid=%u\n",
+                    session.current_xid, target->tuple->oid);
+        }
+    }
+    return updated;
+}
+
 int db_update(MiniDB *db, const UpdateStmt *stmt, Session session) {
     if (!db || !stmt->table_name || session.current_xid == INVALID_XID) {
         fprintf(stderr, "Invalid input or no active transaction\n");
@@ -267,81 +347,99 @@ int db_update(MiniDB *db, const UpdateStmt *stmt, Session session) {
     snprintf(fullpath, sizeof(fullpath), "%s/%s", db->data_dir, meta->filename);
 
     int result_count = 0;
-
-    //for (PageID page_id = 0; page_id < db->next_page_id; page_id++) {
-    for (PageID page_id = meta->first_page; page_id <= meta->last_page; page_id++) {
-
-        Page *page = page_cache_load_or_fetch(page_id, fullpath);
-         LWLockAcquireExclusive(&page->lock);
-        if (!page) continue;
-
-        int orig_slot_count = page->header.slot_count;
-
-        for (int i = 0; i < orig_slot_count; i++) {
-            Slot *slot = &page->slots[i];
-            if (slot->flags != SLOT_OCCUPIED) continue;
-
-            Tuple *t = page_get_tuple(page, i, meta);
-            if (!t || !is_tuple_visible(&db->tx_mgr,t, session.current_xid)) {
-                free_tuple(t);
+    UpdateTarget *targets = NULL;
+    int ntargets = 0, max_targets = 0;
+
+    /*
+     * 批次上下文：扫描时每页重置（判断条件时复制出的压缩/外部 TEXT），
+     * 更新时每行重置（沿更新链取出的版本、构造的新版本）。
+     * 要更新的行本身在调用方的上下文中，跨批次保留。
+     */
+    MemoryContext batch_ctx = MemoryContextCreate(CurrentMemoryContext, "update batch");
+    if (!batch_ctx) return false;
+
+    // 先扫描出要更新的行，更新时不持有扫描页的锁
+    ReadStream stream;
+    Buffer buf;
+    BufferAccessStrategy strategy = GetScanAccessStrategy(meta->last_page - meta->first_page + 1);
+    read_stream_begin(&stream, meta->oid, fullpath, meta->first_page, meta->last_page,
+                      db_config.effective_io_concurrency, strategy);
+    while (read_stream_next(&stream, &buf, NULL)) {
+        if (!BufferIsValid(buf)) continue;
+        Page *page = BufferGetPage(buf);
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+
+        for (int i = 0; i < page->header.slot_count; i++) {
+            // 在页面上直接判断可见性和条件，只复制要更新的行
+            TupleView view;
+            if (!page_get_tuple_view(page, i, meta, &view) ||
+                !tuple_view_is_visible(&db->tx_mgr, &view, session.current_xid)) {
                 continue;
             }
 
-            if (t->xmin == session.current_xid) {
-                free_tuple(t);
+            if (view.xmin == session.current_xid) {
                 continue; // 不重复更新本事务插入的行
             }
 
-         
-
-            if (!eval_condition(&(stmt->where), t, meta)) {
-
-                free_tuple(t);
-                continue;
-            }
-            if (!lock_row(meta->name, t->oid, session.current_xid)) {
-                fprintf(stderr, "xid:%d,行锁获取失败，跳过 oid=%u\n",session.current_xid, t->oid);
-                free_tuple(t);
+            MemoryContext old_ctx = MemoryContextSwitchTo(batch_ctx);
+            bool match = tuple_view_eval_condition(&(stmt->where), &view, meta);
+            MemoryContextSwitchTo(old_ctx);
+            if (!match) {
                 continue;
             }
-            sleep(1);  // 模拟并发延迟
-
-            // 逻辑删除旧元组
-            t->xmax = session.current_xid;
-
-            page_update_tuple(page, i, t); // 更新 xmax
-        
-
-            // 插入新版本元组
-            Tuple new_t;
-            memcpy(&new_t, t, sizeof(Tuple));
-                //free_tuple(t);
-            new_t.xmin = session.current_xid;
-            new_t.xmax = 0;
-            new_t.deleted=false;
-
-
-            for (int j = 0; j < meta->col_count; j++) {
-                for (int k = 0; k < stmt->num_assignments; k++) {
-                    if (strcmp(meta->cols[j].name, stmt->columns[k]) == 0) {
-                        set_column_value(&new_t.columns[j], stmt->values[k]);
+            Tuple *t = tuple_view_materialize(&view, NULL);
+            if (!t) continue;
+            if (ntargets == max_targets) {
+                int new_max = max_targets ? max_targets * 2 : 16;
+                UpdateTarget *new_targets = realloc(targets, new_max * sizeof(UpdateTarget));
+                if (!new_targets) {
+                    // 内存不足：放弃本次更新，释放已收集的行
+                    fprintf(stderr, "Out of memory collecting rows to update\n");
+                    free_tuple(t);
+                    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+                    ReleaseBuffer(buf);
+                    read_stream_end(&stream);
+                    FreeAccessStrategy(strategy);
+                    for (int j = 0; j < ntargets; j++) {
+                        free_tuple(targets[j].tuple);
                     }
+                    free(targets);
+                    MemoryContextDelete(batch_ctx);
+                    return 0;
                 }
+                targets = new_targets;
+                max_targets = new_max;
             }
-
-            uint16_t new_slot_idx;
-            if (page_insert_tuple(page, &new_t, &new_slot_idx)) {
+            targets[ntargets].tid.page_id = page->header.page_id;
+            targets[ntargets].tid.slot = (uint16_t)i;
+            targets[ntargets].tuple = t;
+            ntargets++;
+        }
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        ReleaseBuffer(buf);
+        MemoryContextReset(batch_ctx);
+    }
+    read_stream_end(&stream);
+    FreeAccessStrategy(strategy);
+
+    for (int i = 0; i < ntargets; i++) {
+        Tuple *t = targets[i].tuple;
+        if (!lock_row(meta->name, t->oid, session.current_xid)) {
+            fprintf(stderr, "xid:%d,行锁获取失败，跳过 oid=%u\n",session.current_xid, t->oid);
+        } else {
+            sleep(1);  // 模拟并发延迟
+            MemoryContext old_ctx = MemoryContextSwitchTo(batch_ctx);
+            if (update_row(db, meta, stmt, &targets[i], session)) {
                 result_count++;
             }
-           
-
-            unlock_row(meta->name, new_t.oid, session.current_xid);
+            MemoryContextSwitchTo(old_ctx);
+            MemoryContextReset(batch_ctx);
+            unlock_row(meta->name, t->oid, session.current_xid);
         }
-        page_cache_mark_dirty(page_id);
-        // 修改后的页需刷回磁盘
-        page_cache_flush(page_id, fullpath);
-         LWLockRelease(&page->lock);
+        free_tuple(t);
     }
+    free(targets);
+    MemoryContextDelete(batch_ctx);
 
    // save_tx_state(&db->tx_mgr, db->data_dir);
     return result_count;
@@ -355,8 +453,9 @@ void set_column_value(Column* column, const char* new_value) {
             column->value.int_val = atoi(new_value);
             break;
         case TEXT_TYPE:
-            strncpy(column->value.str_val, new_value, MAX_TEXT_LEN - 1);
-            column->value.str_val[MAX_TEXT_LEN - 1] = '\0';  // 保证结尾
+            // 原字符串按原长度分配，不能原地覆盖，换成新值的副本
+            pfree(column->value.str_val);
+            column->value.str_val = pstrdup(new_value);
             break;
         default:
             fprintf(stderr, "Unsupported column type in set_column_value\n");
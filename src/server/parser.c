@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <strings.h>
 #include "server/parser.h"
 #include "types.h"
 
@@ -30,6 +31,47 @@ bool parse_insert(const char* sql, InsertStmt* stmt) {
     return true;
 }
 
+// 解析 sql 中的 "where 列 = 值"（值可加单引号），没有 WHERE 时 has_where 为 false
+static bool parse_where(const char* sql, Condition* cond, bool* has_where) {
+    *has_where = false;
+    const char* p = sql;
+    for (; *p; p++) {
+        if (strncasecmp(p, "where", 5) == 0 && (p == sql || isspace((unsigned char)p[-1])) &&
+            (isspace((unsigned char)p[5]) || p[5] == '\0')) {
+            break;
+        }
+    }
+    if (!*p) return true;
+    p += 5;
+
+    while (isspace((unsigned char)*p)) p++;
+    int len = 0;
+    while (p[len] && (isalnum((unsigned char)p[len]) || p[len] == '_')) len++;
+    if (len == 0 || len >= MAX_COLUMN_NAME_LEN) return false;
+    memcpy(cond->column, p, len);
+    cond->column[len] = '\0';
+    p += len;
+
+    while (isspace((unsigned char)*p)) p++;
+    if (*p != '=') return false;
+    strcpy(cond->op, "=");
+    p++;
+    while (isspace((unsigned char)*p)) p++;
+
+    bool quoted = *p == '\'';
+    if (quoted) p++;
+    len = 0;
+    while (p[len] && (quoted ? p[len] != '\'' : !isspace((unsigned char)p[len]) && p[len] != ';')) len++;
+    if (len == 0 || len >= MAX_WHERE_LEN || (quoted && p[len] != '\'')) return false;
+    memcpy(cond->value, p, len);
+    cond->value[len] = '\0';
+    p += len + (quoted ? 1 : 0);
+
+    while (isspace((unsigned char)*p) || *p == ';') p++;
+    *has_where = true;
+    return *p == '\0';
+}
+
 bool parse_select(const char* sql, SelectStmt* stmt) {
     // 模拟解析: select id, name from users
     strcpy(stmt->table_name, "users");
@@ -37,7 +79,7 @@ bool parse_select(const char* sql, SelectStmt* stmt) {
     strcpy(stmt->columns[0], "id");
     strcpy(stmt->columns[1], "name");
     strcpy(stmt->columns[2], "age");
-    return true;
+    return parse_where(sql, &stmt->where, &stmt->has_where);
 }
 
 bool parse_update(const char* sql, UpdateStmt*stmt) {
@@ -57,4 +99,24 @@ bool parse_update(const char* sql, UpdateStmt*stmt) {
     strcpy(stmt->where.value, "Jack");
     fprintf(stderr, ">>> in parse_update: stmt->where.value = [%s]\n", stmt->where.value);
     return true;
-}
\ No newline at end of file
+}
+
+bool parse_vacuum(const char* sql, VacuumStmt* stmt) {
+    const char* p = sql;
+    while (isspace((unsigned char)*p)) p++;
+    if (strncasecmp(p, "vacuum", 6) != 0) return false;
+    p += 6;
+    if (*p && !isspace((unsigned char)*p) && *p != ';') return false;
+    while (isspace((unsigned char)*p)) p++;
+
+    int len = 0;
+    while (p[len] && !isspace((unsigned char)p[len]) && p[len] != ';') len++;
+    stmt->has_table = len > 0;
+    if (len >= MAX_TABLE_NAME) return false;
+    memcpy(stmt->table_name, p, len);
+    stmt->table_name[len] = '\0';
+
+    p += len;
+    while (isspace((unsigned char)*p) || *p == ';') p++;
+    return *p == '\0';
+}
@@ -13,6 +13,8 @@
 #include "minidb.h"  // 需要你已有的 mini_pg 接口头文件
 #include "server/parser.h"     // 假设你的 SQL 解析器定义在这里
 #include "server/executor.h"   // 假设实际执行逻辑在这里
+#include "server/sql_exec.h"
+#include "memctx.h"
 #define PORT 8888
 #define BUFFER_SIZE 4096
 
@@ -37,6 +39,10 @@ char* handle_query(const char* query, MiniDB* db,Session session ) {
        int len=  execute_select_to_string(db, query,session,result); // 你需要实现这个函数
         return result ? result : strdup("Select Failed\n");
     } 
+    else if (strncasecmp(query, "vacuum", 6) == 0) {
+        if (execute_vacuum(db, query)) return strdup("Vacuum OK\n");
+        else return strdup("Vacuum Failed\n");
+    }
     /*
     else if (strncasecmp(query, "update", 6) == 0) {
         // ✅ 新增部分：解析 + 执行 update
@@ -78,6 +84,7 @@ int main_pg() {
         session.client_fd = client_fd;
         session.db = &global_db;
         session.current_xid = INVALID_XID;
+        session.memctx = MemoryContextCreate(NULL, "session");
 
         char buffer[4096];
         while (1) {
@@ -121,6 +128,7 @@ int main_pg() {
             }
         }
 
+        MemoryContextDelete(session.memctx);
         close(client_fd);
         exit(0);
         }
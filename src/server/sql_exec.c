@@ -7,6 +7,8 @@
 #include "server/sql_exec.h"
 #include "server/parser.h"     // 假设你的 SQL 解析器定义在这里
 #include "server/executor.h"   // 假设实际执行逻辑在这里
+#include "vacuum.h"
+#include "memctx.h"
 
 bool execute_create_table(MiniDB* db, const char* sql,Session session) {
     CreateTableStmt stmt;
@@ -39,7 +41,8 @@ bool execute_insert(MiniDB* db, const char* sql,Session session) {
     tuple.xmax = 0;
     tuple.deleted = false;
     tuple.col_count = meta->col_count;
-    tuple.columns = malloc(sizeof(Column) * tuple.col_count);
+    // 与 copy_tuple/free_tuple 一样用 palloc，在会话的查询上下文中分配
+    tuple.columns = palloc(sizeof(Column) * tuple.col_count);
     if (!tuple.columns) return false;
 
     for (int i = 0; i < tuple.col_count; i++) {
@@ -58,14 +61,14 @@ bool execute_insert(MiniDB* db, const char* sql,Session session) {
                 col->value.bool_val = (strcmp(raw, "true") == 0 || strcmp(raw, "1") == 0);
                 break;
             case TEXT_TYPE:
-                col->value.str_val = strdup(raw);
+                col->value.str_val = pstrdup(raw);
                 break;
             case DATE_TYPE:
                 col->value.int_val = atoi(raw);  // 暂存为整数
                 break;
             default:
                 fprintf(stderr, "[insert] unsupported column type\n");
-                free(tuple.columns);
+                pfree(tuple.columns);
                 return false;
         }
     }
@@ -74,10 +77,10 @@ bool execute_insert(MiniDB* db, const char* sql,Session session) {
 
     for (int i = 0; i < tuple.col_count; i++) {
         if (tuple.columns[i].type == TEXT_TYPE) {
-            free(tuple.columns[i].value.str_val);
+            pfree(tuple.columns[i].value.str_val);
         }
     }
-    free(tuple.columns);
+    pfree(tuple.columns);
 
     return ok;
     //return db_insert(db, stmt.table_name, stmt.values);
@@ -90,9 +93,16 @@ int execute_select_to_string(MiniDB* db, const char* sql,Session session,char *
         return NULL;
     }
 
+    // 语句执行期间的分配都放在语句上下文中，结果写入 ret 后一次释放
+    MemoryContext query_ctx = MemoryContextCreate(session.memctx, "select");
+    if (!query_ctx) return NULL;
+    MemoryContext old_ctx = MemoryContextSwitchTo(query_ctx);
+
     ResultSet result;
     if (!db_select(db, &stmt, &result,session)) {
         fprintf(stderr, "[select] execution failed\n");
+        MemoryContextSwitchTo(old_ctx);
+        MemoryContextDelete(query_ctx);
         return NULL;
     }
 
@@ -111,13 +121,16 @@ int execute_select_to_string(MiniDB* db, const char* sql,Session session,char *
     memset(buf,0,4096);
     if (!buf) return NULL;
     size_t offset = 0;
-    for (int i = 0; i < result.num_rows; i++) {
-        for (int j = 0; j < result.num_cols; j++) {
+    // 写满 4096 字节后截断
+    for (int i = 0; i < result.num_rows && offset < 4096; i++) {
+        for (int j = 0; j < result.num_cols && offset < 4096; j++) {
             const char* val = result.rows[i][j] ? result.rows[i][j] : "<null>";
             offset += snprintf(buf + offset, 4096 - offset, "%s\t", val);
         }
-        offset += snprintf(buf + offset, 4096 - offset, "\n");
+        if (offset < 4096) offset += snprintf(buf + offset, 4096 - offset, "\n");
     }
+    MemoryContextSwitchTo(old_ctx);
+    MemoryContextDelete(query_ctx);
    // strcat(buf, "\0");
   //printf("[select]  execute_select_to_string:len=%d\n, %s",strlen(buf),buf);
    //  return buf;
@@ -170,3 +183,12 @@ fprintf(stderr, "[DEBUG] stmt->values[0] addr: %p\n", (void*)stmt->values[0]);
     snprintf(output, 256, "Update OK, %d row(s) affected\n", count);
     return count;
 }
+
+bool execute_vacuum(MiniDB* db, const char* sql) {
+    VacuumStmt stmt;
+    if (!parse_vacuum(sql, &stmt)) {
+        fprintf(stderr, "[vacuum] parse error\n");
+        return false;
+    }
+    return db_vacuum(db, stmt.has_table ? stmt.table_name : NULL) >= 0;
+}
@@ -0,0 +1,542 @@
+#define _GNU_SOURCE  // O_DIRECT, fallocate
+#include "smgr.h"
+#include "lock.h"
+#include "aio.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdint.h>
+
+// 一个已登记的表文件
+typedef struct SMgrRelationData {
+    uint32_t rel_oid;
+    char path[SMGR_MAX_PATH];
+    int fd;                   // -1 表示当前未打开
+    bool direct;              // fd 是否以 O_DIRECT 打开
+    atomic_int users;         // 正在用 fd 做 I/O 的线程数，>0 时不能关闭
+    atomic_ullong last_used;  // 最近一次使用的 LRU 时钟
+    SMgrMap* map;             // 缓存的只读映射，NULL 表示尚未映射
+} SMgrRelationData;
+
+/*
+ * rels/nrels/nopen 以及各项的 fd 由 lock 保护：
+ * 查找和 pin 已打开的 fd 用共享模式，打开、关闭、登记用排他模式。
+ * users 只在持锁时增加，因此排他模式下看到 users == 0 的 fd 可以安全关闭。
+ */
+static struct {
+    SMgrRelationData rels[MAX_SMGR_RELS];
+    int nrels;
+    int nopen;                // 当前打开的 fd 数
+    int max_open;
+    bool direct_io;           // 以 O_DIRECT 打开数据文件
+    IOMethod io_method;
+    atomic_ullong clock;
+    LWLock lock;
+} smgr;
+
+// 调用方需持有 smgr.lock
+static SMgrRelationData* smgr_lookup(uint32_t rel_oid) {
+    for (int i = 0; i < smgr.nrels; i++) {
+        if (smgr.rels[i].rel_oid == rel_oid) {
+            return &smgr.rels[i];
+        }
+    }
+    return NULL;
+}
+
+// 关闭一个 fd，调用方需以排他模式持有 smgr.lock
+static void smgr_close_fd(SMgrRelationData* rel) {
+    if (rel->fd >= 0) {
+        close(rel->fd);
+        rel->fd = -1;
+        smgr.nopen--;
+    }
+}
+
+// 关闭最久未用且空闲的 fd，调用方需以排他模式持有 smgr.lock
+static bool smgr_close_lru(void) {
+    SMgrRelationData* victim = NULL;
+    for (int i = 0; i < smgr.nrels; i++) {
+        SMgrRelationData* rel = &smgr.rels[i];
+        if (rel->fd < 0 || atomic_load(&rel->users) > 0) continue;
+        if (!victim || atomic_load(&rel->last_used) < atomic_load(&victim->last_used)) {
+            victim = rel;
+        }
+    }
+    if (!victim) return false;
+    smgr_close_fd(victim);
+    return true;
+}
+
+static void smgr_touch(SMgrRelationData* rel) {
+    atomic_fetch_add(&rel->users, 1);
+    atomic_store_explicit(&rel->last_used,
+                          atomic_fetch_add_explicit(&smgr.clock, 1, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+// 取表的 fd 并标记为使用中，用完后调用 smgr_unpin_fd
+static int smgr_pin_fd(uint32_t rel_oid, SMgrRelationData** out) {
+    LWLockAcquireShared(&smgr.lock);
+    SMgrRelationData* rel = smgr_lookup(rel_oid);
+    if (rel && rel->fd >= 0) {
+        smgr_touch(rel);
+        int fd = rel->fd;
+        LWLockRelease(&smgr.lock);
+        *out = rel;
+        return fd;
+    }
+    LWLockRelease(&smgr.lock);
+
+    LWLockAcquireExclusive(&smgr.lock);
+    rel = smgr_lookup(rel_oid);
+    if (!rel) {
+        LWLockRelease(&smgr.lock);
+        fprintf(stderr, "smgr: relation %u is not open\n", rel_oid);
+        return -1;
+    }
+    if (rel->fd < 0) {
+        // 达到上限时关闭一个空闲 fd；全部在用时暂时超出上限
+        if (smgr.nopen >= smgr.max_open) {
+            smgr_close_lru();
+        }
+        int flags = O_RDWR | O_CREAT;
+        bool direct = false;
+#ifdef O_DIRECT
+        if (smgr.direct_io) {
+            flags |= O_DIRECT;
+            direct = true;
+        }
+#endif
+        int fd = open(rel->path, flags, 0644);
+        if (fd < 0 && errno == EINVAL && direct) {
+            // 文件系统不支持 O_DIRECT (如 tmpfs)，退回普通 I/O
+            fprintf(stderr, "smgr: O_DIRECT not supported for %s, using buffered I/O\n", rel->path);
+            direct = false;
+            fd = open(rel->path, O_RDWR | O_CREAT, 0644);
+        }
+        if (fd < 0) {
+            LWLockRelease(&smgr.lock);
+            fprintf(stderr, "smgr: could not open %s: %s\n", rel->path, strerror(errno));
+            return -1;
+        }
+        rel->fd = fd;
+        rel->direct = direct;
+        smgr.nopen++;
+    }
+    smgr_touch(rel);
+    int fd = rel->fd;
+    LWLockRelease(&smgr.lock);
+    *out = rel;
+    return fd;
+}
+
+static void smgr_unpin_fd(SMgrRelationData* rel) {
+    atomic_fetch_sub(&rel->users, 1);
+}
+
+// 不再缓存表的映射，仍在使用的扫描结束后才解除映射；调用方需以排他模式持有 smgr.lock
+static void smgr_drop_map(SMgrRelationData* rel) {
+    if (rel->map) {
+        smgr_unmap(rel->map);
+        rel->map = NULL;
+    }
+}
+
+void smgr_init(int max_open_files, bool direct_io, IOMethod io_method) {
+    smgr_shutdown();
+    LWLockInit(&smgr.lock, TRANCHE_SMGR_LOCK);
+    smgr.max_open = max_open_files < SMGR_MIN_OPEN_FILES ? SMGR_MIN_OPEN_FILES : max_open_files;
+    smgr.direct_io = direct_io;
+    smgr.io_method = io_method;
+}
+
+// O_DIRECT 要求缓冲区按块对齐，未对齐的页面经此中转
+static _Thread_local _Alignas(PAGE_SIZE) Page smgr_bounce_page;
+
+static bool smgr_page_aligned(const void* ptr) {
+    return ((uintptr_t)ptr & (PAGE_SIZE - 1)) == 0;
+}
+
+void smgr_shutdown() {
+    LWLockAcquireExclusive(&smgr.lock);
+    for (int i = 0; i < smgr.nrels; i++) {
+        smgr_close_fd(&smgr.rels[i]);
+        smgr_drop_map(&smgr.rels[i]);
+    }
+    smgr.nrels = 0;
+    smgr.nopen = 0;
+    LWLockRelease(&smgr.lock);
+}
+
+bool smgr_open(uint32_t rel_oid, const char* path) {
+    LWLockAcquireShared(&smgr.lock);
+    SMgrRelationData* rel = smgr_lookup(rel_oid);
+    bool same = rel && strcmp(rel->path, path) == 0;
+    LWLockRelease(&smgr.lock);
+    if (same) return true;
+
+    LWLockAcquireExclusive(&smgr.lock);
+    rel = smgr_lookup(rel_oid);
+    if (rel) {
+        if (strcmp(rel->path, path) != 0 && atomic_load(&rel->users) == 0) {
+            smgr_close_fd(rel);
+            smgr_drop_map(rel);
+            snprintf(rel->path, sizeof(rel->path), "%s", path);
+        }
+        LWLockRelease(&smgr.lock);
+        return true;
+    }
+    if (smgr.nrels >= MAX_SMGR_RELS) {
+        LWLockRelease(&smgr.lock);
+        fprintf(stderr, "smgr: too many relations, cannot open %s\n", path);
+        return false;
+    }
+    rel = &smgr.rels[smgr.nrels];
+    rel->rel_oid = rel_oid;
+    snprintf(rel->path, sizeof(rel->path), "%s", path);
+    rel->fd = -1;
+    rel->direct = false;
+    atomic_init(&rel->users, 0);
+    atomic_init(&rel->last_used, 0);
+    rel->map = NULL;
+    smgr.nrels++;
+    LWLockRelease(&smgr.lock);
+    return true;
+}
+
+void smgr_close(uint32_t rel_oid) {
+    LWLockAcquireExclusive(&smgr.lock);
+    SMgrRelationData* rel = smgr_lookup(rel_oid);
+    if (rel && atomic_load(&rel->users) == 0) {
+        smgr_close_fd(rel);
+    }
+    LWLockRelease(&smgr.lock);
+}
+
+bool smgr_relpath(uint32_t rel_oid, char* path, size_t size) {
+    LWLockAcquireShared(&smgr.lock);
+    SMgrRelationData* rel = smgr_lookup(rel_oid);
+    if (rel) {
+        snprintf(path, size, "%s", rel->path);
+    }
+    LWLockRelease(&smgr.lock);
+    return rel != NULL;
+}
+
+bool smgr_lookup_path(const char* path, uint32_t* rel_oid) {
+    bool found = false;
+    LWLockAcquireShared(&smgr.lock);
+    for (int i = 0; i < smgr.nrels && !found; i++) {
+        if (strcmp(smgr.rels[i].path, path) == 0) {
+            *rel_oid = smgr.rels[i].rel_oid;
+            found = true;
+        }
+    }
+    LWLockRelease(&smgr.lock);
+    return found;
+}
+
+// 同步读满一页，返回读到的字节数，出错返回 -errno
+static int smgr_pread_page(int fd, PageID page_id, Page* page, size_t done) {
+    off_t offset = (off_t)page_id * sizeof(Page);
+    while (done < sizeof(Page)) {
+        ssize_t n = pread(fd, (char*)page + done, sizeof(Page) - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -errno;
+        if (n == 0) break;  // 页面超出文件末尾
+        done += n;
+    }
+    return (int)done;
+}
+
+bool smgr_read(uint32_t rel_oid, PageID page_id, Page* page) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return false;
+
+    Page* target = page;
+    if (rel->direct && !smgr_page_aligned(page)) {
+        page = &smgr_bounce_page;
+    }
+    int done = smgr_pread_page(fd, page_id, page, 0);
+    if (done < 0) {
+        fprintf(stderr, "smgr: could not read page %u of relation %u: %s\n",
+                page_id, rel_oid, strerror(-done));
+    }
+    smgr_unpin_fd(rel);
+    if (done != (int)sizeof(Page)) return false;
+    if (page != target) {
+        *target = *page;
+    }
+    return true;
+}
+
+/*
+ * 每个线程一个 io_uring，请求只由发起线程等待，不需要加锁。
+ * 线程退出时由 pthread key 的析构函数销毁。
+ */
+static _Thread_local AioRing* smgr_ring;
+static _Thread_local bool smgr_ring_failed;
+static pthread_key_t smgr_ring_key;
+static pthread_once_t smgr_ring_once = PTHREAD_ONCE_INIT;
+
+static void smgr_ring_destroy(void* arg) {
+    AioRing* ring = arg;
+    aio_ring_destroy(ring);
+    free(ring);
+}
+
+static void smgr_ring_key_init(void) {
+    pthread_key_create(&smgr_ring_key, smgr_ring_destroy);
+}
+
+// 取本线程的 io_uring，不可用时返回 NULL
+static AioRing* smgr_get_ring(void) {
+    if (smgr_ring || smgr_ring_failed || smgr.io_method != IO_METHOD_IO_URING) {
+        return smgr_ring;
+    }
+    pthread_once(&smgr_ring_once, smgr_ring_key_init);
+    AioRing* ring = malloc(sizeof(AioRing));
+    if (!ring || !aio_ring_init(ring, SMGR_AIO_QUEUE_DEPTH)) {
+        free(ring);
+        smgr_ring_failed = true;
+        fprintf(stderr, "smgr: io_uring unavailable, using synchronous reads\n");
+        return NULL;
+    }
+    pthread_setspecific(smgr_ring_key, ring);
+    smgr_ring = ring;
+    return ring;
+}
+
+// 取出一个完成事件，记录到对应的 SMgrIO
+static bool smgr_reap_one(AioRing* ring) {
+    uint64_t user_data;
+    int res;
+    if (!aio_wait(ring, &user_data, &res)) {
+        return false;
+    }
+    SMgrIO* done = (SMgrIO*)(uintptr_t)user_data;
+    done->result = res;
+    done->pending = false;
+    return true;
+}
+
+bool smgr_start_read(uint32_t rel_oid, PageID page_id, Page* page, SMgrIO* io) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return false;
+
+    io->rel = rel;
+    io->page = page;
+    io->page_id = page_id;
+    io->pending = false;
+
+    // O_DIRECT 下未对齐的目标页无法直接异步读，走同步路径
+    AioRing* ring = NULL;
+    if (!rel->direct || smgr_page_aligned(page)) {
+        ring = smgr_get_ring();
+    }
+    if (ring) {
+        off_t offset = (off_t)page_id * sizeof(Page);
+        if (!aio_prep_read(ring, fd, page, sizeof(Page), offset, (uint64_t)(uintptr_t)io)) {
+            // 提交队列满：先提交，等一个完成腾出位置
+            aio_submit(ring);
+            if (smgr_reap_one(ring)) {
+                io->pending = aio_prep_read(ring, fd, page, sizeof(Page), offset, (uint64_t)(uintptr_t)io);
+            }
+        } else {
+            io->pending = true;
+        }
+        if (io->pending) {
+            return true;
+        }
+    }
+
+    io->result = smgr_read(rel_oid, page_id, page) ? (int)sizeof(Page) : 0;
+    return true;
+}
+
+void smgr_submit() {
+    if (smgr_ring) {
+        aio_submit(smgr_ring);
+    }
+}
+
+bool smgr_finish_read(SMgrIO* io) {
+    SMgrRelationData* rel = io->rel;
+    while (io->pending) {
+        if (!smgr_reap_one(smgr_ring)) {
+            // 等待失败：放弃该请求，下面改用 pread 重读
+            fprintf(stderr, "smgr: io_uring wait failed: %s\n", strerror(errno));
+            io->pending = false;
+            io->result = -EIO;
+        }
+    }
+
+    // 短读或内核不支持该操作时用 pread 补齐，result 为 0 表示页面超出文件末尾
+    int result = io->result;
+    if (result < 0) {
+        result = smgr_pread_page(rel->fd, io->page_id, io->page, 0);
+    } else if (result > 0 && result < (int)sizeof(Page)) {
+        result = smgr_pread_page(rel->fd, io->page_id, io->page, result);
+    }
+    smgr_unpin_fd(rel);
+    return result == (int)sizeof(Page);
+}
+
+bool smgr_write(uint32_t rel_oid, PageID page_id, const Page* page) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return false;
+
+    if (rel->direct && !smgr_page_aligned(page)) {
+        smgr_bounce_page = *page;
+        page = &smgr_bounce_page;
+    }
+
+    off_t offset = (off_t)page_id * sizeof(Page);
+    size_t done = 0;
+    while (done < sizeof(Page)) {
+        ssize_t n = pwrite(fd, (const char*)page + done, sizeof(Page) - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            fprintf(stderr, "smgr: could not write page %u of relation %u: %s\n",
+                    page_id, rel_oid, strerror(errno));
+            break;
+        }
+        done += n;
+    }
+    smgr_unpin_fd(rel);
+    return done == sizeof(Page);
+}
+
+bool smgr_extend(uint32_t rel_oid, PageID first_page, int npages) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return false;
+
+    off_t offset = (off_t)first_page * sizeof(Page);
+    off_t len = (off_t)npages * sizeof(Page);
+    int ret;
+    do {
+        ret = fallocate(fd, 0, offset, len);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+        // 退而求其次：只扩展文件长度，空间在写入时再分配
+        struct stat st;
+        ret = fstat(fd, &st);
+        if (ret == 0 && st.st_size < offset + len) {
+            ret = ftruncate(fd, offset + len);
+        }
+    }
+    if (ret < 0) {
+        fprintf(stderr, "smgr: could not extend relation %u by %d pages: %s\n",
+                rel_oid, npages, strerror(errno));
+    }
+    smgr_unpin_fd(rel);
+    return ret == 0;
+}
+
+PageID smgr_nblocks(uint32_t rel_oid) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    PageID nblocks = 0;
+    if (fstat(fd, &st) == 0) {
+        nblocks = (PageID)(st.st_size / sizeof(Page));
+    }
+    smgr_unpin_fd(rel);
+    return nblocks;
+}
+
+bool smgr_truncate(uint32_t rel_oid, PageID nblocks) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return false;
+
+    int ret;
+    do {
+        ret = ftruncate(fd, (off_t)nblocks * sizeof(Page));
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        fprintf(stderr, "smgr: could not truncate relation %u to %u pages: %s\n",
+                rel_oid, nblocks, strerror(errno));
+    }
+    smgr_unpin_fd(rel);
+
+    // 缓存的映射覆盖了截掉的部分，之后的扫描按新长度重新映射
+    LWLockAcquireExclusive(&smgr.lock);
+    smgr_drop_map(rel);
+    LWLockRelease(&smgr.lock);
+    return ret == 0;
+}
+
+SMgrMap* smgr_map(uint32_t rel_oid) {
+    SMgrRelationData* rel;
+    int fd = smgr_pin_fd(rel_oid, &rel);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        smgr_unpin_fd(rel);
+        return NULL;
+    }
+    PageID nblocks = (PageID)(st.st_size / sizeof(Page));
+
+    // 缓存的映射与当前文件页数一致时直接复用
+    LWLockAcquireShared(&smgr.lock);
+    SMgrMap* map = rel->map;
+    if (map && map->nblocks == nblocks) {
+        atomic_fetch_add(&map->refcount, 1);
+        LWLockRelease(&smgr.lock);
+        smgr_unpin_fd(rel);
+        return map;
+    }
+    LWLockRelease(&smgr.lock);
+
+    if (nblocks == 0) {
+        smgr_unpin_fd(rel);
+        return NULL;
+    }
+    size_t size = (size_t)nblocks * sizeof(Page);
+    void* addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    smgr_unpin_fd(rel);  // 映射在 fd 关闭后仍然有效
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "smgr: could not map relation %u: %s\n", rel_oid, strerror(errno));
+        return NULL;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(addr, size, MADV_SEQUENTIAL);
+#endif
+    map = malloc(sizeof(SMgrMap));
+    if (!map) {
+        munmap(addr, size);
+        return NULL;
+    }
+    map->pages = addr;
+    map->nblocks = nblocks;
+    atomic_init(&map->refcount, 2);  // 调用方一个，缓存一个
+
+    // 替换缓存的映射（其他线程可能已抢先映射了同样大小的文件，以后来者为准）
+    LWLockAcquireExclusive(&smgr.lock);
+    smgr_drop_map(rel);
+    rel->map = map;
+    LWLockRelease(&smgr.lock);
+    return map;
+}
+
+void smgr_unmap(SMgrMap* map) {
+    if (map && atomic_fetch_sub(&map->refcount, 1) == 1) {
+        munmap((void*)map->pages, (size_t)map->nblocks * sizeof(Page));
+        free(map);
+    }
+}
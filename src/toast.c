@@ -0,0 +1,291 @@
+#include "toast.h"
+#include "tuple.h"
+#include "smgr.h"
+#include "lock.h"
+#include "memctx.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define MAX_TOAST_RELS MAX_SMGR_RELS
+
+_Static_assert(TOAST_TUPLE_TARGET <= TEXT_LEN_MASK, "inline TEXT must fit the length word");
+
+// 一个表的 .toast 文件
+typedef struct ToastRelation {
+    uint32_t rel_oid;
+    int fd;
+    atomic_ullong end;   // 文件末尾，追加时原子地预留空间
+} ToastRelation;
+
+// 已打开的 .toast 文件，registry_lock 保护
+static struct {
+    ToastRelation* rels[MAX_TOAST_RELS];
+    int nrels;
+    LWLock registry_lock;
+} toast_registry;
+
+static pthread_once_t toast_registry_once = PTHREAD_ONCE_INIT;
+
+static void toast_registry_init(void) {
+    LWLockInit(&toast_registry.registry_lock, TRANCHE_TOAST_LOCK);
+}
+
+static ToastRelation* toast_lookup(uint32_t rel_oid) {
+    for (int i = 0; i < toast_registry.nrels; i++) {
+        if (toast_registry.rels[i]->rel_oid == rel_oid) {
+            return toast_registry.rels[i];
+        }
+    }
+    return NULL;
+}
+
+// 取表的 .toast 文件，首次访问时按存储管理层登记的表文件路径打开（不存在则创建）
+static ToastRelation* toast_open(uint32_t rel_oid) {
+    pthread_once(&toast_registry_once, toast_registry_init);
+
+    LWLockAcquireShared(&toast_registry.registry_lock);
+    ToastRelation* rel = toast_lookup(rel_oid);
+    LWLockRelease(&toast_registry.registry_lock);
+    if (rel) return rel;
+
+    LWLockAcquireExclusive(&toast_registry.registry_lock);
+    rel = toast_lookup(rel_oid);
+    if (!rel && toast_registry.nrels < MAX_TOAST_RELS) {
+        char table_path[SMGR_MAX_PATH];
+        char path[SMGR_MAX_PATH + sizeof(TOAST_FILE_SUFFIX)];
+        if (smgr_relpath(rel_oid, table_path, sizeof(table_path))) {
+            snprintf(path, sizeof(path), "%s%s", table_path, TOAST_FILE_SUFFIX);
+            int fd = open(path, O_RDWR | O_CREAT, 0644);
+            rel = fd >= 0 ? malloc(sizeof(ToastRelation)) : NULL;
+            if (rel) {
+                rel->rel_oid = rel_oid;
+                rel->fd = fd;
+                atomic_init(&rel->end, (unsigned long long)lseek(fd, 0, SEEK_END));
+                toast_registry.rels[toast_registry.nrels++] = rel;
+            } else {
+                if (fd >= 0) close(fd);
+                perror("toast: cannot open toast file");
+            }
+        }
+    }
+    LWLockRelease(&toast_registry.registry_lock);
+    return rel;
+}
+
+// 把值追加到 .toast 文件，填好指针中的 offset
+static bool toast_write(uint32_t rel_oid, const uint8_t* data, ToastPointer* ptr) {
+    ToastRelation* rel = toast_open(rel_oid);
+    if (!rel) return false;
+    ptr->offset = atomic_fetch_add(&rel->end, ptr->ext_size);
+    size_t done = 0;
+    while (done < ptr->ext_size) {
+        ssize_t n = pwrite(rel->fd, data + done, ptr->ext_size - done, (off_t)(ptr->offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            perror("toast: write failed");
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+static bool toast_read(uint32_t rel_oid, const ToastPointer* ptr, uint8_t* data) {
+    ToastRelation* rel = toast_open(rel_oid);
+    if (!rel) return false;
+    size_t done = 0;
+    while (done < ptr->ext_size) {
+        ssize_t n = pread(rel->fd, data + done, ptr->ext_size - done, (off_t)(ptr->offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            fprintf(stderr, "toast: short read of value at %llu in relation %u\n",
+                    (unsigned long long)ptr->offset, rel_oid);
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// 解压 zlib 数据为以 '\0' 结尾的字符串
+static char* toast_decompress(const uint8_t* data, size_t size, uint32_t raw_size) {
+    char* str = palloc((size_t)raw_size + 1);
+    if (!str) return NULL;
+    uLongf dest_len = raw_size;
+    if (uncompress((Bytef*)str, &dest_len, data, size) != Z_OK || dest_len != raw_size) {
+        fprintf(stderr, "toast: corrupt compressed value\n");
+        pfree(str);
+        return NULL;
+    }
+    str[raw_size] = '\0';
+    return str;
+}
+
+char* detoast_text(uint32_t rel_oid, uint16_t header, const uint8_t* data) {
+    size_t len = header & TEXT_LEN_MASK;
+    if (header & TEXT_EXTERNAL) {
+        ToastPointer ptr;
+        memcpy(&ptr, data, sizeof(ToastPointer));
+        uint8_t* buf = palloc((size_t)ptr.ext_size + 1);
+        if (!buf) return NULL;
+        if (!toast_read(rel_oid, &ptr, buf)) {
+            pfree(buf);
+            return NULL;
+        }
+        if (ptr.ext_size < ptr.raw_size) {
+            char* str = toast_decompress(buf, ptr.ext_size, ptr.raw_size);
+            pfree(buf);
+            return str;
+        }
+        buf[ptr.ext_size] = '\0';
+        return (char*)buf;
+    }
+    if (header & TEXT_COMPRESSED) {
+        uint32_t raw_size;
+        memcpy(&raw_size, data, sizeof(uint32_t));
+        return toast_decompress(data + sizeof(uint32_t), len - sizeof(uint32_t), raw_size);
+    }
+    char* str = palloc(len + 1);
+    if (!str) return NULL;
+    memcpy(str, data, len);
+    str[len] = '\0';
+    return str;
+}
+
+// heap_toast_serialize 中一个 TEXT 列的处理状态
+typedef struct ToastAttr {
+    size_t raw_size;
+    uint8_t* compressed;     // uint32 原长 + zlib 数据，NULL 表示未压缩
+    size_t compressed_size;  // 含 4 字节原长
+    bool tried_compress;
+    bool external;
+    ToastPointer ptr;
+} ToastAttr;
+
+// 列在元组中占用的字节数（不含长度字）
+static size_t toast_attr_size(const ToastAttr* attr) {
+    if (attr->external) return sizeof(ToastPointer);
+    return attr->compressed ? attr->compressed_size : attr->raw_size;
+}
+
+static bool toast_compress(ToastAttr* attr, const char* str) {
+    uLongf bound = compressBound(attr->raw_size);
+    uint8_t* buf = malloc(sizeof(uint32_t) + bound);
+    if (!buf) return false;
+    uint32_t raw_size = (uint32_t)attr->raw_size;
+    memcpy(buf, &raw_size, sizeof(uint32_t));
+    if (compress2(buf + sizeof(uint32_t), &bound, (const Bytef*)str, attr->raw_size,
+                  Z_DEFAULT_COMPRESSION) != Z_OK ||
+        sizeof(uint32_t) + bound >= attr->raw_size) {
+        free(buf);  // 压缩不划算，保留原文
+        return false;
+    }
+    attr->compressed = buf;
+    attr->compressed_size = sizeof(uint32_t) + bound;
+    return true;
+}
+
+size_t heap_toast_serialize(uint32_t rel_oid, const Tuple* tuple, uint8_t* buffer) {
+    size_t size = tuple_serialized_size(tuple);
+    if (size <= TOAST_TUPLE_THRESHOLD || tuple->col_count > MAX_COLS) {
+        return size <= MAX_TUPLE_SIZE ? serialize_tuple(tuple, buffer) : 0;
+    }
+
+    ToastAttr attrs[MAX_COLS];
+    memset(attrs, 0, sizeof(attrs));
+    for (int i = 0; i < tuple->col_count; i++) {
+        const char* str = tuple->columns[i].value.str_val;
+        if (tuple->columns[i].type == TEXT_TYPE && str) {
+            attrs[i].raw_size = strlen(str);
+        }
+    }
+
+    // 先从最长的列开始压缩
+    while (size > TOAST_TUPLE_TARGET) {
+        int victim = -1;
+        for (int i = 0; i < tuple->col_count; i++) {
+            if (attrs[i].raw_size >= TOAST_MIN_COMPRESS && !attrs[i].tried_compress &&
+                (victim < 0 || attrs[i].raw_size > attrs[victim].raw_size)) {
+                victim = i;
+            }
+        }
+        if (victim < 0) break;
+        attrs[victim].tried_compress = true;
+        if (toast_compress(&attrs[victim], tuple->columns[victim].value.str_val)) {
+            size -= attrs[victim].raw_size - attrs[victim].compressed_size;
+        }
+    }
+
+    // 仍然太大就把最长的列移到 .toast 文件
+    bool ok = true;
+    while (ok && size > TOAST_TUPLE_TARGET) {
+        int victim = -1;
+        for (int i = 0; i < tuple->col_count; i++) {
+            if (!attrs[i].external && toast_attr_size(&attrs[i]) > sizeof(ToastPointer) &&
+                (victim < 0 || toast_attr_size(&attrs[i]) > toast_attr_size(&attrs[victim]))) {
+                victim = i;
+            }
+        }
+        if (victim < 0) break;
+        ToastAttr* attr = &attrs[victim];
+        const uint8_t* data = attr->compressed ? attr->compressed + sizeof(uint32_t)
+                                               : (const uint8_t*)tuple->columns[victim].value.str_val;
+        attr->ptr.raw_size = (uint32_t)attr->raw_size;
+        attr->ptr.ext_size = (uint32_t)(attr->compressed ? attr->compressed_size - sizeof(uint32_t)
+                                                         : attr->raw_size);
+        ok = toast_write(rel_oid, data, &attr->ptr);
+        if (ok) {
+            size -= toast_attr_size(attr) - sizeof(ToastPointer);
+            attr->external = true;
+        }
+    }
+
+    size_t written = 0;
+    if (ok && size <= MAX_TUPLE_SIZE) {
+        TextDatum datums[MAX_COLS];
+        memset(datums, 0, sizeof(datums));
+        for (int i = 0; i < tuple->col_count; i++) {
+            if (attrs[i].external) {
+                datums[i].header = TEXT_EXTERNAL | sizeof(ToastPointer);
+                datums[i].data = (const uint8_t*)&attrs[i].ptr;
+            } else if (attrs[i].compressed) {
+                datums[i].header = TEXT_COMPRESSED | (uint16_t)attrs[i].compressed_size;
+                datums[i].data = attrs[i].compressed;
+            }
+        }
+        written = serialize_tuple_datums(tuple, datums, buffer);
+    }
+    for (int i = 0; i < tuple->col_count; i++) {
+        free(attrs[i].compressed);
+    }
+    return written;
+}
+
+void toast_sync_all() {
+    pthread_once(&toast_registry_once, toast_registry_init);
+    LWLockAcquireShared(&toast_registry.registry_lock);
+    for (int i = 0; i < toast_registry.nrels; i++) {
+        if (fsync(toast_registry.rels[i]->fd) != 0) {
+            perror("toast: fsync failed");
+        }
+    }
+    LWLockRelease(&toast_registry.registry_lock);
+}
+
+void toast_shutdown() {
+    pthread_once(&toast_registry_once, toast_registry_init);
+    LWLockAcquireExclusive(&toast_registry.registry_lock);
+    for (int i = 0; i < toast_registry.nrels; i++) {
+        close(toast_registry.rels[i]->fd);
+        free(toast_registry.rels[i]);
+    }
+    toast_registry.nrels = 0;
+    LWLockRelease(&toast_registry.registry_lock);
+}
@@ -1,6 +1,8 @@
 #include "tuple.h"
 #include "catalog.h"
 #include "parser.h"
+#include "toast.h"
+#include "memctx.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -11,20 +13,23 @@ Tuple* create_tuple(const TableMeta* meta, const void** values) {
     if (!meta || meta->col_count == 0) return NULL;
     
     // 分配元组内存
-    Tuple* tuple = (Tuple*)malloc(sizeof(Tuple));
+    Tuple* tuple = (Tuple*)palloc(sizeof(Tuple));
     if (!tuple) return NULL;
     
     // 初始化元组头
     tuple->oid = 0;         // 由系统分配
     tuple->xmin = 0;        // 事务开始时设置
     tuple->xmax = 0;        // 事务结束时设置
+    tuple->ctid.page_id = INVALID_PAGE_ID;
+    tuple->ctid.slot = INVALID_SLOT;
+    tuple->infomask = 0;
     tuple->deleted = false;
     tuple->col_count = meta->col_count;
     
     // 分配列数组
-    tuple->columns = (Column*)malloc(meta->col_count * sizeof(Column));
+    tuple->columns = (Column*)palloc(meta->col_count * sizeof(Column));
     if (!tuple->columns) {
-        free(tuple);
+        pfree(tuple);
         return NULL;
     }
     
@@ -46,17 +51,17 @@ Tuple* create_tuple(const TableMeta* meta, const void** values) {
                     tuple->columns[i].value.bool_val = false;
                     break;
                 case TEXT_TYPE:
-                    tuple->columns[i].value.str_val = strdup("");
+                    tuple->columns[i].value.str_val = pstrdup("");
                     if (!tuple->columns[i].value.str_val) {
                         perror("Failed to allocate empty string");
                         // 清理已分配的资源
                         for (int j = 0; j < i; j++) {
                             if (tuple->columns[j].type == TEXT_TYPE) {
-                                free(tuple->columns[j].value.str_val);
+                                pfree(tuple->columns[j].value.str_val);
                             }
                         }
-                        free(tuple->columns);
-                        free(tuple);
+                        pfree(tuple->columns);
+                        pfree(tuple);
                         return NULL;
                     }
                     break;
@@ -82,7 +87,7 @@ Tuple* create_tuple(const TableMeta* meta, const void** values) {
                     break;
                 case TEXT_TYPE: {
                     const char* str = (const char*)values[i];
-                    tuple->columns[i].value.str_val = strdup(str);
+                    tuple->columns[i].value.str_val = pstrdup(str);
                     break;
                 }
                 case DATE_TYPE:
@@ -102,20 +107,22 @@ Tuple* create_tuple(const TableMeta* meta, const void** values) {
 Tuple* copy_tuple(const Tuple* src) {
     if (!src) return NULL;
     
-    Tuple* dest = (Tuple*)malloc(sizeof(Tuple));
+    Tuple* dest = (Tuple*)palloc(sizeof(Tuple));
     if (!dest) return NULL;
     
     // 复制元组头
     dest->oid = src->oid;
     dest->xmin = src->xmin;
     dest->xmax = src->xmax;
+    dest->ctid = src->ctid;
+    dest->infomask = src->infomask;
     dest->deleted = src->deleted;
     dest->col_count = src->col_count;
     
     // 分配列数组
-    dest->columns = (Column*)malloc(dest->col_count * sizeof(Column));
+    dest->columns = (Column*)palloc(dest->col_count * sizeof(Column));
     if (!dest->columns) {
-        free(dest);
+        pfree(dest);
         return NULL;
     }
     
@@ -125,8 +132,9 @@ Tuple* copy_tuple(const Tuple* src) {
         
         switch (src->columns[i].type) {
             case TEXT_TYPE:
-                // 字符串需要深度复制
-                dest->columns[i].value.str_val = strdup(src->columns[i].value.str_val);
+                // 字符串需要深度复制（未取出的大字段为 NULL）
+                dest->columns[i].value.str_val = src->columns[i].value.str_val ?
+                                                 pstrdup(src->columns[i].value.str_val) : NULL;
                 break;
             default:
                 // 其他类型直接复制值
@@ -145,17 +153,58 @@ void free_tuple(Tuple* tuple) {
             for (int i = 0; i < tuple->col_count; i++) {
                 if (tuple->columns[i].type == TEXT_TYPE && 
                     tuple->columns[i].value.str_val) {
-                    free(tuple->columns[i].value.str_val);
+                    pfree(tuple->columns[i].value.str_val);
                 }
             }
-            free(tuple->columns);
+            pfree(tuple->columns);
         }
-        free(tuple);
+        pfree(tuple);
     }
 }
 
 // 序列化元组
+// 计算元组序列化后的字节数，与 serialize_tuple 的格式一致
+size_t tuple_serialized_size(const Tuple* tuple) {
+    return tuple_serialized_size_datums(tuple, NULL);
+}
+
+size_t tuple_serialized_size_datums(const Tuple* tuple, const TextDatum* datums) {
+    if (!tuple) return 0;
+
+    // oid, xmin, xmax, ctid, infomask, deleted, col_count
+    size_t size = 3 * sizeof(uint32_t) + sizeof(PageID) + sizeof(uint16_t) + 3;
+    for (int i = 0; i < tuple->col_count; i++) {
+        size += 1;  // 类型
+        switch (tuple->columns[i].type) {
+            case INT4_TYPE:
+            case DATE_TYPE:
+                size += sizeof(int32_t);
+                break;
+            case FLOAT_TYPE:
+                size += sizeof(float);
+                break;
+            case BOOL_TYPE:
+                size += 1;
+                break;
+            case TEXT_TYPE: {
+                if (datums && datums[i].data) {
+                    size += sizeof(uint16_t) + (datums[i].header & TEXT_LEN_MASK);
+                    break;
+                }
+                const char* str = tuple->columns[i].value.str_val;
+                size += sizeof(uint16_t) + (str ? strlen(str) : 0);
+                break;
+            }
+        }
+    }
+    return size;
+}
+
 size_t serialize_tuple(const Tuple* tuple, uint8_t* buffer) {
+    return serialize_tuple_datums(tuple, NULL, buffer);
+}
+
+size_t serialize_tuple_datums(const Tuple* tuple, const TextDatum* datums, uint8_t* buffer) {
     if (!tuple || !buffer) return 0;
     
     uint8_t* ptr = buffer;
@@ -167,6 +216,11 @@ size_t serialize_tuple(const Tuple* tuple, uint8_t* buffer) {
     ptr += sizeof(uint32_t);
     memcpy(ptr, &tuple->xmax, sizeof(uint32_t));
     ptr += sizeof(uint32_t);
+    memcpy(ptr, &tuple->ctid.page_id, sizeof(PageID));
+    ptr += sizeof(PageID);
+    memcpy(ptr, &tuple->ctid.slot, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    *ptr++ = tuple->infomask;
     
     *ptr++ = tuple->deleted ? 1 : 0;
     *ptr++ = tuple->col_count;
@@ -192,8 +246,20 @@ size_t serialize_tuple(const Tuple* tuple, uint8_t* buffer) {
                 break;
                 
             case TEXT_TYPE: {
+                if (datums && datums[i].data) {
+                    // 压缩或外部存储的形式，由 heap_toast_serialize 生成
+                    size_t len = datums[i].header & TEXT_LEN_MASK;
+                    memcpy(ptr, &datums[i].header, sizeof(uint16_t));
+                    ptr += sizeof(uint16_t);
+                    memcpy(ptr, datums[i].data, len);
+                    ptr += len;
+                    break;
+                }
                 const char* str = tuple->columns[i].value.str_val;
                 size_t len = str ? strlen(str) : 0;
+                if (len > TEXT_LEN_MASK) {
+                    return 0;  // 放不进长度字，需先经 heap_toast_serialize
+                }
                 
                 // 写入字符串长度（16位）
                 uint16_t len16 = (uint16_t)len;
@@ -215,6 +281,11 @@ size_t serialize_tuple(const Tuple* tuple, uint8_t* buffer) {
 
 // 反序列化元组
 size_t deserialize_tuple(Tuple* tuple, const uint8_t* buffer) {
+    return deserialize_tuple_attrs(tuple, buffer, 0, NULL);
+}
+
+size_t deserialize_tuple_attrs(Tuple* tuple, const uint8_t* buffer, uint32_t rel_oid,
+                               const bool* needed) {
     if (!tuple || !buffer) return 0;
     
     const uint8_t* ptr = buffer;
@@ -226,12 +297,25 @@ size_t deserialize_tuple(Tuple* tuple, const uint8_t* buffer) {
     ptr += sizeof(uint32_t);
     memcpy(&tuple->xmax, ptr, sizeof(uint32_t));
     ptr += sizeof(uint32_t);
+    memcpy(&tuple->ctid.page_id, ptr, sizeof(PageID));
+    ptr += sizeof(PageID);
+    memcpy(&tuple->ctid.slot, ptr, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    tuple->infomask = *ptr++;
     
     tuple->deleted = *ptr++ != 0;
     tuple->col_count = *ptr++;
+    if (needed) {
+        // 最后一个需要的列之后的不解析
+        int natts = 0;
+        for (int i = 0; i < tuple->col_count; i++) {
+            if (needed[i]) natts = i + 1;
+        }
+        tuple->col_count = natts;
+    }
     
     // 分配列数组
-    tuple->columns = (Column*)malloc(tuple->col_count * sizeof(Column));
+    tuple->columns = (Column*)palloc((tuple->col_count ? tuple->col_count : 1) * sizeof(Column));
     if (!tuple->columns) return 0;
     
     // 反序列化每列数据
@@ -255,20 +339,43 @@ size_t deserialize_tuple(Tuple* tuple, const uint8_t* buffer) {
                 break;
                 
             case TEXT_TYPE: {
-                uint16_t len;
-                memcpy(&len, ptr, sizeof(uint16_t));
+                uint16_t header;
+                memcpy(&header, ptr, sizeof(uint16_t));
                 ptr += sizeof(uint16_t);
+                uint16_t len = header & TEXT_LEN_MASK;
+
+                if (needed && !needed[i]) {
+                    // 用不到的列不复制、不解压、不读 .toast 文件
+                    tuple->columns[i].value.str_val = NULL;
+                    ptr += len;
+                    break;
+                }
+                if (header & (TEXT_COMPRESSED | TEXT_EXTERNAL)) {
+                    tuple->columns[i].value.str_val = detoast_text(rel_oid, header, ptr);
+                    ptr += len;
+                    if (!tuple->columns[i].value.str_val) {
+                        for (int j = 0; j < i; j++) {
+                            if (tuple->columns[j].type == TEXT_TYPE) {
+                                pfree(tuple->columns[j].value.str_val);
+                            }
+                        }
+                        pfree(tuple->columns);
+                        tuple->columns = NULL;
+                        return 0;
+                    }
+                    break;
+                }
                 
                 // 分配字符串内存
-                tuple->columns[i].value.str_val = (char*)malloc(len + 1);
+                tuple->columns[i].value.str_val = (char*)palloc(len + 1);
                 if (!tuple->columns[i].value.str_val) {
                     // 内存分配失败，清理已分配的资源
                     for (int j = 0; j < i; j++) {
                         if (tuple->columns[j].type == TEXT_TYPE) {
-                            free(tuple->columns[j].value.str_val);
+                            pfree(tuple->columns[j].value.str_val);
                         }
                     }
-                    free(tuple->columns);
+                    pfree(tuple->columns);
                     tuple->columns = NULL;
                     return 0;
                 }
@@ -287,6 +394,142 @@ size_t deserialize_tuple(Tuple* tuple, const uint8_t* buffer) {
     return ptr - buffer;
 }
 
+// 定长列的宽度，变长列返回 0
+static size_t tuple_attr_width(DataType type) {
+    switch (type) {
+        case INT4_TYPE:
+        case DATE_TYPE:
+            return sizeof(int32_t);
+        case FLOAT_TYPE:
+            return sizeof(float);
+        case BOOL_TYPE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void tuple_init_attcache(TableMeta* meta) {
+    memset(meta->attcacheoff, 0, sizeof(meta->attcacheoff));
+    size_t off = TUPLE_HEADER_SIZE;
+    for (int i = 0; i < meta->col_count && i < MAX_COLS; i++) {
+        meta->attcacheoff[i] = (uint16_t)off;
+        size_t width = tuple_attr_width(meta->cols[i].type);
+        if (width == 0) break;  // 之后的列位置取决于变长值的长度
+        off += 1 + width;
+    }
+}
+
+bool tuple_view_init(TupleView* view, const uint8_t* data, uint16_t length, uint32_t rel_oid) {
+    if (!view || !data || length < TUPLE_HEADER_SIZE) return false;
+
+    const uint8_t* ptr = data;
+    memcpy(&view->oid, ptr, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(&view->xmin, ptr, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(&view->xmax, ptr, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(&view->ctid.page_id, ptr, sizeof(PageID));
+    ptr += sizeof(PageID);
+    memcpy(&view->ctid.slot, ptr, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    view->infomask = *ptr++;
+    ptr++;  // deleted
+    view->col_count = *ptr;
+
+    view->data = data;
+    view->length = length;
+    view->rel_oid = rel_oid;
+    view->attcacheoff = NULL;
+    return true;
+}
+
+// 定位第 attno 列（类型字节之后），越界或类型不符返回 NULL
+static const uint8_t* tuple_view_attr(const TupleView* view, int attno, DataType type) {
+    if (!view || attno < 0 || attno >= view->col_count) return NULL;
+
+    // 从不超过 attno 的最后一个缓存偏移开始走，前导定长列直接定位
+    int start = 0;
+    if (view->attcacheoff) {
+        for (start = attno; start > 0 && view->attcacheoff[start] == 0; start--);
+        if (view->attcacheoff[start] == 0 || view->attcacheoff[start] >= view->length) start = 0;
+    }
+    const uint8_t* ptr = view->data + (start > 0 ? view->attcacheoff[start] : TUPLE_HEADER_SIZE);
+    const uint8_t* end = view->data + view->length;
+    for (int i = start; ptr < end; i++) {
+        DataType col_type = (DataType)*ptr++;
+        if (i == attno) {
+            bool match = col_type == type || (type == INT4_TYPE && col_type == DATE_TYPE);
+            return match ? ptr : NULL;
+        }
+        if (col_type == TEXT_TYPE) {
+            uint16_t header;
+            memcpy(&header, ptr, sizeof(uint16_t));
+            ptr += sizeof(uint16_t) + (header & TEXT_LEN_MASK);
+        } else {
+            size_t width = tuple_attr_width(col_type);
+            if (width == 0) return NULL;
+            ptr += width;
+        }
+    }
+    return NULL;
+}
+
+bool tuple_view_get_int(const TupleView* view, int attno, int32_t* value) {
+    const uint8_t* ptr = tuple_view_attr(view, attno, INT4_TYPE);
+    if (!ptr) return false;
+    memcpy(value, ptr, sizeof(int32_t));
+    return true;
+}
+
+bool tuple_view_get_float(const TupleView* view, int attno, float* value) {
+    const uint8_t* ptr = tuple_view_attr(view, attno, FLOAT_TYPE);
+    if (!ptr) return false;
+    memcpy(value, ptr, sizeof(float));
+    return true;
+}
+
+bool tuple_view_get_bool(const TupleView* view, int attno, bool* value) {
+    const uint8_t* ptr = tuple_view_attr(view, attno, BOOL_TYPE);
+    if (!ptr) return false;
+    *value = *ptr != 0;
+    return true;
+}
+
+const char* tuple_view_get_text(const TupleView* view, int attno, size_t* len) {
+    const uint8_t* ptr = tuple_view_attr(view, attno, TEXT_TYPE);
+    if (!ptr) return NULL;
+    uint16_t header;
+    memcpy(&header, ptr, sizeof(uint16_t));
+    if (header & (TEXT_COMPRESSED | TEXT_EXTERNAL)) return NULL;
+    *len = header & TEXT_LEN_MASK;
+    return (const char*)(ptr + sizeof(uint16_t));
+}
+
+char* tuple_view_copy_text(const TupleView* view, int attno) {
+    const uint8_t* ptr = tuple_view_attr(view, attno, TEXT_TYPE);
+    if (!ptr) return NULL;
+    uint16_t header;
+    memcpy(&header, ptr, sizeof(uint16_t));
+    return detoast_text(view->rel_oid, header, ptr + sizeof(uint16_t));
+}
+
+Tuple* tuple_view_materialize(const TupleView* view, const bool* needed) {
+    Tuple* tuple = palloc(sizeof(Tuple));
+    if (!tuple) return NULL;
+    size_t size = deserialize_tuple_attrs(tuple, view->data, view->rel_oid, needed);
+    if (size == 0) {
+        pfree(tuple);
+        return NULL;
+    }
+    if (size > view->length || (!needed && size != view->length)) {
+        free_tuple(tuple);
+        return NULL;
+    }
+    return tuple;
+}
+
 // 获取元组值
 void* tuple_get_value(const Tuple* tuple, uint8_t col_index) {
     if (!tuple || col_index >= tuple->col_count) {
@@ -334,11 +577,11 @@ bool tuple_set_value(Tuple* tuple, uint8_t col_index, const void* value) {
             
             // 释放旧字符串
             if (tuple->columns[col_index].value.str_val) {
-                free(tuple->columns[col_index].value.str_val);
+                pfree(tuple->columns[col_index].value.str_val);
             }
             
             // 分配并复制新字符串
-            char* new_str = strdup(str);
+            char* new_str = pstrdup(str);
             if (!new_str) return false;
             
             tuple->columns[col_index].value.str_val = new_str;
@@ -615,3 +858,40 @@ bool eval_condition(const Condition* cond, const Tuple* t, const TableMeta* meta
     fprintf(stderr, "No matching column found for condition.\n");
     return false;
 }
+
+bool tuple_view_is_visible(TransactionManager* txmgr, const TupleView* view, uint32_t current_xid) {
+    // is_tuple_visible 只看 xmin/xmax
+    Tuple header = { .xmin = view->xmin, .xmax = view->xmax };
+    return is_tuple_visible(txmgr, &header, current_xid);
+}
+
+// 与 eval_condition 的比较规则相同，TEXT 只在压缩或外部存储时才复制
+bool tuple_view_eval_condition(const Condition* cond, const TupleView* view, const TableMeta* meta) {
+    for (int i = 0; i < view->col_count && i < meta->col_count; i++) {
+        if (strcmp(meta->cols[i].name, cond->column) != 0) continue;
+
+        if (strcmp(cond->op, "=") != 0) {
+            fprintf(stderr, "Unsupported operator: '%s'\n", cond->op);
+            return false;
+        }
+        if (meta->cols[i].type == TEXT_TYPE) {
+            size_t len;
+            const char* str = tuple_view_get_text(view, i, &len);
+            if (str) {
+                return len == strlen(cond->value) && memcmp(str, cond->value, len) == 0;
+            }
+            char* copy = tuple_view_copy_text(view, i);
+            bool match = copy && strcmp(copy, cond->value) == 0;
+            pfree(copy);
+            return match;
+        } else if (meta->cols[i].type == INT4_TYPE) {
+            int32_t val;
+            return tuple_view_get_int(view, i, &val) && val == atoi(cond->value);
+        }
+        fprintf(stderr, "Unsupported column type: %d\n", meta->cols[i].type);
+        return false;
+    }
+
+    fprintf(stderr, "No matching column found for condition.\n");
+    return false;
+}
@@ -358,3 +358,12 @@ bool txmgr_is_committed(const TransactionManager* txmgr, uint32_t xid) {
       return IS_COMMITTED(xid, txmgr);
 }
 
+bool txmgr_is_in_progress(const TransactionManager* txmgr, uint32_t xid) {
+    if (xid == INVALID_XID) return false;
+    for (int i = 0; i < MAX_CONCURRENT_TRANS; i++) {
+        if (txmgr->transactions[i].xid == xid) {
+            return txmgr->transactions[i].state == TRANS_ACTIVE;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,351 @@
+#include "vacuum.h"
+#include "page.h"
+#include "prune.h"
+#include "fsm.h"
+#include "vm.h"
+#include "smgr.h"
+#include "txmgr.h"
+#include "catalog.h"
+#include "config.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+// 一次清理过程中的状态
+typedef struct VacuumState {
+    MiniDB* db;
+    TableMeta* meta;
+    const VacuumParams* params;
+    char fullpath[PATH_MAX];
+    FreeSpaceMap* fsm;
+    VisibilityMap* vm;
+    BufferAccessStrategy strategy;
+    uint32_t oldest_xid;   // 清理开始时的最老活动事务
+    int cost_balance;      // 自上次休眠以来累计的代价
+    VacuumStats stats;
+} VacuumState;
+
+void pgstat_count_heap_insert(TableMeta* meta) {
+    atomic_fetch_add_explicit(&meta->n_live_tup, 1, memory_order_relaxed);
+}
+
+void pgstat_count_heap_dead(TableMeta* meta, int n) {
+    atomic_fetch_add_explicit(&meta->n_dead_tup, n, memory_order_relaxed);
+}
+
+void pgstat_count_heap_prune(TableMeta* meta, int n) {
+    // 计数只是估计，回收数可能超过计数（如重启后），减到 0 为止
+    unsigned int old = atomic_load_explicit(&meta->n_dead_tup, memory_order_relaxed);
+    unsigned int new_value;
+    do {
+        new_value = old > (unsigned int)n ? old - n : 0;
+    } while (!atomic_compare_exchange_weak(&meta->n_dead_tup, &old, new_value));
+}
+
+static bool vacuum_cancelled(const VacuumState* vs) {
+    return vs->params->cancel && atomic_load(vs->params->cancel);
+}
+
+// 代价累计到上限时休眠，超出越多睡得越久，最多 4 倍 cost_delay
+static void vacuum_delay_point(VacuumState* vs) {
+    const VacuumParams* params = vs->params;
+    if (params->cost_delay <= 0 || vs->cost_balance < params->cost_limit) {
+        return;
+    }
+    long msec = (long)params->cost_delay * vs->cost_balance / params->cost_limit;
+    if (msec > params->cost_delay * 4L) {
+        msec = params->cost_delay * 4L;
+    }
+    usleep(msec * 1000);
+    vs->cost_balance = 0;
+}
+
+// 读入一页并按是否命中缓冲池计代价
+static Buffer vacuum_read_buffer(VacuumState* vs, PageID page_id) {
+    Buffer buf = ReadBufferIfCached(vs->meta->oid, page_id);
+    if (BufferIsValid(buf)) {
+        vs->cost_balance += VACUUM_COST_PAGE_HIT;
+        return buf;
+    }
+    vs->cost_balance += VACUUM_COST_PAGE_MISS;
+    return ReadBufferExtended(vs->meta->oid, page_id, vs->fullpath, RBM_NORMAL, vs->strategy);
+}
+
+// 剪枝一页，记录空闲空间和可见性
+static void vacuum_page(VacuumState* vs, PageID page_id) {
+    Buffer buf = vacuum_read_buffer(vs, page_id);
+    if (!BufferIsValid(buf)) return;
+    Page* page = BufferGetPage(buf);
+    vs->stats.scanned_pages++;
+
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    size_t free_space = PAGE_EMPTY_FREE_SPACE;
+    if (!page_is_new(page)) {
+        PruneResult presult;
+        uint32_t old_prune_xid = page->header.prune_xid;
+        int nremoved = heap_page_prune(page, &vs->db->tx_mgr, vs->oldest_xid, &presult);
+        if (nremoved > 0) {
+            vs->stats.tuples_removed += nremoved;
+        }
+        if (nremoved > 0 || page->header.prune_xid != old_prune_xid) {
+            vs->cost_balance += VACUUM_COST_PAGE_DIRTY;
+            MarkBufferDirty(buf);
+        }
+        vs->stats.live_tuples += presult.nlive;
+        if (presult.all_visible && vs->vm) {
+            visibilitymap_set(vs->vm, page_id);
+        }
+        free_space = page_free_space(page);
+    }
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+
+    if (vs->fsm) {
+        RecordPageWithFreeSpace(vs->fsm, page_id, free_space);
+    }
+}
+
+// 页面是否没有任何槽位（预分配后从未使用过的页也算）；读不到的页视为空
+static bool vacuum_page_is_empty(VacuumState* vs, PageID page_id) {
+    Buffer buf = vacuum_read_buffer(vs, page_id);
+    if (!BufferIsValid(buf)) return true;
+    Page* page = BufferGetPage(buf);
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    bool empty = page_is_new(page) || page->header.slot_count == 0;
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+    return empty;
+}
+
+/*
+ * 截掉表尾的空页 (类似 pg 的 lazy_truncate_heap)。持有扩展锁，期间没有人能扩展表；
+ * 插入在取到页锁后会检查页号是否仍在 last_page 之内。先下调 last_page，
+ * 再逐页复查：下调之前已取到页锁的插入可能刚写入，遇到这样的页就把 last_page 退回到它。
+ * 第一次检查之后 last_page 一直不小于仍可能被写入的页，截掉的页不会再有人写。
+ */
+static void vacuum_truncate_heap(VacuumState* vs) {
+    TableMeta* meta = vs->meta;
+    // 映射扫描可能正在读取表尾，截断后访问会触发 SIGBUS
+    if (db_config.mmap_scans) return;
+
+    LWLockAcquireExclusive(&meta->extension_lock);
+    PageID old_last = meta->last_page;
+    PageID new_last = old_last;
+    while (new_last > meta->first_page && !vacuum_cancelled(vs) &&
+           vacuum_page_is_empty(vs, new_last)) {
+        new_last--;
+    }
+    if (new_last < old_last) {
+        meta->last_page = new_last;
+        for (PageID page_id = old_last; page_id > new_last; page_id--) {
+            if (!vacuum_page_is_empty(vs, page_id)) {
+                new_last = page_id;
+                meta->last_page = new_last;
+                break;
+            }
+        }
+    }
+    if (new_last < old_last) {
+        DropRelationBuffers(meta->oid, new_last + 1);
+        smgr_truncate(meta->oid, new_last + 1);
+        if (vs->fsm) FreeSpaceMapTruncateRel(vs->fsm, new_last + 1);
+        if (vs->vm) visibilitymap_truncate(vs->vm, new_last + 1);
+        save_table_meta_to_file(meta, vs->db->data_dir);
+        vs->stats.truncated_pages = old_last - new_last;
+    }
+    LWLockRelease(&meta->extension_lock);
+}
+
+bool vacuum_table(MiniDB* db, TableMeta* meta, const VacuumParams* params, VacuumStats* stats) {
+    VacuumState vs;
+    memset(&vs, 0, sizeof(vs));
+    vs.db = db;
+    vs.meta = meta;
+    vs.params = params;
+    int len = snprintf(vs.fullpath, sizeof(vs.fullpath), "%s/%s", db->data_dir, meta->filename);
+    if (len < 0 || (size_t)len >= sizeof(vs.fullpath) || !smgr_open(meta->oid, vs.fullpath)) {
+        return false;
+    }
+
+    while (atomic_flag_test_and_set(&meta->vacuuming)) {
+        usleep(10000);
+    }
+    vs.fsm = fsm_open(meta->oid, vs.fullpath);
+    vs.vm = vm_open(meta->oid, vs.fullpath);
+    vs.strategy = GetAccessStrategy(BAS_VACUUM);
+    vs.oldest_xid = db->tx_mgr.oldest_xid;
+
+    // 表在清理期间可能继续扩展，每轮重新读取 last_page
+    for (PageID page_id = meta->first_page; page_id <= meta->last_page; page_id++) {
+        if (vacuum_cancelled(&vs)) break;
+        if (vs.vm && visibilitymap_test(vs.vm, page_id)) {
+            vs.stats.skipped_pages++;
+            continue;
+        }
+        vacuum_page(&vs, page_id);
+        vacuum_delay_point(&vs);
+    }
+    if (!vacuum_cancelled(&vs)) {
+        vacuum_truncate_heap(&vs);
+    }
+
+    pgstat_count_heap_prune(meta, vs.stats.tuples_removed);
+    if (vs.stats.scanned_pages > 0) {
+        // 跳过的页按读过的页的平均元组数估计
+        double per_page = (double)vs.stats.live_tuples / vs.stats.scanned_pages;
+        atomic_store(&meta->n_live_tup,
+                     (unsigned int)(vs.stats.live_tuples + per_page * vs.stats.skipped_pages));
+    }
+
+    FreeAccessStrategy(vs.strategy);
+    atomic_flag_clear(&meta->vacuuming);
+    if (stats) *stats = vs.stats;
+    return true;
+}
+
+int db_vacuum(MiniDB* db, const char* table_name) {
+    VacuumParams params = {
+        .cost_delay = db_config.vacuum_cost_delay,
+        .cost_limit = db_config.vacuum_cost_limit,
+        .cancel = NULL,
+    };
+
+    int first = 0, last = db->catalog.table_count - 1;
+    if (table_name) {
+        first = last = find_table(&db->catalog, table_name);
+        if (first < 0) {
+            fprintf(stderr, "Table '%s' not found\n", table_name);
+            return -1;
+        }
+    }
+
+    int nvacuumed = 0;
+    for (int i = first; i <= last; i++) {
+        TableMeta* meta = &db->catalog.tables[i];
+        VacuumStats stats;
+        if (!vacuum_table(db, meta, &params, &stats)) continue;
+        printf("[vacuum] %s: removed %d dead tuples, %d live tuples, scanned %u pages "
+               "(%u all-visible skipped), truncated %u pages\n",
+               meta->name, stats.tuples_removed, stats.live_tuples, stats.scanned_pages,
+               stats.skipped_pages, stats.truncated_pages);
+        nvacuumed++;
+    }
+    return nvacuumed;
+}
+
+// 自动清理线程状态
+static struct {
+    pthread_t threads[MAX_AUTOVACUUM_WORKERS];
+    int nworkers;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;   // 用于提前唤醒以便退出
+    bool running;
+    atomic_bool stop_requested;
+    MiniDB* db;
+    int naptime_ms;
+} autovacuum = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static bool autovacuum_needed(const TableMeta* meta) {
+    double threshold = db_config.autovacuum_vacuum_threshold +
+                       db_config.autovacuum_vacuum_scale_factor * atomic_load(&meta->n_live_tup);
+    return atomic_load(&meta->n_dead_tup) > threshold;
+}
+
+// 检查一遍所有表，各线程从不同的表开始，正在被清理的表跳过
+static void autovacuum_do_round(int worker) {
+    MiniDB* db = autovacuum.db;
+    VacuumParams params = {
+        .cost_delay = db_config.autovacuum_vacuum_cost_delay,
+        .cost_limit = db_config.autovacuum_vacuum_cost_limit,
+        .cancel = &autovacuum.stop_requested,
+    };
+    int ntables = db->catalog.table_count;
+    for (int n = 0; n < ntables && !atomic_load(&autovacuum.stop_requested); n++) {
+        TableMeta* meta = &db->catalog.tables[(worker + n) % ntables];
+        if (!autovacuum_needed(meta) || atomic_flag_test_and_set(&meta->vacuuming)) {
+            continue;
+        }
+        // vacuum_table 自己加标记，这里只是为了不和其他清理抢同一张表
+        atomic_flag_clear(&meta->vacuuming);
+
+        VacuumStats stats;
+        if (vacuum_table(db, meta, &params, &stats) &&
+            (stats.tuples_removed > 0 || stats.truncated_pages > 0)) {
+            printf("[autovacuum] %s: removed %d dead tuples, truncated %u pages\n",
+                   meta->name, stats.tuples_removed, stats.truncated_pages);
+        }
+    }
+}
+
+static void* autovacuum_main(void* arg) {
+    int worker = (int)(intptr_t)arg;
+    pthread_mutex_lock(&autovacuum.mutex);
+    while (!atomic_load(&autovacuum.stop_requested)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += autovacuum.naptime_ms / 1000;
+        deadline.tv_nsec += (long)(autovacuum.naptime_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!atomic_load(&autovacuum.stop_requested) &&
+               pthread_cond_timedwait(&autovacuum.cond, &autovacuum.mutex, &deadline) != ETIMEDOUT) {
+        }
+        if (atomic_load(&autovacuum.stop_requested)) break;
+
+        pthread_mutex_unlock(&autovacuum.mutex);
+        autovacuum_do_round(worker);
+        pthread_mutex_lock(&autovacuum.mutex);
+    }
+    pthread_mutex_unlock(&autovacuum.mutex);
+    return NULL;
+}
+
+bool autovacuum_start(MiniDB* db, int max_workers, int naptime_ms) {
+    autovacuum_stop();
+    if (max_workers < 1) max_workers = 1;
+    if (max_workers > MAX_AUTOVACUUM_WORKERS) max_workers = MAX_AUTOVACUUM_WORKERS;
+
+    pthread_mutex_lock(&autovacuum.mutex);
+    autovacuum.db = db;
+    autovacuum.naptime_ms = naptime_ms > 0 ? naptime_ms : 1;
+    atomic_store(&autovacuum.stop_requested, false);
+    autovacuum.nworkers = 0;
+    for (int i = 0; i < max_workers; i++) {
+        if (pthread_create(&autovacuum.threads[i], NULL, autovacuum_main, (void*)(intptr_t)i) != 0) {
+            perror("autovacuum: pthread_create failed");
+            break;
+        }
+        autovacuum.nworkers++;
+    }
+    autovacuum.running = autovacuum.nworkers > 0;
+    pthread_mutex_unlock(&autovacuum.mutex);
+    return autovacuum.running;
+}
+
+void autovacuum_stop() {
+    pthread_mutex_lock(&autovacuum.mutex);
+    if (!autovacuum.running) {
+        pthread_mutex_unlock(&autovacuum.mutex);
+        return;
+    }
+    atomic_store(&autovacuum.stop_requested, true);
+    pthread_cond_broadcast(&autovacuum.cond);
+    pthread_mutex_unlock(&autovacuum.mutex);
+
+    for (int i = 0; i < autovacuum.nworkers; i++) {
+        pthread_join(autovacuum.threads[i], NULL);
+    }
+    pthread_mutex_lock(&autovacuum.mutex);
+    autovacuum.running = false;
+    autovacuum.nworkers = 0;
+    pthread_mutex_unlock(&autovacuum.mutex);
+}
@@ -0,0 +1,215 @@
+#include "vm.h"
+#include "smgr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define VM_MAGIC 0x564D3031  // "VM01"
+#define MAX_VM_RELS MAX_SMGR_RELS
+#define VM_MIN_CAPACITY 512
+
+// .vm 文件头，其后是 (nblocks + 7) / 8 字节的位图
+typedef struct VMFileHeader {
+    uint32_t magic;
+    uint32_t nblocks;
+} VMFileHeader;
+
+#define VM_BYTE(page_id) ((page_id) / 8)
+#define VM_BIT(page_id) (1u << ((page_id) % 8))
+
+// 已打开的映射，registry_lock 保护
+static struct {
+    VisibilityMap* maps[MAX_VM_RELS];
+    int nmaps;
+    LWLock registry_lock;
+} vm_registry;
+
+static pthread_once_t vm_registry_once = PTHREAD_ONCE_INIT;
+
+static void vm_registry_init(void) {
+    LWLockInit(&vm_registry.registry_lock, TRANCHE_VM_LOCK);
+}
+
+// 扩大位图以容纳 page_id，调用方需以排他模式持有 vm->lock
+static bool vm_extend(VisibilityMap* vm, PageID page_id) {
+    if (page_id < vm->capacity) {
+        return true;
+    }
+    PageID capacity = vm->capacity > 0 ? vm->capacity : VM_MIN_CAPACITY;
+    while (page_id >= capacity) {
+        capacity <<= 1;
+    }
+    uint8_t* bits = realloc(vm->bits, capacity / 8);
+    if (!bits) return false;
+    memset(bits + vm->capacity / 8, 0, (capacity - vm->capacity) / 8);
+    vm->bits = bits;
+    vm->capacity = capacity;
+    return true;
+}
+
+static void vm_load_file(VisibilityMap* vm) {
+    FILE* fp = fopen(vm->path, "rb");
+    if (!fp) return;
+
+    VMFileHeader header;
+    if (fread(&header, sizeof(header), 1, fp) == 1 && header.magic == VM_MAGIC &&
+        header.nblocks > 0 && vm_extend(vm, header.nblocks - 1)) {
+        size_t nbytes = (header.nblocks + 7) / 8;
+        size_t n = fread(vm->bits, 1, nbytes, fp);
+        // 文件被截断时只信任读到的部分
+        memset(vm->bits + n, 0, vm->capacity / 8 - n);
+        vm->file_nblocks = n == nbytes ? header.nblocks : (PageID)n * 8;
+    }
+    fclose(fp);
+}
+
+static VisibilityMap* vm_create(uint32_t rel_oid, const char* table_path) {
+    VisibilityMap* vm = calloc(1, sizeof(VisibilityMap));
+    if (!vm) return NULL;
+    vm->rel_oid = rel_oid;
+    vm->fd = -1;
+    snprintf(vm->path, sizeof(vm->path), "%s%s", table_path, VM_FILE_SUFFIX);
+    LWLockInit(&vm->lock, TRANCHE_VM_LOCK);
+    vm_load_file(vm);
+    return vm;
+}
+
+VisibilityMap* vm_open(uint32_t rel_oid, const char* table_path) {
+    pthread_once(&vm_registry_once, vm_registry_init);
+
+    LWLockAcquireShared(&vm_registry.registry_lock);
+    for (int i = 0; i < vm_registry.nmaps; i++) {
+        if (vm_registry.maps[i]->rel_oid == rel_oid) {
+            VisibilityMap* vm = vm_registry.maps[i];
+            LWLockRelease(&vm_registry.registry_lock);
+            return vm;
+        }
+    }
+    LWLockRelease(&vm_registry.registry_lock);
+
+    LWLockAcquireExclusive(&vm_registry.registry_lock);
+    for (int i = 0; i < vm_registry.nmaps; i++) {
+        if (vm_registry.maps[i]->rel_oid == rel_oid) {
+            VisibilityMap* vm = vm_registry.maps[i];
+            LWLockRelease(&vm_registry.registry_lock);
+            return vm;
+        }
+    }
+    VisibilityMap* vm = NULL;
+    if (vm_registry.nmaps < MAX_VM_RELS) {
+        vm = vm_create(rel_oid, table_path);
+        if (vm) {
+            vm_registry.maps[vm_registry.nmaps++] = vm;
+        }
+    }
+    LWLockRelease(&vm_registry.registry_lock);
+    return vm;
+}
+
+bool visibilitymap_test(VisibilityMap* vm, PageID page_id) {
+    LWLockAcquireShared(&vm->lock);
+    bool all_visible = page_id < vm->capacity && (vm->bits[VM_BYTE(page_id)] & VM_BIT(page_id));
+    LWLockRelease(&vm->lock);
+    return all_visible;
+}
+
+void visibilitymap_set(VisibilityMap* vm, PageID page_id) {
+    LWLockAcquireExclusive(&vm->lock);
+    if (vm_extend(vm, page_id) && !(vm->bits[VM_BYTE(page_id)] & VM_BIT(page_id))) {
+        vm->bits[VM_BYTE(page_id)] |= VM_BIT(page_id);
+        vm->dirty = true;
+    }
+    LWLockRelease(&vm->lock);
+}
+
+void visibilitymap_clear(VisibilityMap* vm, PageID page_id) {
+    // 绝大多数修改发生在未置位的页上，先在共享锁下判断
+    if (!visibilitymap_test(vm, page_id)) {
+        return;
+    }
+
+    LWLockAcquireExclusive(&vm->lock);
+    if (page_id < vm->capacity && (vm->bits[VM_BYTE(page_id)] & VM_BIT(page_id))) {
+        vm->bits[VM_BYTE(page_id)] &= ~VM_BIT(page_id);
+        // 文件中可能记着该位，立即写入，免得修改后的数据页先落盘
+        if (page_id < vm->file_nblocks) {
+            if (vm->fd < 0) {
+                vm->fd = open(vm->path, O_WRONLY);
+            }
+            off_t off = sizeof(VMFileHeader) + VM_BYTE(page_id);
+            if (vm->fd < 0 || pwrite(vm->fd, &vm->bits[VM_BYTE(page_id)], 1, off) != 1) {
+                fprintf(stderr, "vm: could not write %s: %s\n", vm->path, strerror(errno));
+            }
+        }
+    }
+    LWLockRelease(&vm->lock);
+}
+
+void visibilitymap_truncate(VisibilityMap* vm, PageID nblocks) {
+    LWLockAcquireExclusive(&vm->lock);
+    for (PageID page_id = nblocks; page_id < vm->capacity; page_id++) {
+        if (vm->bits[VM_BYTE(page_id)] & VM_BIT(page_id)) {
+            vm->bits[VM_BYTE(page_id)] &= ~VM_BIT(page_id);
+            vm->dirty = true;
+        }
+    }
+    LWLockRelease(&vm->lock);
+}
+
+// 写回一个映射：先写临时文件再改名。全程持有排他锁，避免与清位的直接写入交错
+static void vm_sync(VisibilityMap* vm) {
+    LWLockAcquireExclusive(&vm->lock);
+    if (!vm->dirty) {
+        LWLockRelease(&vm->lock);
+        return;
+    }
+    VMFileHeader header = { .magic = VM_MAGIC, .nblocks = vm->capacity };
+    size_t nbytes = vm->capacity / 8;
+
+    char tmp_path[sizeof(vm->path) + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", vm->path);
+    FILE* fp = fopen(tmp_path, "wb");
+    bool ok = fp != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(vm->bits, 1, nbytes, fp) == nbytes;
+        ok = fclose(fp) == 0 && ok;
+    }
+    if (ok && rename(tmp_path, vm->path) == 0) {
+        vm->file_nblocks = header.nblocks;
+        vm->dirty = false;
+        // 原来的描述符指向被替换掉的旧文件，下次清位时重新打开
+        if (vm->fd >= 0) {
+            close(vm->fd);
+            vm->fd = -1;
+        }
+    } else {
+        fprintf(stderr, "vm: could not write %s: %s\n", vm->path, strerror(errno));
+        remove(tmp_path);
+    }
+    LWLockRelease(&vm->lock);
+}
+
+void vm_sync_all() {
+    pthread_once(&vm_registry_once, vm_registry_init);
+    LWLockAcquireShared(&vm_registry.registry_lock);
+    for (int i = 0; i < vm_registry.nmaps; i++) {
+        vm_sync(vm_registry.maps[i]);
+    }
+    LWLockRelease(&vm_registry.registry_lock);
+}
+
+void vm_shutdown() {
+    pthread_once(&vm_registry_once, vm_registry_init);
+    LWLockAcquireExclusive(&vm_registry.registry_lock);
+    for (int i = 0; i < vm_registry.nmaps; i++) {
+        if (vm_registry.maps[i]->fd >= 0) close(vm_registry.maps[i]->fd);
+        free(vm_registry.maps[i]->bits);
+        free(vm_registry.maps[i]);
+    }
+    vm_registry.nmaps = 0;
+    LWLockRelease(&vm_registry.registry_lock);
+}
@@ -0,0 +1,117 @@
+#include "bgwriter.h"
+#include "page.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NBUFFERS 32
+#define NPAGES 20
+#define TEST_REL 2004
+
+static char rel_path[256];
+
+// 把页面改脏，页首写入页号和轮次作为标记
+static void dirty_page(PageID page_id, uint32_t round) {
+    Buffer buf = ReadBufferNew(TEST_REL, page_id, rel_path);
+    assert(BufferIsValid(buf));
+    uint32_t marker[2] = { page_id, round };
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    memcpy(BufferGetPage(buf)->data, marker, sizeof(marker));
+    MarkBufferDirty(buf);
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+}
+
+// 重建缓冲池（不写回），从磁盘读回检查标记
+static void check_on_disk(uint32_t round) {
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    for (PageID i = 0; i < NPAGES; i++) {
+        Buffer buf = ReadBuffer(TEST_REL, i, rel_path);
+        assert(BufferIsValid(buf));
+        uint32_t marker[2];
+        memcpy(marker, BufferGetPage(buf)->data, sizeof(marker));
+        assert(marker[0] == i && marker[1] == round);
+        ReleaseBuffer(buf);
+    }
+}
+
+static uint64_t buffers_written() {
+    PageCacheStats stats;
+    page_cache_get_stats(&stats);
+    return stats.buffers_written;
+}
+
+void test_bg_buffer_sync() {
+    for (PageID i = 0; i < NPAGES; i++) {
+        dirty_page(i, 1);
+    }
+    // 每轮最多写回 max_pages 页，<= 0 表示写回全部
+    assert(BgBufferSync(5) == 5);
+    assert(buffers_written() == 5);
+    assert(BgBufferSync(0) == NPAGES - 5);
+    assert(buffers_written() == NPAGES);
+    assert(BgBufferSync(0) == 0);
+
+    // 写回不淘汰缓冲区，之后读取仍然命中
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+    Buffer buf = ReadBuffer(TEST_REL, 0, rel_path);
+    page_cache_get_stats(&after);
+    assert(after.hits == before.hits + 1);
+    ReleaseBuffer(buf);
+
+    check_on_disk(1);
+    printf("bgwriter BgBufferSync tests passed!\n");
+}
+
+void test_flush_all() {
+    for (PageID i = 0; i < NPAGES; i++) {
+        dirty_page(i, 2);
+    }
+    assert(FlushAllBuffers());
+    assert(BgBufferSync(0) == 0);
+    check_on_disk(2);
+    printf("bgwriter FlushAllBuffers tests passed!\n");
+}
+
+void test_bgwriter_thread() {
+    // max_pages <= 0 表示关闭后台写进程
+    assert(!bgwriter_start(10, 0));
+
+    assert(bgwriter_start(10, 4));
+    for (PageID i = 0; i < NPAGES; i++) {
+        dirty_page(i, 3);
+    }
+    // 等后台写进程把所有脏页写回
+    struct timespec delay = { 0, 10 * 1000 * 1000 };
+    for (int i = 0; i < 500 && buffers_written() < NPAGES; i++) {
+        nanosleep(&delay, NULL);
+    }
+    assert(buffers_written() == NPAGES);
+    bgwriter_stop();
+    bgwriter_stop();
+    check_on_disk(3);
+    printf("bgwriter thread tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/bgwriter.tbl", dir);
+    FILE* fp = fopen(rel_path, "wb");
+    assert(fp);
+    fclose(fp);
+
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    test_bg_buffer_sync();
+    test_flush_all();
+    test_bgwriter_thread();
+
+    destroy_page_cache();
+    remove(rel_path);
+    rmdir(dir);
+    printf("All bgwriter tests passed!\n");
+    return 0;
+}
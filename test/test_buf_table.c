@@ -0,0 +1,70 @@
+#include "buf_table.h"
+#include <assert.h>
+#include <stdio.h>
+
+static uint32_t tag_hash(uint32_t rel_oid, PageID page_id, BufferTag* tag) {
+    INIT_BUFFER_TAG(*tag, rel_oid, page_id);
+    return buf_table_hash_code(tag);
+}
+
+void test_insert_lookup_delete() {
+    BufTable table;
+    assert(buf_table_init(&table, 64));
+
+    // 同一页号、不同表的标签互不影响
+    BufferTag tag;
+    for (int i = 0; i < 32; i++) {
+        uint32_t hash = tag_hash(1000, i, &tag);
+        assert(buf_table_insert(&table, &tag, hash, i) == -1);
+        hash = tag_hash(1001, i, &tag);
+        assert(buf_table_insert(&table, &tag, hash, 32 + i) == -1);
+    }
+    for (int i = 0; i < 32; i++) {
+        uint32_t hash = tag_hash(1000, i, &tag);
+        assert(buf_table_lookup(&table, &tag, hash) == i);
+        hash = tag_hash(1001, i, &tag);
+        assert(buf_table_lookup(&table, &tag, hash) == 32 + i);
+    }
+
+    uint32_t hash = tag_hash(1002, 0, &tag);
+    assert(buf_table_lookup(&table, &tag, hash) == -1);
+
+    // 重复插入返回已有的 buf_id
+    hash = tag_hash(1000, 5, &tag);
+    assert(buf_table_insert(&table, &tag, hash, 63) == 5);
+    assert(buf_table_lookup(&table, &tag, hash) == 5);
+
+    assert(buf_table_delete(&table, &tag, hash));
+    assert(!buf_table_delete(&table, &tag, hash));
+    assert(buf_table_lookup(&table, &tag, hash) == -1);
+
+    // 删除的映射项可以重新使用
+    assert(buf_table_insert(&table, &tag, hash, 5) == -1);
+    assert(buf_table_lookup(&table, &tag, hash) == 5);
+
+    buf_table_destroy(&table);
+    printf("buf_table insert/lookup/delete tests passed!\n");
+}
+
+void test_bucket_count() {
+    BufTable table;
+    assert(buf_table_init(&table, 1000));
+    uint32_t nbuckets = table.bucket_mask + 1;
+    assert((nbuckets & table.bucket_mask) == 0);
+    assert(nbuckets >= 2000);
+    assert(nbuckets >= NUM_BUFFER_PARTITIONS);
+    buf_table_destroy(&table);
+
+    // 缓存页很少时桶数也不少于分区数，同一桶链上的项属于同一分区
+    assert(buf_table_init(&table, 4));
+    assert(table.bucket_mask + 1 >= NUM_BUFFER_PARTITIONS);
+    buf_table_destroy(&table);
+    printf("buf_table bucket count tests passed!\n");
+}
+
+int main() {
+    test_insert_lookup_delete();
+    test_bucket_count();
+    printf("All buf_table tests passed!\n");
+    return 0;
+}
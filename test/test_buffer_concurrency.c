@@ -0,0 +1,80 @@
+#include "page.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NBUFFERS 32
+#define NPAGES 96
+#define NTHREADS 8
+#define READS_PER_THREAD 5000
+#define TEST_REL 2005
+
+static char rel_path[256];
+
+// 多个线程并发读同一批页面（大部分不在缓冲池中），检查映射不会读错页
+static void* reader_main(void* arg) {
+    uint32_t x = (uint32_t)(uintptr_t)arg * 2654435761u + 1;
+    for (int i = 0; i < READS_PER_THREAD; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        // 一半读取集中在少数热点页上，制造同一页的并发加载
+        PageID page_id = (x & 1) ? (x >> 1) % 4 : (x >> 1) % NPAGES;
+        Buffer buf = ReadBuffer(TEST_REL, page_id, rel_path);
+        assert(BufferIsValid(buf));
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+        PageID marker;
+        memcpy(&marker, BufferGetPage(buf)->data, sizeof(marker));
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        assert(marker == page_id);
+        ReleaseBuffer(buf);
+    }
+    return NULL;
+}
+
+void test_concurrent_reads() {
+    for (PageID i = 0; i < NPAGES; i++) {
+        Buffer buf = ReadBufferNew(TEST_REL, i, rel_path);
+        assert(BufferIsValid(buf));
+        memcpy(BufferGetPage(buf)->data, &i, sizeof(i));
+        MarkBufferDirty(buf);
+        ReleaseBuffer(buf);
+    }
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+
+    pthread_t threads[NTHREADS];
+    for (int i = 0; i < NTHREADS; i++) {
+        assert(pthread_create(&threads[i], NULL, reader_main, (void*)(uintptr_t)i) == 0);
+    }
+    for (int i = 0; i < NTHREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // 每次读取要么命中要么读盘
+    page_cache_get_stats(&after);
+    assert(after.hits + after.misses - before.hits - before.misses ==
+           (uint64_t)NTHREADS * READS_PER_THREAD);
+    assert(after.misses > before.misses);
+    printf("buffer concurrent read tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/concurrency.tbl", dir);
+    FILE* fp = fopen(rel_path, "wb");
+    assert(fp);
+    fclose(fp);
+
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    test_concurrent_reads();
+
+    destroy_page_cache();
+    remove(rel_path);
+    rmdir(dir);
+    printf("All buffer concurrency tests passed!\n");
+    return 0;
+}
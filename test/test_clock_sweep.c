@@ -0,0 +1,157 @@
+#include "page.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NBUFFERS 16
+#define TEST_REL 2000
+
+static char rel_path[256];
+
+// 页首写入页号作为标记，重新读入时据此检查内容
+static void write_page(PageID page_id) {
+    Buffer buf = ReadBufferNew(TEST_REL, page_id, rel_path);
+    assert(BufferIsValid(buf));
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    Page* page = BufferGetPage(buf);
+    memcpy(page->data, &page_id, sizeof(page_id));
+    MarkBufferDirty(buf);
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+}
+
+static bool is_cached(PageID page_id) {
+    Buffer buf = ReadBufferIfCached(TEST_REL, page_id);
+    if (!BufferIsValid(buf)) return false;
+    ReleaseBuffer(buf);
+    return true;
+}
+
+static void check_page(PageID page_id) {
+    Buffer buf = ReadBuffer(TEST_REL, page_id, rel_path);
+    assert(BufferIsValid(buf));
+    PageID marker;
+    memcpy(&marker, BufferGetPage(buf)->data, sizeof(marker));
+    assert(marker == page_id);
+    ReleaseBuffer(buf);
+}
+
+void test_dirty_writeback() {
+    // 页数是缓冲池的两倍，前面的脏页必须先写回才能被淘汰
+    for (PageID i = 0; i < 2 * NBUFFERS; i++) {
+        write_page(i);
+    }
+    PageCacheStats stats;
+    page_cache_get_stats(&stats);
+    assert(stats.evictions >= NBUFFERS);
+    assert(stats.dirty_writebacks >= NBUFFERS);
+
+    // 被淘汰的页从磁盘读回，内容不变
+    for (PageID i = 0; i < 2 * NBUFFERS; i++) {
+        check_page(i);
+    }
+    printf("clock sweep dirty writeback tests passed!\n");
+}
+
+void test_hot_page_survives() {
+    // 反复访问的页使用计数达到上限，一轮顺序读不会把它淘汰
+    for (int i = 0; i < BM_MAX_USAGE_COUNT; i++) {
+        check_page(0);
+    }
+    for (PageID i = 1; i < NBUFFERS; i++) {
+        check_page(NBUFFERS + i);
+    }
+    assert(is_cached(0));
+    assert(!is_cached(1));
+
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+    check_page(0);
+    page_cache_get_stats(&after);
+    assert(after.hits == before.hits + 1);
+    assert(after.misses == before.misses);
+    printf("clock sweep usage count tests passed!\n");
+}
+
+void test_pin_counts() {
+    // 同一页多次 pin 得到同一个缓冲区，全部释放后才可淘汰
+    Buffer a = ReadBuffer(TEST_REL, 1, rel_path);
+    Buffer b = ReadBuffer(TEST_REL, 1, rel_path);
+    assert(BufferIsValid(a) && a == b);
+    ReleaseBuffer(a);
+
+    for (PageID i = 2; i < 2 * NBUFFERS; i++) {
+        check_page(i);
+    }
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+    Buffer c = ReadBuffer(TEST_REL, 1, rel_path);
+    page_cache_get_stats(&after);
+    assert(c == b);
+    assert(after.misses == before.misses);
+    ReleaseBuffer(c);
+    ReleaseBuffer(b);
+    printf("clock sweep pin count tests passed!\n");
+}
+
+void test_pinned_not_evicted() {
+    // 缓冲池全部被 pin 住时无法再读入新页，已 pin 的页保持不变
+    Buffer pinned[NBUFFERS];
+    for (PageID i = 0; i < NBUFFERS; i++) {
+        pinned[i] = ReadBuffer(TEST_REL, i, rel_path);
+        assert(BufferIsValid(pinned[i]));
+    }
+    assert(!BufferIsValid(ReadBuffer(TEST_REL, NBUFFERS, rel_path)));
+    for (PageID i = 0; i < NBUFFERS; i++) {
+        PageID marker;
+        memcpy(&marker, BufferGetPage(pinned[i])->data, sizeof(marker));
+        assert(marker == i);
+        ReleaseBuffer(pinned[i]);
+    }
+    check_page(NBUFFERS);
+    printf("clock sweep pinned buffer tests passed!\n");
+}
+
+void test_zero_mode_hit() {
+    // 截断表尾时仍被 pin 住的页留在缓冲池中，之后按新页读入同一页号时内容需重新初始化
+    write_page(3);
+    Buffer pinned = ReadBuffer(TEST_REL, 3, rel_path);
+    DropRelationBuffers(TEST_REL, 0);
+    assert(is_cached(3));
+
+    Buffer buf = ReadBufferExtended(TEST_REL, 3, rel_path, RBM_ZERO, NULL);
+    assert(buf == pinned);
+    Page* page = BufferGetPage(buf);
+    assert(page->header.page_id == 3);
+    assert(page->header.slot_count == 0);
+    PageID marker;
+    memcpy(&marker, page->data, sizeof(marker));
+    assert(marker == 0);
+    ReleaseBuffer(buf);
+    ReleaseBuffer(pinned);
+    printf("clock sweep zero mode hit tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/clock.tbl", dir);
+    FILE* fp = fopen(rel_path, "wb");
+    assert(fp);
+    fclose(fp);
+
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+
+    test_dirty_writeback();
+    test_hot_page_survives();
+    test_pin_counts();
+    test_pinned_not_evicted();
+    test_zero_mode_hit();
+
+    destroy_page_cache();
+    remove(rel_path);
+    rmdir(dir);
+    printf("All clock sweep tests passed!\n");
+    return 0;
+}
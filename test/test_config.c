@@ -0,0 +1,157 @@
+#include "config.h"
+#include "page.h"
+#include "types.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char conf_path[256];
+
+static void write_conf(const char* text) {
+    FILE* fp = fopen(conf_path, "w");
+    assert(fp);
+    fputs(text, fp);
+    fclose(fp);
+}
+
+void test_set_option() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    assert(config.shared_buffers == DEFAULT_SHARED_BUFFERS);
+    assert(config.huge_pages == HUGE_PAGES_TRY);
+
+    // 纯数字为页数，带单位时按 PAGE_SIZE 换算，过小的值提升到下限
+    assert(config_set_option(&config, "shared_buffers", "1000"));
+    assert(config.shared_buffers == 1000);
+    assert(config_set_option(&config, "shared_buffers", "1MB"));
+    assert(config.shared_buffers == 1024 * 1024 / PAGE_SIZE);
+    assert(config_set_option(&config, "shared_buffers", "1"));
+    assert(config.shared_buffers == MIN_SHARED_BUFFERS);
+    assert(!config_set_option(&config, "shared_buffers", "lots"));
+    assert(!config_set_option(&config, "shared_buffers", "10TB"));
+    assert(config.shared_buffers == MIN_SHARED_BUFFERS);
+
+    assert(config_set_option(&config, "huge_pages", "off"));
+    assert(config.huge_pages == HUGE_PAGES_OFF);
+    assert(config_set_option(&config, "huge_pages", "on"));
+    assert(config.huge_pages == HUGE_PAGES_ON);
+    assert(config_set_option(&config, "huge_pages", "try"));
+    assert(config.huge_pages == HUGE_PAGES_TRY);
+    assert(!config_set_option(&config, "huge_pages", "maybe"));
+    assert(!config_set_option(&config, "no_such_option", "1"));
+    printf("config set option tests passed!\n");
+}
+
+void test_load_file() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    remove(conf_path);
+    assert(!config_load_file(&config, conf_path));
+
+    // 注释、空行、引号和无效行都能处理，未出现的参数保持原值
+    write_conf("# buffer pool\n"
+               "\n"
+               "  shared_buffers = 256   # pages\n"
+               "huge_pages = 'off'\n"
+               "garbage line\n");
+    assert(config_load_file(&config, conf_path));
+    assert(config.shared_buffers == 256);
+    assert(config.huge_pages == HUGE_PAGES_OFF);
+    printf("config file tests passed!\n");
+}
+
+void test_buffer_pool_size() {
+    // 缓冲池按运行时参数分配，页面数组按页对齐
+    assert(init_page_cache(100, HUGE_PAGES_TRY));
+    assert(global_page_cache.nbuffers == 100);
+    assert(((uintptr_t)global_page_cache.pages % PAGE_SIZE) == 0);
+
+    assert(init_page_cache(1, HUGE_PAGES_OFF));
+    assert(global_page_cache.nbuffers == MIN_SHARED_BUFFERS);
+    assert(!global_page_cache.huge_pages);
+    destroy_page_cache();
+    printf("config buffer pool size tests passed!\n");
+}
+
+void test_bgwriter_options() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    assert(config.bgwriter_delay == DEFAULT_BGWRITER_DELAY);
+    assert(config.bgwriter_lru_maxpages == DEFAULT_BGWRITER_LRU_MAXPAGES);
+
+    assert(config_set_option(&config, "bgwriter_delay", "50"));
+    assert(config.bgwriter_delay == 50);
+    assert(config_set_option(&config, "bgwriter_delay", "2s"));
+    assert(config.bgwriter_delay == 2000);
+    assert(!config_set_option(&config, "bgwriter_delay", "5ms"));
+    assert(!config_set_option(&config, "bgwriter_delay", "1min"));
+    assert(config.bgwriter_delay == 2000);
+
+    assert(config_set_option(&config, "bgwriter_lru_maxpages", "0"));
+    assert(config.bgwriter_lru_maxpages == 0);
+    assert(!config_set_option(&config, "bgwriter_lru_maxpages", "-1"));
+    assert(!config_set_option(&config, "bgwriter_lru_maxpages", "10 pages"));
+    printf("config bgwriter option tests passed!\n");
+}
+
+void test_storage_options() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    assert(config.max_files_per_process == DEFAULT_MAX_FILES_PER_PROCESS);
+
+    assert(config_set_option(&config, "max_files_per_process", "16"));
+    assert(config.max_files_per_process == 16);
+    assert(!config_set_option(&config, "max_files_per_process", "many"));
+    assert(config.max_files_per_process == 16);
+
+    assert(!config.direct_io);
+    assert(config_set_option(&config, "direct_io", "on"));
+    assert(config.direct_io);
+    assert(config_set_option(&config, "direct_io", "false"));
+    assert(!config.direct_io);
+    assert(!config_set_option(&config, "direct_io", "sometimes"));
+
+    assert(config.io_method == IO_METHOD_IO_URING);
+    assert(config.effective_io_concurrency == DEFAULT_EFFECTIVE_IO_CONCURRENCY);
+    assert(config_set_option(&config, "io_method", "sync"));
+    assert(config.io_method == IO_METHOD_SYNC);
+    assert(config_set_option(&config, "io_method", "io_uring"));
+    assert(config.io_method == IO_METHOD_IO_URING);
+    assert(!config_set_option(&config, "io_method", "aio"));
+    assert(config_set_option(&config, "effective_io_concurrency", "0"));
+    assert(config.effective_io_concurrency == 0);
+
+    assert(!config.mmap_scans);
+    assert(config_set_option(&config, "mmap_scans", "on"));
+    assert(config.mmap_scans);
+    assert(!config_set_option(&config, "mmap_scans", "2"));
+
+    assert(config.autoprewarm);
+    assert(config.autoprewarm_interval == DEFAULT_AUTOPREWARM_INTERVAL);
+    assert(config_set_option(&config, "autoprewarm", "off"));
+    assert(!config.autoprewarm);
+    assert(config_set_option(&config, "autoprewarm_interval", "30s"));
+    assert(config.autoprewarm_interval == 30000);
+    assert(config_set_option(&config, "autoprewarm_interval", "0"));
+    assert(config.autoprewarm_interval == 0);
+    printf("config storage option tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(conf_path, sizeof(conf_path), "%s/%s", dir, CONFIG_FILE);
+
+    test_set_option();
+    test_load_file();
+    test_buffer_pool_size();
+    test_bgwriter_options();
+    test_storage_options();
+
+    remove(conf_path);
+    rmdir(dir);
+    printf("All config tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "control.h"
+#include "types.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+static char data_dir[] = "/tmp/minidb_test_XXXXXX";
+static char control_path[256];
+
+// 按指定内容写控制文件，模拟其他构建创建的数据目录
+static void write_control(uint32_t version, uint32_t blcksz, bool valid_crc) {
+    ControlFileData control = {
+        .magic = CONTROL_MAGIC,
+        .version = version,
+        .blcksz = blcksz,
+    };
+    control.crc = crc32(0, (const Bytef*)&control, offsetof(ControlFileData, crc));
+    if (!valid_crc) control.crc ^= 1;
+
+    FILE* fp = fopen(control_path, "wb");
+    assert(fp);
+    assert(fwrite(&control, sizeof(control), 1, fp) == 1);
+    fclose(fp);
+}
+
+void test_new_data_dir() {
+    remove(control_path);
+    assert(control_file_startup(data_dir));
+
+    ControlFileData control;
+    assert(control_file_read(data_dir, &control));
+    assert(control.version == CONTROL_VERSION);
+    assert(control.blcksz == PAGE_SIZE);
+
+    // 再次启动检查通过
+    assert(control_file_startup(data_dir));
+    printf("control file creation tests passed!\n");
+}
+
+void test_mismatch_rejected() {
+    uint32_t other_blcksz = PAGE_SIZE == 8192 ? 4096 : 8192;
+    write_control(CONTROL_VERSION, other_blcksz, true);
+    assert(!control_file_startup(data_dir));
+
+    // 旧版本（或更新的版本）建的数据目录同样拒绝
+    write_control(CONTROL_VERSION - 1, PAGE_SIZE, true);
+    assert(!control_file_startup(data_dir));
+    write_control(CONTROL_VERSION + 1, PAGE_SIZE, true);
+    assert(!control_file_startup(data_dir));
+
+    // 校验失败视为损坏，不能当作新数据目录覆盖
+    write_control(CONTROL_VERSION, PAGE_SIZE, false);
+    ControlFileData control;
+    assert(!control_file_read(data_dir, &control));
+    assert(!control_file_startup(data_dir));
+    assert(!control_file_read(data_dir, &control));
+
+    write_control(CONTROL_VERSION, PAGE_SIZE, true);
+    assert(control_file_startup(data_dir));
+    printf("control file mismatch tests passed!\n");
+}
+
+int main() {
+    assert(mkdtemp(data_dir));
+    snprintf(control_path, sizeof(control_path), "%s/%s", data_dir, CONTROL_FILE);
+
+    test_new_data_dir();
+    test_mismatch_rejected();
+
+    remove(control_path);
+    rmdir(data_dir);
+    printf("All control file tests passed!\n");
+    return 0;
+}
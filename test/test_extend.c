@@ -0,0 +1,168 @@
+#include "minidb.h"
+#include "lock.h"
+#include "page.h"
+#include "smgr.h"
+#include "memctx.h"
+#include "tuple.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NTHREADS 8
+#define ROWS_PER_THREAD 120
+#define TEST_REL 2011
+
+static char dir[] = "/tmp/minidb_test_XXXXXX";
+static MiniDB db;
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { 0, ms * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+void test_smgr_extend() {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/extend.tbl", dir);
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(smgr_open(TEST_REL, path));
+
+    Page page;
+    page_init(&page, 0);
+    assert(!page_is_new(&page));
+    assert(smgr_write(TEST_REL, 0, &page));
+
+    // 成批扩展出的页在磁盘上全为 0，第一次使用时才初始化
+    assert(smgr_extend(TEST_REL, 1, 10));
+    assert(smgr_nblocks(TEST_REL) == 11);
+    struct stat st;
+    assert(stat(path, &st) == 0 && st.st_size == 11 * PAGE_SIZE);
+    assert(smgr_read(TEST_REL, 10, &page));
+    assert(page_is_new(&page));
+    assert(smgr_read(TEST_REL, 0, &page));
+    assert(!page_is_new(&page));
+
+    smgr_shutdown();
+    remove(path);
+    printf("extend smgr_extend tests passed!\n");
+}
+
+static LWLock test_lock;
+
+static void* lock_waiter(void* arg) {
+    (void)arg;
+    LWLockAcquireExclusive(&test_lock);
+    LWLockRelease(&test_lock);
+    return NULL;
+}
+
+void test_waiter_count() {
+    LWLockInit(&test_lock, 0);
+    assert(LWLockWaiterCount(&test_lock) == 0);
+    LWLockAcquireExclusive(&test_lock);
+
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        assert(pthread_create(&threads[i], NULL, lock_waiter, NULL) == 0);
+    }
+    for (int i = 0; i < 1000 && LWLockWaiterCount(&test_lock) < 2; i++) {
+        sleep_ms(1);
+    }
+    assert(LWLockWaiterCount(&test_lock) == 2);
+
+    LWLockRelease(&test_lock);
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(LWLockWaiterCount(&test_lock) == 0);
+    printf("extend lock waiter count tests passed!\n");
+}
+
+static void* insert_worker(void* arg) {
+    int base = (int)(intptr_t)arg * ROWS_PER_THREAD;
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    for (int i = 0; i < ROWS_PER_THREAD; i++) {
+        Column cols[2];
+        Tuple tuple = { .col_count = 2, .columns = cols };
+        cols[0].type = INT4_TYPE;
+        cols[0].value.int_val = base + i;
+        cols[1].type = TEXT_TYPE;
+        cols[1].value.str_val = "extend_test_row_padding_padding";
+        assert(db_insert(&db, "t", &tuple, session));
+    }
+    session_commit_transaction(&db, &session);
+    return NULL;
+}
+
+// 查询全表，返回行数并检查 id 恰好覆盖 [0, expected)
+static int check_rows(int expected) {
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    int count = 0;
+    Tuple** rows = db_query(&db, "t", &count, session);
+    char* seen = calloc(expected, 1);
+    for (int i = 0; i < count; i++) {
+        int id = rows[i]->columns[0].value.int_val;
+        assert(id >= 0 && id < expected && !seen[id]);
+        seen[id] = 1;
+        free_tuple(rows[i]);
+    }
+    free(seen);
+    pfree(rows);
+    session_commit_transaction(&db, &session);
+    return count;
+}
+
+void test_concurrent_insert() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    config.autoprewarm = false;
+    init_db_with_config(&db, dir, &config);
+
+    ColumnDef cols[] = { { "id", INT4_TYPE }, { "name", TEXT_TYPE } };
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    assert(db_create_table(&db, "t", cols, 2, session) >= 0);
+    session_commit_transaction(&db, &session);
+
+    // 多个线程同时扩展同一张表，预分配的页被等待者用上，行不丢也不重复
+    pthread_t threads[NTHREADS];
+    for (int i = 0; i < NTHREADS; i++) {
+        assert(pthread_create(&threads[i], NULL, insert_worker, (void*)(intptr_t)i) == 0);
+    }
+    for (int i = 0; i < NTHREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(check_rows(NTHREADS * ROWS_PER_THREAD) == NTHREADS * ROWS_PER_THREAD);
+    PageID last_page = db.catalog.tables[find_table(&db.catalog, "t")].last_page;
+    assert(last_page > 0);
+
+    // 扩展后的表尾已写入元数据，重启后扫描仍能看到所有页
+    close_db(&db);
+    init_db_with_config(&db, dir, &config);
+    assert(db.catalog.tables[find_table(&db.catalog, "t")].last_page == last_page);
+    assert(check_rows(NTHREADS * ROWS_PER_THREAD) == NTHREADS * ROWS_PER_THREAD);
+    close_db(&db);
+    printf("extend concurrent insert tests passed!\n");
+}
+
+int main() {
+    assert(mkdtemp(dir));
+    assert(chdir(dir) == 0);  // WAL 文件写在当前目录下
+
+    test_smgr_extend();
+    test_waiter_count();
+    test_concurrent_insert();
+
+    assert(chdir("/") == 0);
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    assert(system(cmd) == 0);
+    printf("All extend tests passed!\n");
+    return 0;
+}
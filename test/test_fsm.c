@@ -0,0 +1,92 @@
+#include "fsm.h"
+#include "smgr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_REL 2001
+#define NPAGES 200
+
+static char rel_path[256];
+
+// 内部节点等于两个子节点的最大值
+static void check_max_tree(const FreeSpaceMap* fsm) {
+    for (int i = 1; i < fsm->nleaves; i++) {
+        uint8_t left = fsm->tree[2 * i], right = fsm->tree[2 * i + 1];
+        assert(fsm->tree[i] == (left > right ? left : right));
+    }
+}
+
+void test_record_and_search() {
+    FreeSpaceMap* fsm = fsm_open(TEST_REL, rel_path);
+    assert(fsm != NULL);
+    assert(GetPageWithFreeSpace(fsm, 1) == INVALID_PAGE_ID);
+
+    // 只有页 150 有大块空闲空间，超过初始叶子数时映射自动扩大
+    for (PageID i = 0; i < NPAGES; i++) {
+        RecordPageWithFreeSpace(fsm, i, 2 * FSM_CAT_STEP);
+    }
+    RecordPageWithFreeSpace(fsm, 150, PAGE_SIZE / 2);
+    assert(fsm->nleaves >= NPAGES);
+    check_max_tree(fsm);
+
+    assert(GetPageWithFreeSpace(fsm, FSM_CAT_STEP) == 0);
+    assert(GetPageWithFreeSpace(fsm, PAGE_SIZE / 4) == 150);
+    assert(GetPageWithFreeSpace(fsm, PAGE_SIZE / 2 + FSM_CAT_STEP) == INVALID_PAGE_ID);
+
+    // 空间被用掉后向上更新，找到下一个满足条件的页
+    RecordPageWithFreeSpace(fsm, 150, 0);
+    RecordPageWithFreeSpace(fsm, 180, PAGE_SIZE / 3);
+    check_max_tree(fsm);
+    assert(GetPageWithFreeSpace(fsm, PAGE_SIZE / 4) == 180);
+
+    // 映射过时：记下实际空间并另找一页
+    assert(RecordAndGetPageWithFreeSpace(fsm, 180, 0, PAGE_SIZE / 4) == INVALID_PAGE_ID);
+    RecordPageWithFreeSpace(fsm, 0, 0);
+    assert(GetPageWithFreeSpace(fsm, FSM_CAT_STEP) == 1);
+    check_max_tree(fsm);
+    printf("fsm record/search tests passed!\n");
+}
+
+void test_truncate_and_reload() {
+    FreeSpaceMap* fsm = fsm_open(TEST_REL, rel_path);
+    RecordPageWithFreeSpace(fsm, 120, PAGE_SIZE / 2);
+    FreeSpaceMapTruncateRel(fsm, 100);
+    assert(GetPageWithFreeSpace(fsm, PAGE_SIZE / 4) == INVALID_PAGE_ID);
+    check_max_tree(fsm);
+
+    // 写回后重新加载，档位保持不变
+    RecordPageWithFreeSpace(fsm, 42, PAGE_SIZE / 2);
+    fsm_sync_all();
+    fsm_shutdown();
+    fsm = fsm_open(TEST_REL, rel_path);
+    assert(fsm != NULL);
+    assert(fsm->nblocks == 100);
+    assert(GetPageWithFreeSpace(fsm, PAGE_SIZE / 4) == 42);
+    assert(GetPageWithFreeSpace(fsm, FSM_CAT_STEP) == 1);
+    check_max_tree(fsm);
+    printf("fsm truncate/reload tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/fsm.tbl", dir);
+
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(smgr_open(TEST_REL, rel_path));
+
+    test_record_and_search();
+    test_truncate_and_reload();
+
+    fsm_shutdown();
+    smgr_shutdown();
+    char fsm_path[sizeof(rel_path) + sizeof(FSM_FILE_SUFFIX)];
+    snprintf(fsm_path, sizeof(fsm_path), "%s%s", rel_path, FSM_FILE_SUFFIX);
+    remove(fsm_path);
+    remove(rel_path);
+    rmdir(dir);
+    printf("All fsm tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include "minidb.h"
+#include "page.h"
+#include "memctx.h"
+#include "tuple.h"
+#include "server/executor.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char dir[] = "/tmp/minidb_test_XXXXXX";
+static MiniDB db;
+
+static void open_db() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    config.autoprewarm = false;
+    init_db_with_config(&db, dir, &config);
+}
+
+static Session begin() {
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    return session;
+}
+
+static TableMeta* make_table(const char* name) {
+    ColumnDef cols[] = { { "id", INT4_TYPE }, { "name", TEXT_TYPE } };
+    Session session = begin();
+    assert(db_create_table(&db, name, cols, 2, session) >= 0);
+    session_commit_transaction(&db, &session);
+    return &db.catalog.tables[find_table(&db.catalog, name)];
+}
+
+static void make_row(Tuple* tuple, Column* cols, int id, const char* name) {
+    memset(tuple, 0, sizeof(*tuple));
+    tuple->col_count = 2;
+    tuple->columns = cols;
+    cols[0].type = INT4_TYPE;
+    cols[0].value.int_val = id;
+    cols[1].type = TEXT_TYPE;
+    cols[1].value.str_val = (char*)name;
+}
+
+static ItemPointer insert_row(TableMeta* meta, int id, const char* name, Session session) {
+    Tuple tuple;
+    Column cols[2];
+    make_row(&tuple, cols, id, name);
+    tuple.oid = ++meta->max_row_oid;
+    tuple.xmin = session.current_xid;
+    ItemPointer tid;
+    assert(db_heap_insert(&db, meta, &tuple, NULL, &tid));
+    return tid;
+}
+
+static HeapUpdateResult update_row(TableMeta* meta, ItemPointer* tid, int id, const char* name,
+                                   Session session) {
+    Tuple tuple;
+    Column cols[2];
+    make_row(&tuple, cols, id, name);
+    // 新版本沿用旧版本的行 OID
+    Tuple* old = db_heap_fetch(&db, meta, *tid);
+    tuple.oid = old ? old->oid : 0;
+    free_tuple(old);
+    return db_heap_update(&db, meta, tid, &tuple, session);
+}
+
+static uint8_t infomask_at(TableMeta* meta, ItemPointer tid, ItemPointer* ctid) {
+    Tuple* t = db_heap_fetch(&db, meta, tid);
+    assert(t != NULL);
+    uint8_t infomask = t->infomask;
+    if (ctid) *ctid = t->ctid;
+    free_tuple(t);
+    return infomask;
+}
+
+// 查询全表，返回可见行数，并检查 id 为 id 的行的 name
+static int query(const char* table, int id, const char* name) {
+    Session session = begin();
+    int count = 0;
+    Tuple** rows = db_query(&db, table, &count, session);
+    bool found = false;
+    for (int i = 0; i < count; i++) {
+        if (rows[i]->columns[0].value.int_val == id) {
+            assert(!found);
+            found = true;
+            assert(strcmp(rows[i]->columns[1].value.str_val, name) == 0);
+        }
+        free_tuple(rows[i]);
+    }
+    pfree(rows);
+    session_commit_transaction(&db, &session);
+    assert(found);
+    return count;
+}
+
+void test_hot_update() {
+    TableMeta* meta = make_table("hot");
+    Session session = begin();
+    ItemPointer tid = insert_row(meta, 1, "before", session);
+    insert_row(meta, 2, "other", session);
+    session_commit_transaction(&db, &session);
+
+    // 本页放得下新版本：HOT 更新，新版本在同一页且只能经更新链到达
+    session = begin();
+    ItemPointer otid = tid;
+    assert(update_row(meta, &otid, 1, "after!", session) == HEAP_UPDATE_OK);
+    ItemPointer ctid;
+    uint8_t infomask = infomask_at(meta, tid, &ctid);
+    assert(infomask & TUPLE_UPDATED);
+    assert(infomask & TUPLE_HOT_UPDATED);
+    assert(ctid.page_id == tid.page_id && ctid.slot != tid.slot);
+    assert(infomask_at(meta, ctid, NULL) & TUPLE_HEAP_ONLY);
+
+    // 同一事务再更新旧版本返回 SELF
+    otid = tid;
+    assert(update_row(meta, &otid, 1, "again", session) == HEAP_UPDATE_SELF);
+    session_commit_transaction(&db, &session);
+
+    assert(query("hot", 1, "after!") == 2);
+    printf("heap HOT update tests passed!\n");
+}
+
+void test_cold_update() {
+    TableMeta* meta = make_table("cold");
+    Session session = begin();
+    ItemPointer tid = insert_row(meta, 1, "row", session);
+    // 填满第 0 页
+    int id = 2;
+    for (;;) {
+        ItemPointer t = insert_row(meta, id++, "filler filler filler filler", session);
+        if (t.page_id != tid.page_id) break;
+    }
+    session_commit_transaction(&db, &session);
+
+    // 本页放不下：新版本放到其他页，旧版本仍经 ctid 链到新版本
+    char name[200];
+    memset(name, 'z', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    session = begin();
+    ItemPointer otid = tid;
+    assert(update_row(meta, &otid, 1, name, session) == HEAP_UPDATE_OK);
+    session_commit_transaction(&db, &session);
+
+    ItemPointer ctid;
+    uint8_t infomask = infomask_at(meta, tid, &ctid);
+    assert(infomask & TUPLE_UPDATED);
+    assert(!(infomask & TUPLE_HOT_UPDATED));
+    assert(ctid.page_id != tid.page_id);
+    assert(!(infomask_at(meta, ctid, NULL) & TUPLE_HEAP_ONLY));
+    assert(query("cold", 1, name) == id - 1);
+    printf("heap cold update tests passed!\n");
+}
+
+void test_update_conflict() {
+    TableMeta* meta = make_table("conflict");
+    Session session = begin();
+    ItemPointer tid = insert_row(meta, 1, "v1", session);
+    session_commit_transaction(&db, &session);
+
+    // 进行中的事务更新过的版本不能再更新
+    Session a = begin();
+    Session b = begin();
+    ItemPointer otid = tid;
+    assert(update_row(meta, &otid, 1, "v2", a) == HEAP_UPDATE_OK);
+    otid = tid;
+    assert(update_row(meta, &otid, 1, "v3", b) == HEAP_UPDATE_BEING_UPDATED);
+
+    // 更新者提交后返回新版本的位置，沿链在新版本上重试
+    session_commit_transaction(&db, &a);
+    otid = tid;
+    assert(update_row(meta, &otid, 1, "v3", b) == HEAP_UPDATE_UPDATED);
+    ItemPointer ctid;
+    infomask_at(meta, tid, &ctid);
+    assert(otid.page_id == ctid.page_id && otid.slot == ctid.slot);
+    assert(update_row(meta, &otid, 1, "v3", b) == HEAP_UPDATE_OK);
+    session_commit_transaction(&db, &b);
+    assert(query("conflict", 1, "v3") == 1);
+    printf("heap update conflict tests passed!\n");
+}
+
+// 插入行直到第 0 页放不下，返回第 0 页剩余空间
+static size_t fill_first_page(TableMeta* meta, ItemPointer* tids, int* count) {
+    Session session = begin();
+    *count = 0;
+    for (;;) {
+        ItemPointer t = insert_row(meta, *count, "fillfactor row", session);
+        if (t.page_id != 0) break;
+        tids[(*count)++] = t;
+    }
+    session_commit_transaction(&db, &session);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", db.data_dir, meta->filename);
+    Buffer buf = ReadBuffer(meta->oid, 0, path);
+    assert(BufferIsValid(buf));
+    size_t free_space = page_free_space(BufferGetPage(buf));
+    ReleaseBuffer(buf);
+    return free_space;
+}
+
+void test_fillfactor() {
+    TableMeta* meta = make_table("ff");
+    assert(meta->fillfactor == HEAP_DEFAULT_FILLFACTOR);
+    assert(!db_set_fillfactor(&db, "ff", HEAP_MIN_FILLFACTOR - 1));
+    assert(!db_set_fillfactor(&db, "ff", 101));
+    assert(!db_set_fillfactor(&db, "no_such_table", 50));
+    assert(db_set_fillfactor(&db, "ff", 50));
+
+    // 插入只把页面填到一半，留下的空间给 HOT 更新
+    static ItemPointer tids[PAGE_SIZE];
+    int count;
+    size_t free_space = fill_first_page(meta, tids, &count);
+    assert(free_space >= PAGE_SIZE * 4 / 10);
+
+    Session session = begin();
+    for (int i = 0; i < count; i++) {
+        ItemPointer otid = tids[i];
+        assert(update_row(meta, &otid, i, "fillfactor new", session) == HEAP_UPDATE_OK);
+        assert(infomask_at(meta, tids[i], NULL) & TUPLE_HOT_UPDATED);
+    }
+    session_commit_transaction(&db, &session);
+
+    // fillfactor 保存在表元数据中，重启后仍有效
+    close_db(&db);
+    open_db();
+    meta = &db.catalog.tables[find_table(&db.catalog, "ff")];
+    assert(meta->fillfactor == 50);
+    printf("heap fillfactor tests passed!\n");
+}
+
+void test_set_column_value() {
+    // TEXT 列按原长度分配，赋更长的值时换成新副本
+    Column col = { .type = TEXT_TYPE };
+    col.value.str_val = pstrdup("ab");
+    set_column_value(&col, "a much longer value");
+    assert(strcmp(col.value.str_val, "a much longer value") == 0);
+    set_column_value(&col, "");
+    assert(col.value.str_val[0] == '\0');
+    pfree(col.value.str_val);
+
+    Column num = { .type = INT4_TYPE };
+    set_column_value(&num, "42");
+    assert(num.value.int_val == 42);
+    printf("set_column_value tests passed!\n");
+}
+
+int main() {
+    assert(mkdtemp(dir));
+    assert(chdir(dir) == 0);  // WAL 文件写在当前目录下
+    open_db();
+
+    test_hot_update();
+    test_cold_update();
+    test_update_conflict();
+    test_fillfactor();
+    test_set_column_value();
+
+    close_db(&db);
+    assert(chdir("/") == 0);
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    assert(system(cmd) == 0);
+    printf("All heap update tests passed!\n");
+    return 0;
+}
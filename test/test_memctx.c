@@ -0,0 +1,111 @@
+#include "memctx.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+void test_alloc() {
+    MemoryContext ctx = MemoryContextCreate(NULL, "test");
+    assert(ctx != NULL);
+    size_t initial = MemoryContextMemAllocated(ctx);
+
+    // 分配互不重叠且按 16 字节对齐，超过首块后申请新块
+    char* prev = NULL;
+    for (int i = 0; i < 1000; i++) {
+        char* p = MemoryContextAlloc(ctx, 100);
+        assert(p != NULL);
+        assert(((uintptr_t)p & 15) == 0);
+        memset(p, i & 0xff, 100);
+        if (prev) assert(prev[99] == (char)((i - 1) & 0xff));
+        prev = p;
+    }
+    assert(MemoryContextMemAllocated(ctx) > initial);
+
+    // 大分配单独一块
+    char* big = MemoryContextAlloc(ctx, 100000);
+    assert(big != NULL);
+    memset(big, 1, 100000);
+
+    MemoryContext old = MemoryContextSwitchTo(ctx);
+    char* s = pstrdup("hello");
+    assert(strcmp(s, "hello") == 0);
+    int* zero = palloc0(64 * sizeof(int));
+    for (int i = 0; i < 64; i++) assert(zero[i] == 0);
+    pfree(s);  // 上下文中的分配等重置时回收
+    MemoryContextSwitchTo(old);
+
+    MemoryContextDelete(ctx);
+    printf("memctx alloc tests passed!\n");
+}
+
+void test_reset() {
+    MemoryContext ctx = MemoryContextCreate(NULL, "reset");
+    size_t initial = MemoryContextMemAllocated(ctx);
+    char* first = MemoryContextAlloc(ctx, 32);
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 500; i++) {
+            assert(MemoryContextAlloc(ctx, 200) != NULL);
+        }
+        MemoryContextAlloc(ctx, 50000);
+        assert(MemoryContextMemAllocated(ctx) > initial);
+
+        // 重置只保留首块，之后从头重新分配
+        MemoryContextReset(ctx);
+        assert(MemoryContextMemAllocated(ctx) == initial);
+        assert(MemoryContextAlloc(ctx, 32) == first);
+    }
+    MemoryContextDelete(ctx);
+    printf("memctx reset tests passed!\n");
+}
+
+void test_children() {
+    MemoryContext parent = MemoryContextCreate(NULL, "parent");
+    MemoryContext child = MemoryContextCreate(parent, "child");
+    MemoryContext grandchild = MemoryContextCreate(child, "grandchild");
+    MemoryContext sibling = MemoryContextCreate(parent, "sibling");
+    size_t block = MemoryContextMemAllocated(sibling);
+    assert(MemoryContextMemAllocated(parent) == 4 * block);
+
+    MemoryContextAlloc(grandchild, 100000);
+    assert(MemoryContextMemAllocated(parent) > 4 * block);
+
+    // 删除子上下文时从父上下文摘下，兄弟不受影响
+    MemoryContextDelete(child);
+    assert(MemoryContextMemAllocated(parent) == 2 * block);
+    assert(MemoryContextAlloc(sibling, 10) != NULL);
+
+    // 删除当前上下文时切换回其父上下文
+    MemoryContext old = MemoryContextSwitchTo(sibling);
+    MemoryContextDelete(sibling);
+    assert(CurrentMemoryContext == parent);
+    MemoryContextSwitchTo(old);
+
+    // 重置删除所有子上下文
+    MemoryContextCreate(parent, "a");
+    MemoryContextCreate(parent, "b");
+    assert(MemoryContextMemAllocated(parent) == 3 * block);
+    MemoryContextReset(parent);
+    assert(MemoryContextMemAllocated(parent) == block);
+    MemoryContextDelete(parent);
+    printf("memctx child context tests passed!\n");
+}
+
+void test_no_context() {
+    // 没有当前上下文时 palloc 用 malloc，pfree 立即释放
+    assert(CurrentMemoryContext == NULL);
+    char* s = pstrdup("malloc");
+    assert(strcmp(s, "malloc") == 0);
+    pfree(s);
+    pfree(NULL);
+    printf("memctx malloc fallback tests passed!\n");
+}
+
+int main() {
+    test_alloc();
+    test_reset();
+    test_children();
+    test_no_context();
+    printf("All memctx tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "page.h"
+#include "tuple.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void make_tuple(Tuple* tuple, Column* cols, uint32_t oid, const char* text) {
+    memset(tuple, 0, sizeof(*tuple));
+    tuple->oid = oid;
+    tuple->col_count = 2;
+    tuple->columns = cols;
+    cols[0].type = INT4_TYPE;
+    cols[0].value.int_val = (int32_t)oid * 10;
+    cols[1].type = TEXT_TYPE;
+    cols[1].value.str_val = (char*)text;
+}
+
+static void check_tuple(const Page* page, uint16_t slot, uint32_t oid, const char* text) {
+    Tuple* t = page_get_tuple(page, slot, NULL);
+    assert(t != NULL);
+    assert(t->oid == oid);
+    assert(t->columns[0].value.int_val == (int32_t)oid * 10);
+    assert(strcmp(t->columns[1].value.str_val, text) == 0);
+    free_tuple(t);
+}
+
+// 槽位数组与元组数据之间的空隙就是空闲空间
+static void check_layout(const Page* page) {
+    assert(page->header.free_start == page->header.slot_count * sizeof(Slot));
+    assert(page->header.free_start <= page->header.free_end);
+    assert(page->header.free_end <= sizeof(page->data));
+    assert(page_free_space(page) == (size_t)(page->header.free_end - page->header.free_start));
+}
+
+static int fill_page(Page* page, const char* text) {
+    Tuple tuple;
+    Column cols[2];
+    int n = 0;
+    uint16_t slot;
+    for (;;) {
+        make_tuple(&tuple, cols, n + 1, text);
+        if (!page_insert_tuple(page, &tuple, &slot)) break;
+        assert(slot == n);
+        n++;
+    }
+    check_layout(page);
+    return n;
+}
+
+void test_small_tuples() {
+    Page page;
+    page_init(&page, 7);
+    assert(page_free_space(&page) == PAGE_EMPTY_FREE_SPACE);
+    assert(!page_is_new(&page));
+    check_layout(&page);
+
+    // 每页元组数只受元组大小限制，不再有固定的 64 个槽位
+    int n = fill_page(&page, "x");
+    assert(n > 64);
+    assert(page.header.tuple_count == n);
+    for (int i = 0; i < n; i++) {
+        check_tuple(&page, i, i + 1, "x");
+    }
+    printf("page small tuple tests passed!\n");
+}
+
+void test_delete_and_compact() {
+    Page page;
+    page_init(&page, 0);
+    int n = fill_page(&page, "some text that takes room");
+
+    // 删除不立即回收空间，插入时整理页面，槽位号保持不变
+    size_t before = page_free_space(&page);
+    for (int i = 0; i < n; i += 2) {
+        assert(page_delete_tuple(&page, i));
+    }
+    assert(!page_delete_tuple(&page, 0));
+    assert(page_get_tuple(&page, 0, NULL) == NULL);
+    assert(page_free_space(&page) == before);
+
+    Tuple tuple;
+    Column cols[2];
+    uint16_t slot;
+    make_tuple(&tuple, cols, 1000, "some text that takes room");
+    assert(page_insert_tuple(&page, &tuple, &slot));
+    assert(slot == n);
+    check_layout(&page);
+    for (int i = 1; i < n; i += 2) {
+        check_tuple(&page, i, i + 1, "some text that takes room");
+    }
+    check_tuple(&page, slot, 1000, "some text that takes room");
+    printf("page delete/compact tests passed!\n");
+}
+
+void test_update() {
+    Page page;
+    page_init(&page, 0);
+    int n = fill_page(&page, "medium sized text");
+
+    // 变短的更新原地覆盖
+    Tuple tuple;
+    Column cols[2];
+    make_tuple(&tuple, cols, 3, "short");
+    assert(page_update_tuple(&page, 2, &tuple));
+    check_tuple(&page, 2, 3, "short");
+
+    // 页面放不下更长的新版本时更新失败，旧版本保持不变
+    char long_text[PAGE_SIZE / 4];
+    memset(long_text, 'y', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    make_tuple(&tuple, cols, 4, long_text);
+    assert(!page_update_tuple(&page, 3, &tuple));
+    check_tuple(&page, 3, 4, "medium sized text");
+    assert(page.header.tuple_count == n);
+    check_layout(&page);
+    printf("page update tests passed!\n");
+}
+
+int main() {
+    test_small_tuples();
+    test_delete_and_compact();
+    test_update();
+    printf("All page tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "prewarm.h"
+#include "page.h"
+#include "smgr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NBUFFERS 32
+#define NPAGES 20
+#define REL_A 2009
+#define REL_B 2010
+
+static char dir[] = "/tmp/minidb_test_XXXXXX";
+static char path_a[256];
+static char path_b[256];
+static char dump_path[256];
+
+static void write_pages(uint32_t rel_oid, PageID npages) {
+    Page page;
+    for (PageID i = 0; i < npages; i++) {
+        page_init(&page, i);
+        assert(smgr_write(rel_oid, i, &page));
+    }
+}
+
+static void read_page_into_cache(uint32_t rel_oid, PageID page_id) {
+    Buffer buf = ReadBuffer(rel_oid, page_id, NULL);
+    assert(BufferIsValid(buf));
+    ReleaseBuffer(buf);
+}
+
+static bool is_cached(uint32_t rel_oid, PageID page_id) {
+    Buffer buf = ReadBufferIfCached(rel_oid, page_id);
+    if (!BufferIsValid(buf)) return false;
+    ReleaseBuffer(buf);
+    return true;
+}
+
+static int cached_count(void) {
+    BufferTag tags[NBUFFERS];
+    return page_cache_get_resident_tags(tags, NBUFFERS);
+}
+
+void test_dump_and_load() {
+    // 没有转储文件时不预热
+    assert(autoprewarm_load(dir) == 0);
+
+    for (PageID i = 0; i < NPAGES; i += 2) {
+        read_page_into_cache(REL_A, i);
+    }
+    read_page_into_cache(REL_B, 3);
+    assert(autoprewarm_dump(dir) == NPAGES / 2 + 1);
+
+    // 重启后按转储读回同样的页面
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(cached_count() == 0);
+    assert(autoprewarm_load(dir) == NPAGES / 2 + 1);
+    for (PageID i = 0; i < NPAGES; i++) {
+        assert(is_cached(REL_A, i) == (i % 2 == 0));
+    }
+    assert(is_cached(REL_B, 3));
+    printf("prewarm dump/load tests passed!\n");
+}
+
+void test_skip_missing() {
+    // 已删除的表、文件末尾之后的页跳过
+    FILE* fp = fopen(dump_path, "w");
+    assert(fp);
+    fprintf(fp, "<<4>>\n1,a.tbl\n%u,a.tbl\n4,%s\n0,dropped.tbl\n", NPAGES + 5, path_b);
+    fclose(fp);
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(autoprewarm_load(dir) == 2);
+    assert(is_cached(REL_A, 1));
+    assert(is_cached(REL_B, 4));
+    assert(cached_count() == 2);
+    printf("prewarm skip missing pages tests passed!\n");
+}
+
+void test_oid_reassigned() {
+    // 重启后表 OID 按目录顺序重新分配：按文件名找回页面所属的表
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    read_page_into_cache(REL_A, 2);
+    read_page_into_cache(REL_B, 5);
+    assert(autoprewarm_dump(dir) == 2);
+
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(smgr_open(REL_B, path_a));
+    assert(smgr_open(REL_A, path_b));
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(autoprewarm_load(dir) == 2);
+    assert(is_cached(REL_B, 2));
+    assert(is_cached(REL_A, 5));
+    assert(cached_count() == 2);
+
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(smgr_open(REL_A, path_a));
+    assert(smgr_open(REL_B, path_b));
+    printf("prewarm reassigned OID tests passed!\n");
+}
+
+void test_no_eviction() {
+    // 转储的页数多于缓冲池时装满空闲缓冲区即停止，不淘汰页面
+    assert(init_page_cache(NBUFFERS * 2, HUGE_PAGES_OFF));
+    for (PageID i = 0; i < NPAGES; i++) {
+        read_page_into_cache(REL_A, i);
+        read_page_into_cache(REL_B, i);
+    }
+    assert(autoprewarm_dump(dir) == 2 * NPAGES);
+
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    read_page_into_cache(REL_B, NPAGES - 1);
+    assert(autoprewarm_load(dir) == NBUFFERS - 1);
+    PageCacheStats stats;
+    page_cache_get_stats(&stats);
+    assert(stats.evictions == 0);
+    assert(is_cached(REL_B, NPAGES - 1));
+    printf("prewarm no eviction tests passed!\n");
+}
+
+void test_worker() {
+    // 预热线程停止时转储一次
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    remove(dump_path);
+    assert(autoprewarm_start(dir, 0));
+    read_page_into_cache(REL_A, 7);
+    autoprewarm_stop();
+
+    FILE* fp = fopen(dump_path, "r");
+    assert(fp);
+    int count;
+    PageID page_id;
+    char name[64];
+    assert(fscanf(fp, "<<%d>>\n%u,%63s\n", &count, &page_id, name) == 3);
+    fclose(fp);
+    assert(count == 1 && page_id == 7 && strcmp(name, "a.tbl") == 0);
+
+    // 线程停止后仍可直接装入
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(autoprewarm_load(dir) == 1);
+    assert(is_cached(REL_A, 7));
+    printf("prewarm worker tests passed!\n");
+}
+
+int main() {
+    assert(mkdtemp(dir));
+    snprintf(path_a, sizeof(path_a), "%s/a.tbl", dir);
+    snprintf(path_b, sizeof(path_b), "%s/b.tbl", dir);
+    snprintf(dump_path, sizeof(dump_path), "%s/%s", dir, AUTOPREWARM_FILE);
+
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(smgr_open(REL_A, path_a));
+    assert(smgr_open(REL_B, path_b));
+    write_pages(REL_A, NPAGES);
+    write_pages(REL_B, NPAGES);
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+
+    test_dump_and_load();
+    test_skip_missing();
+    test_oid_reassigned();
+    test_no_eviction();
+    test_worker();
+
+    destroy_page_cache();
+    smgr_shutdown();
+    remove(dump_path);
+    remove(path_a);
+    remove(path_b);
+    rmdir(dir);
+    printf("All prewarm tests passed!\n");
+    return 0;
+}
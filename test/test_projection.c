@@ -0,0 +1,224 @@
+#include "minidb.h"
+#include "memctx.h"
+#include "page.h"
+#include "tuple.h"
+#include "server/parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NROWS 50
+#define BODY_LEN 20000
+
+static char dir[] = "/tmp/minidb_test_XXXXXX";
+static MiniDB db;
+static char big_body[BODY_LEN + 1];
+
+static Session begin() {
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    return session;
+}
+
+// t(id INT4, name TEXT, body TEXT, score INT4)，偶数行的 body 大到需要压缩
+static void load_table() {
+    ColumnDef defs[] = {
+        { "id", INT4_TYPE }, { "name", TEXT_TYPE }, { "body", TEXT_TYPE }, { "score", INT4_TYPE }
+    };
+    Session session = begin();
+    assert(db_create_table(&db, "t", defs, 4, session) >= 0);
+    for (int i = 0; i < NROWS; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "name%d", i);
+        Column cols[4];
+        Tuple tuple = { .col_count = 4, .columns = cols };
+        cols[0].type = INT4_TYPE;
+        cols[0].value.int_val = i;
+        cols[1].type = TEXT_TYPE;
+        cols[1].value.str_val = name;
+        cols[2].type = TEXT_TYPE;
+        cols[2].value.str_val = i % 2 == 0 ? big_body : "short";
+        cols[3].type = INT4_TYPE;
+        cols[3].value.int_val = i % 5;
+        assert(db_insert(&db, "t", &tuple, session));
+    }
+    session_commit_transaction(&db, &session);
+}
+
+static Tuple** query(const bool* needed, const Condition* qual, int* count) {
+    Session session = begin();
+    Tuple** rows = db_query_attrs(&db, "t", count, session, needed, qual);
+    session_commit_transaction(&db, &session);
+    return rows;
+}
+
+static void free_rows(Tuple** rows, int count) {
+    for (int i = 0; i < count; i++) free_tuple(rows[i]);
+    pfree(rows);
+}
+
+void test_all_columns() {
+    int count;
+    Tuple** rows = query(NULL, NULL, &count);
+    assert(count == NROWS);
+    for (int i = 0; i < count; i++) {
+        Tuple* t = rows[i];
+        int id = t->columns[0].value.int_val;
+        assert(t->col_count == 4);
+        char name[32];
+        snprintf(name, sizeof(name), "name%d", id);
+        assert(strcmp(t->columns[1].value.str_val, name) == 0);
+        assert(strcmp(t->columns[2].value.str_val, id % 2 == 0 ? big_body : "short") == 0);
+        assert(t->columns[3].value.int_val == id % 5);
+    }
+    free_rows(rows, count);
+    printf("projection all columns tests passed!\n");
+}
+
+void test_projection() {
+    int count;
+    // 只取第一列：之后的列都不解析
+    bool id_only[4] = { true, false, false, false };
+    Tuple** rows = query(id_only, NULL, &count);
+    assert(count == NROWS);
+    bool seen[NROWS] = { false };
+    for (int i = 0; i < count; i++) {
+        assert(rows[i]->col_count == 1);
+        int id = rows[i]->columns[0].value.int_val;
+        assert(id >= 0 && id < NROWS && !seen[id]);
+        seen[id] = true;
+    }
+    free_rows(rows, count);
+
+    // 解析到最后一个需要的列，中间不需要的 TEXT 列不复制
+    bool id_score[4] = { true, false, false, true };
+    rows = query(id_score, NULL, &count);
+    assert(count == NROWS);
+    for (int i = 0; i < count; i++) {
+        Tuple* t = rows[i];
+        assert(t->col_count == 4);
+        assert(t->columns[1].value.str_val == NULL);
+        assert(t->columns[2].value.str_val == NULL);
+        assert(t->columns[3].value.int_val == t->columns[0].value.int_val % 5);
+    }
+    free_rows(rows, count);
+
+    bool body[4] = { false, false, true, false };
+    rows = query(body, NULL, &count);
+    assert(count == NROWS);
+    for (int i = 0; i < count; i++) {
+        Tuple* t = rows[i];
+        assert(t->col_count == 3);
+        assert(t->columns[1].value.str_val == NULL);
+        bool big = t->columns[0].value.int_val % 2 == 0;
+        assert(strcmp(t->columns[2].value.str_val, big ? big_body : "short") == 0);
+    }
+    free_rows(rows, count);
+    printf("projection deform tests passed!\n");
+}
+
+void test_qual() {
+    Condition qual = { .op = "=" };
+    int count;
+
+    // WHERE 列不在输出中：行照样过滤，该列不解析
+    bool id_only[4] = { true, false, false, false };
+    strcpy(qual.column, "score");
+    strcpy(qual.value, "3");
+    Tuple** rows = query(id_only, &qual, &count);
+    assert(count == NROWS / 5);
+    for (int i = 0; i < count; i++) {
+        assert(rows[i]->col_count == 1);
+        assert(rows[i]->columns[0].value.int_val % 5 == 3);
+    }
+    free_rows(rows, count);
+
+    bool body[4] = { false, false, true, false };
+    strcpy(qual.column, "name");
+    strcpy(qual.value, "name8");
+    rows = query(body, &qual, &count);
+    assert(count == 1);
+    assert(rows[0]->columns[0].value.int_val == 8);
+    assert(rows[0]->columns[1].value.str_val == NULL);
+    assert(strcmp(rows[0]->columns[2].value.str_val, big_body) == 0);
+    free_rows(rows, count);
+
+    // 没有满足条件的行、表不存在
+    strcpy(qual.value, "nobody");
+    rows = query(NULL, &qual, &count);
+    assert(count == 0);
+    free_rows(rows, count);
+    Session session = begin();
+    assert(db_query_attrs(&db, "no_such_table", &count, session, NULL, NULL) == NULL);
+    assert(count == 0);
+    session_commit_transaction(&db, &session);
+    printf("projection qual tests passed!\n");
+}
+
+void test_mmap_scan() {
+    // 表的脏页先写回，再经映射读取
+    db_config.mmap_scans = true;
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+    int count;
+    Tuple** rows = query(NULL, NULL, &count);
+    assert(count == NROWS);
+    free_rows(rows, count);
+    page_cache_get_stats(&after);
+    assert(after.buffers_written > before.buffers_written);
+
+    // 缓冲池中没有的页直接读映射
+    TableMeta* meta = &db.catalog.tables[find_table(&db.catalog, "t")];
+    DropRelationBuffers(meta->oid, meta->first_page);
+    rows = query(NULL, NULL, &count);
+    assert(count == NROWS);
+    free_rows(rows, count);
+
+    // 新插入的行还只在缓冲池中，映射扫描同样能看到
+    Session session = begin();
+    Column cols[4];
+    Tuple tuple = { .col_count = 4, .columns = cols };
+    cols[0].type = INT4_TYPE;
+    cols[0].value.int_val = NROWS;
+    cols[1].type = TEXT_TYPE;
+    cols[1].value.str_val = "extra";
+    cols[2].type = TEXT_TYPE;
+    cols[2].value.str_val = "short";
+    cols[3].type = INT4_TYPE;
+    cols[3].value.int_val = 0;
+    assert(db_insert(&db, "t", &tuple, session));
+    session_commit_transaction(&db, &session);
+    rows = query(NULL, NULL, &count);
+    assert(count == NROWS + 1);
+    free_rows(rows, count);
+    db_config.mmap_scans = false;
+    printf("projection mmap scan tests passed!\n");
+}
+
+int main() {
+    for (int i = 0; i < BODY_LEN; i++) big_body[i] = 'a' + (i / 7) % 26;
+    big_body[BODY_LEN] = '\0';
+
+    assert(mkdtemp(dir));
+    assert(chdir(dir) == 0);  // WAL 文件写在当前目录下
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    config.autoprewarm = false;
+    init_db_with_config(&db, dir, &config);
+    load_table();
+
+    test_all_columns();
+    test_projection();
+    test_qual();
+    test_mmap_scan();
+
+    close_db(&db);
+    assert(chdir("/") == 0);
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    assert(system(cmd) == 0);
+    printf("All projection tests passed!\n");
+    return 0;
+}
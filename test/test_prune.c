@@ -0,0 +1,214 @@
+#include "minidb.h"
+#include "page.h"
+#include "prune.h"
+#include "tuple.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char dir[] = "/tmp/minidb_test_XXXXXX";
+static MiniDB db;
+
+static void open_db() {
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    config.autoprewarm = false;
+    init_db_with_config(&db, dir, &config);
+}
+
+static Session begin() {
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    return session;
+}
+
+static TableMeta* make_table(const char* name) {
+    ColumnDef cols[] = { { "id", INT4_TYPE }, { "name", TEXT_TYPE } };
+    Session session = begin();
+    assert(db_create_table(&db, name, cols, 2, session) >= 0);
+    session_commit_transaction(&db, &session);
+    return &db.catalog.tables[find_table(&db.catalog, name)];
+}
+
+static void make_row(Tuple* tuple, Column* cols, uint32_t oid, const char* name) {
+    memset(tuple, 0, sizeof(*tuple));
+    tuple->oid = oid;
+    tuple->col_count = 2;
+    tuple->columns = cols;
+    cols[0].type = INT4_TYPE;
+    cols[0].value.int_val = (int)oid;
+    cols[1].type = TEXT_TYPE;
+    cols[1].value.str_val = (char*)name;
+}
+
+// 插入一行并提交，返回其位置，行 OID 写入 oid
+static ItemPointer insert_row(TableMeta* meta, const char* name, uint32_t* oid) {
+    Session session = begin();
+    Tuple tuple;
+    Column cols[2];
+    make_row(&tuple, cols, ++meta->max_row_oid, name);
+    tuple.xmin = session.current_xid;
+    ItemPointer tid;
+    assert(db_heap_insert(&db, meta, &tuple, NULL, &tid));
+    session_commit_transaction(&db, &session);
+    *oid = tuple.oid;
+    return tid;
+}
+
+// 在 session 中更新 tid 处的行，成功时 tid 改为新版本的位置
+static HeapUpdateResult update_row(TableMeta* meta, ItemPointer* tid, uint32_t oid,
+                                   const char* name, Session session) {
+    Tuple tuple;
+    Column cols[2];
+    make_row(&tuple, cols, oid, name);
+    ItemPointer otid = *tid;
+    HeapUpdateResult result = db_heap_update(&db, meta, &otid, &tuple, session);
+    if (result == HEAP_UPDATE_OK) {
+        Tuple* old = db_heap_fetch(&db, meta, *tid);
+        assert(old && (old->infomask & TUPLE_HOT_UPDATED));
+        *tid = old->ctid;
+        free_tuple(old);
+    } else {
+        *tid = otid;
+    }
+    return result;
+}
+
+static void update_committed(TableMeta* meta, ItemPointer* tid, uint32_t oid, const char* name) {
+    Session session = begin();
+    assert(update_row(meta, tid, oid, name, session) == HEAP_UPDATE_OK);
+    session_commit_transaction(&db, &session);
+}
+
+// 对第 0 页做一次剪枝，返回回收的槽位数；slot_count/free_space 可为 NULL
+static int prune_first_page(TableMeta* meta, uint16_t* slot_count, size_t* free_space) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", db.data_dir, meta->filename);
+    Buffer buf = ReadBuffer(meta->oid, 0, path);
+    assert(BufferIsValid(buf));
+    Page* page = BufferGetPage(buf);
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    PruneResult result;
+    int n = heap_page_prune(page, &db.tx_mgr, db.tx_mgr.oldest_xid, &result);
+    assert(result.nlive == page->header.tuple_count);
+    if (n > 0) MarkBufferDirty(buf);
+    if (slot_count) *slot_count = page->header.slot_count;
+    if (free_space) *free_space = page_free_space(page);
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    ReleaseBuffer(buf);
+    return n;
+}
+
+static void check_row(TableMeta* meta, ItemPointer tid, uint32_t oid, const char* name) {
+    Tuple* t = db_heap_fetch(&db, meta, tid);
+    assert(t != NULL);
+    assert(t->oid == oid);
+    assert(t->xmax == 0);
+    assert(strcmp(t->columns[1].value.str_val, name) == 0);
+    free_tuple(t);
+}
+
+void test_prune_dead_versions() {
+    TableMeta* meta = make_table("prune");
+    uint32_t oid1, oid2;
+    ItemPointer first = insert_row(meta, "v0", &oid1);
+    ItemPointer other = insert_row(meta, "other", &oid2);
+
+    ItemPointer tid = first;
+    char name[16];
+    for (int i = 1; i <= 5; i++) {
+        snprintf(name, sizeof(name), "v%d", i);
+        update_committed(meta, &tid, oid1, name);
+    }
+    uint16_t before;
+    size_t free_before;
+    assert(prune_first_page(meta, &before, &free_before) == 5);
+
+    // 旧版本全部回收，存活元组的槽位号不变
+    check_row(meta, tid, oid1, "v5");
+    check_row(meta, other, oid2, "other");
+    assert(db_heap_fetch(&db, meta, first) == NULL);
+    assert(prune_first_page(meta, NULL, NULL) == 0);
+
+    // 回收的槽位供之后的版本重用
+    uint16_t latest_slot = tid.slot;
+    update_committed(meta, &tid, oid1, "v6");
+    assert(tid.page_id == 0 && tid.slot < latest_slot);
+    check_row(meta, tid, oid1, "v6");
+    printf("heap prune dead version tests passed!\n");
+}
+
+void test_prune_keeps_visible() {
+    TableMeta* meta = make_table("keep");
+    uint32_t oid;
+    ItemPointer first = insert_row(meta, "old", &oid);
+
+    // 更早开始的事务仍可能看到旧版本，不能回收
+    Session reader = begin();
+    ItemPointer tid = first;
+    update_committed(meta, &tid, oid, "new");
+    assert(prune_first_page(meta, NULL, NULL) == 0);
+    Tuple* t = db_heap_fetch(&db, meta, first);
+    assert(t && strcmp(t->columns[1].value.str_val, "old") == 0);
+    free_tuple(t);
+
+    session_commit_transaction(&db, &reader);
+    assert(prune_first_page(meta, NULL, NULL) == 1);
+    assert(db_heap_fetch(&db, meta, first) == NULL);
+    check_row(meta, tid, oid, "new");
+    printf("heap prune visibility tests passed!\n");
+}
+
+void test_prune_on_update() {
+    TableMeta* meta = make_table("churn");
+    uint32_t oid;
+    ItemPointer first = insert_row(meta, "start", &oid);
+
+    // 反复更新同一行：页面快满时更新前先剪枝，新版本一直留在第 0 页做 HOT 更新
+    char name[128];
+    memset(name, 'x', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    ItemPointer tid = first;
+    for (int i = 0; i < 500; i++) {
+        name[0] = 'a' + i % 26;
+        update_committed(meta, &tid, oid, name);
+        assert(tid.page_id == 0);
+    }
+    check_row(meta, tid, oid, name);
+    assert(meta->last_page == meta->first_page);
+
+    // 记下的旧位置已被剪枝回收：返回 PRUNED，按 OID 重新定位后重试
+    assert(prune_first_page(meta, NULL, NULL) > 0);
+    Session session = begin();
+    ItemPointer stale = first;
+    assert(update_row(meta, &stale, oid, "final", session) == HEAP_UPDATE_PRUNED);
+    ItemPointer latest;
+    Tuple* t = db_heap_fetch_latest(&db, meta, oid, &latest);
+    assert(t != NULL);
+    assert(latest.page_id == tid.page_id && latest.slot == tid.slot);
+    free_tuple(t);
+    assert(update_row(meta, &latest, oid, "final", session) == HEAP_UPDATE_OK);
+    session_commit_transaction(&db, &session);
+    check_row(meta, latest, oid, "final");
+    printf("heap prune on update tests passed!\n");
+}
+
+int main() {
+    assert(mkdtemp(dir));
+    assert(chdir(dir) == 0);  // WAL 文件写在当前目录下
+    open_db();
+
+    test_prune_dead_versions();
+    test_prune_keeps_visible();
+    test_prune_on_update();
+
+    close_db(&db);
+    assert(chdir("/") == 0);
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    assert(system(cmd) == 0);
+    printf("All heap prune tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "page.h"
+#include "smgr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NBUFFERS 64
+#define NPAGES 40
+#define TEST_REL 2006
+
+static char rel_path[256];
+
+static void write_pages() {
+    Page page;
+    for (PageID i = 0; i < NPAGES; i++) {
+        page_init(&page, i);
+        memcpy(page.data, &i, sizeof(i));
+        assert(smgr_write(TEST_REL, i, &page));
+    }
+}
+
+// 顺序扫描 [first, last]，检查按页序返回且内容正确，返回取到的有效页数
+static int scan(PageID first, PageID last, int max_distance) {
+    ReadStream stream;
+    read_stream_begin(&stream, TEST_REL, rel_path, first, last, max_distance, NULL);
+    Buffer buf;
+    PageID page_id;
+    PageID expected = first;
+    int nvalid = 0;
+    while (read_stream_next(&stream, &buf, &page_id)) {
+        assert(page_id == expected++);
+        if (page_id >= NPAGES) {
+            // 超出文件末尾的页不存在
+            assert(!BufferIsValid(buf));
+            continue;
+        }
+        assert(BufferIsValid(buf));
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+        PageID marker;
+        memcpy(&marker, BufferGetPage(buf)->data, sizeof(marker));
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        assert(marker == page_id);
+        ReleaseBuffer(buf);
+        nvalid++;
+    }
+    assert(expected == last + 1);
+    read_stream_end(&stream);
+    return nvalid;
+}
+
+// 同时 pin 住整个缓冲池，检查之前的扫描没有遗留 pin
+static void check_no_pins() {
+    Buffer pinned[NBUFFERS];
+    for (int i = 0; i < NBUFFERS; i++) {
+        pinned[i] = ReadBufferNew(TEST_REL, 1000 + i, rel_path);
+        assert(BufferIsValid(pinned[i]));
+    }
+    for (int i = 0; i < NBUFFERS; i++) {
+        ReleaseBuffer(pinned[i]);
+    }
+}
+
+void test_sequential_scan(IOMethod io_method) {
+    smgr_init(16, false, io_method);
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(smgr_open(TEST_REL, rel_path));
+    write_pages();
+
+    // 冷扫描每页读盘一次，再次扫描全部命中
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+    assert(scan(0, NPAGES - 1, 8) == NPAGES);
+    page_cache_get_stats(&after);
+    assert(after.misses - before.misses == NPAGES);
+    assert(scan(0, NPAGES - 1, 8) == NPAGES);
+    page_cache_get_stats(&before);
+    assert(before.misses == after.misses);
+
+    // 部分范围、不预读、越过文件末尾、空范围
+    assert(scan(5, 9, 0) == 5);
+    assert(scan(NPAGES - 3, NPAGES + 2, 4) == 3);
+    assert(scan(7, 6, 4) == 0);
+
+    destroy_page_cache();
+    smgr_shutdown();
+    printf("read stream %s scan tests passed!\n",
+           io_method == IO_METHOD_SYNC ? "sync" : "io_uring");
+}
+
+void test_end_early() {
+    smgr_init(16, false, IO_METHOD_IO_URING);
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(smgr_open(TEST_REL, rel_path));
+
+    // 提前结束时释放已预读但未取出的缓冲区
+    ReadStream stream;
+    read_stream_begin(&stream, TEST_REL, rel_path, 0, NPAGES - 1, 16, NULL);
+    Buffer buf;
+    for (int i = 0; i < 3; i++) {
+        assert(read_stream_next(&stream, &buf, NULL));
+        ReleaseBuffer(buf);
+    }
+    read_stream_end(&stream);
+    check_no_pins();
+
+    destroy_page_cache();
+    smgr_shutdown();
+    printf("read stream early end tests passed!\n");
+}
+
+void test_buffers_exhausted() {
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(smgr_open(TEST_REL, rel_path));
+
+    // 整个缓冲池被 pin 住且没有人释放：扫描等待超时后放弃这些页，而不是一直等
+    Buffer pinned[NBUFFERS];
+    for (int i = 0; i < NBUFFERS; i++) {
+        pinned[i] = ReadBufferNew(TEST_REL, 1000 + i, rel_path);
+        assert(BufferIsValid(pinned[i]));
+    }
+    ReadStream stream;
+    read_stream_begin(&stream, TEST_REL, rel_path, 0, 1, 8, NULL);
+    Buffer buf;
+    PageID page_id;
+    for (PageID expected = 0; expected <= 1; expected++) {
+        assert(read_stream_next(&stream, &buf, &page_id));
+        assert(page_id == expected);
+        assert(!BufferIsValid(buf));
+    }
+    assert(!read_stream_next(&stream, &buf, &page_id));
+    read_stream_end(&stream);
+
+    // 释放之后照常读取
+    for (int i = 0; i < NBUFFERS; i++) {
+        ReleaseBuffer(pinned[i]);
+    }
+    assert(scan(0, NPAGES - 1, 8) == NPAGES);
+
+    destroy_page_cache();
+    smgr_shutdown();
+    printf("read stream exhausted pool tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/stream.tbl", dir);
+
+    test_sequential_scan(IO_METHOD_SYNC);
+    remove(rel_path);
+    test_sequential_scan(IO_METHOD_IO_URING);
+    test_end_early();
+    test_buffers_exhausted();
+
+    remove(rel_path);
+    rmdir(dir);
+    printf("All read stream tests passed!\n");
+    return 0;
+}
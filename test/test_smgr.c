@@ -0,0 +1,178 @@
+#include "smgr.h"
+#include <assert.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NRELS 8
+#define MAX_OPEN 4
+#define FIRST_REL 3000
+
+static char dir[] = "/tmp/minidb_test_XXXXXX";
+static char rel_paths[NRELS][256];
+
+// 统计本进程打开的、位于测试目录下的文件数
+static int count_open_files() {
+    DIR* fds = opendir("/proc/self/fd");
+    assert(fds);
+    int count = 0;
+    struct dirent* ent;
+    while ((ent = readdir(fds)) != NULL) {
+        char link[64], target[PATH_MAX];
+        snprintf(link, sizeof(link), "/proc/self/fd/%s", ent->d_name);
+        ssize_t n = readlink(link, target, sizeof(target) - 1);
+        if (n <= 0) continue;
+        target[n] = '\0';
+        if (strncmp(target, dir, strlen(dir)) == 0) count++;
+    }
+    closedir(fds);
+    return count;
+}
+
+static void fill_page(Page* page, uint32_t rel_oid, PageID page_id) {
+    memset(page, 0, sizeof(*page));
+    page->header.page_id = page_id;
+    memcpy(page->data, &rel_oid, sizeof(rel_oid));
+}
+
+static void check_page(uint32_t rel_oid, PageID page_id) {
+    Page page;
+    assert(smgr_read(rel_oid, page_id, &page));
+    uint32_t marker;
+    memcpy(&marker, page.data, sizeof(marker));
+    assert(marker == rel_oid);
+    assert(page.header.page_id == page_id);
+}
+
+void test_read_write() {
+    Page page;
+    for (int i = 0; i < NRELS; i++) {
+        assert(smgr_open(FIRST_REL + i, rel_paths[i]));
+    }
+    // 超出文件末尾的写自动扩展文件
+    for (int i = 0; i < NRELS; i++) {
+        fill_page(&page, FIRST_REL + i, 2);
+        assert(smgr_write(FIRST_REL + i, 2, &page));
+        assert(smgr_nblocks(FIRST_REL + i) == 3);
+    }
+    for (int i = NRELS - 1; i >= 0; i--) {
+        check_page(FIRST_REL + i, 2);
+        assert(!smgr_read(FIRST_REL + i, 3, &page));
+    }
+    assert(!smgr_read(FIRST_REL + NRELS, 0, &page));
+    printf("smgr read/write tests passed!\n");
+}
+
+void test_fd_cache() {
+    // 访问的表多于描述符上限时按 LRU 关闭，打开的文件数不超过上限
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < NRELS; i++) {
+            check_page(FIRST_REL + i, 2);
+            assert(count_open_files() <= MAX_OPEN);
+        }
+    }
+    smgr_close(FIRST_REL);
+    check_page(FIRST_REL, 2);
+
+    // 关闭后不再占用描述符，登记保留
+    smgr_shutdown();
+    assert(count_open_files() == 0);
+    Page page;
+    assert(!smgr_read(FIRST_REL, 2, &page));
+    assert(smgr_open(FIRST_REL, rel_paths[0]));
+    check_page(FIRST_REL, 2);
+    printf("smgr fd cache tests passed!\n");
+}
+
+void test_direct_io() {
+    // O_DIRECT 模式下对齐与不对齐的页面都能读写（文件系统不支持时退回普通 I/O）
+    smgr_init(MAX_OPEN, true, IO_METHOD_SYNC);
+    assert(smgr_open(FIRST_REL, rel_paths[0]));
+    check_page(FIRST_REL, 2);
+
+    static _Alignas(PAGE_SIZE) uint8_t aligned[PAGE_SIZE];
+    uint8_t* unaligned_buf = malloc(PAGE_SIZE + 1);
+    Page* pages[2] = { (Page*)aligned, (Page*)(unaligned_buf + 1) };
+    for (int i = 0; i < 2; i++) {
+        fill_page(pages[i], FIRST_REL, 3 + i);
+        assert(smgr_write(FIRST_REL, 3 + i, pages[i]));
+    }
+    for (int i = 0; i < 2; i++) {
+        memset(pages[i], 0, sizeof(Page));
+        assert(smgr_read(FIRST_REL, 3 + i, pages[i]));
+        assert(pages[i]->header.page_id == (PageID)(3 + i));
+    }
+    free(unaligned_buf);
+
+    // 磁盘页恰好 PAGE_SIZE 字节，文件大小是页大小的整数倍
+    struct stat st;
+    assert(stat(rel_paths[0], &st) == 0);
+    assert(st.st_size == 5 * PAGE_SIZE);
+    assert(smgr_nblocks(FIRST_REL) == 5);
+    smgr_shutdown();
+    printf("smgr direct I/O tests passed!\n");
+}
+
+void test_map() {
+    smgr_init(MAX_OPEN, false, IO_METHOD_SYNC);
+    assert(smgr_open(FIRST_REL, rel_paths[0]));
+    assert(smgr_open(FIRST_REL + 1, rel_paths[NRELS - 1]));
+    remove(rel_paths[NRELS - 1]);
+    assert(smgr_map(FIRST_REL + 1) == NULL);  // 空文件不映射
+
+    // 映射内容与 pread 读到的一致，同样大小的文件复用缓存的映射
+    SMgrMap* map = smgr_map(FIRST_REL);
+    assert(map != NULL && map->nblocks == 5);
+    assert(smgr_map(FIRST_REL) == map);
+    smgr_unmap(map);
+    assert(smgr_map_page(map, 5) == NULL);
+    assert(smgr_map_page(map, 2)->header.page_id == 2);
+    uint32_t marker;
+    memcpy(&marker, smgr_map_page(map, 2)->data, sizeof(marker));
+    assert(marker == FIRST_REL);
+
+    // pwrite 写入对共享映射可见
+    Page page;
+    fill_page(&page, FIRST_REL + 100, 2);
+    assert(smgr_write(FIRST_REL, 2, &page));
+    memcpy(&marker, smgr_map_page(map, 2)->data, sizeof(marker));
+    assert(marker == FIRST_REL + 100);
+
+    // 文件扩展后建立新映射，旧映射在释放前仍然可用
+    fill_page(&page, FIRST_REL, 5);
+    assert(smgr_write(FIRST_REL, 5, &page));
+    SMgrMap* extended = smgr_map(FIRST_REL);
+    assert(extended != map && extended->nblocks == 6);
+    assert(smgr_map_page(extended, 5)->header.page_id == 5);
+    assert(smgr_map_page(map, 4)->header.page_id == 4);
+    smgr_unmap(map);
+    smgr_unmap(extended);
+    smgr_shutdown();
+    printf("smgr mmap tests passed!\n");
+}
+
+int main() {
+    assert(mkdtemp(dir));
+    for (int i = 0; i < NRELS; i++) {
+        snprintf(rel_paths[i], sizeof(rel_paths[i]), "%s/rel%d.tbl", dir, i);
+    }
+
+    smgr_init(MAX_OPEN, false, IO_METHOD_SYNC);
+    test_read_write();
+    test_fd_cache();
+    test_direct_io();
+    test_map();
+
+    smgr_shutdown();
+    for (int i = 0; i < NRELS; i++) {
+        remove(rel_paths[i]);
+    }
+    rmdir(dir);
+    printf("All smgr tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "page.h"
+#include "smgr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NBUFFERS 64
+#define HOT_PAGES 8
+#define SCAN_PAGES 1000
+#define HOT_REL 2007
+#define SCAN_REL 2008
+
+static char hot_path[256];
+static char scan_path[256];
+
+static void write_pages(uint32_t rel_oid, PageID npages) {
+    Page page;
+    for (PageID i = 0; i < npages; i++) {
+        page_init(&page, i);
+        memcpy(page.data, &i, sizeof(i));
+        assert(smgr_write(rel_oid, i, &page));
+    }
+}
+
+static void check_buffer(Buffer buf, PageID page_id) {
+    assert(BufferIsValid(buf));
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    PageID marker;
+    memcpy(&marker, BufferGetPage(buf)->data, sizeof(marker));
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    assert(marker == page_id);
+}
+
+// 反复访问热点页，使其使用计数升到上限
+static void warm_hot_pages() {
+    for (int round = 0; round < BM_MAX_USAGE_COUNT; round++) {
+        for (PageID i = 0; i < HOT_PAGES; i++) {
+            Buffer buf = ReadBuffer(HOT_REL, i, hot_path);
+            check_buffer(buf, i);
+            ReleaseBuffer(buf);
+        }
+    }
+}
+
+// 重新读一遍热点页，返回其中读盘的页数
+static uint64_t hot_page_misses() {
+    PageCacheStats before, after;
+    page_cache_get_stats(&before);
+    for (PageID i = 0; i < HOT_PAGES; i++) {
+        Buffer buf = ReadBuffer(HOT_REL, i, hot_path);
+        check_buffer(buf, i);
+        ReleaseBuffer(buf);
+    }
+    page_cache_get_stats(&after);
+    return after.misses - before.misses;
+}
+
+static void scan_with(BufferAccessStrategy strategy) {
+    for (PageID i = 0; i < SCAN_PAGES; i++) {
+        Buffer buf = ReadBufferExtended(SCAN_REL, i, scan_path, RBM_NORMAL, strategy);
+        check_buffer(buf, i);
+        ReleaseBuffer(buf);
+    }
+}
+
+void test_scan_strategy() {
+    assert(GetScanAccessStrategy(NBUFFERS / 8) == NULL);
+    BufferAccessStrategy strategy = GetScanAccessStrategy(SCAN_PAGES);
+    assert(strategy != NULL && strategy->type == BAS_BULKREAD);
+    assert(strategy->nbuffers <= NBUFFERS / 8);
+
+    // 大表扫描只在环中循环，不会挤掉热点页
+    warm_hot_pages();
+    scan_with(strategy);
+    assert(hot_page_misses() == 0);
+
+    ReadStream stream;
+    read_stream_begin(&stream, SCAN_REL, scan_path, 0, SCAN_PAGES - 1, 16, strategy);
+    Buffer buf;
+    PageID page_id;
+    while (read_stream_next(&stream, &buf, &page_id)) {
+        check_buffer(buf, page_id);
+        ReleaseBuffer(buf);
+    }
+    read_stream_end(&stream);
+    assert(hot_page_misses() == 0);
+    FreeAccessStrategy(strategy);
+
+    // 不用策略时同样的扫描会把热点页淘汰
+    scan_with(NULL);
+    assert(hot_page_misses() > 0);
+    printf("strategy bulk read tests passed!\n");
+}
+
+void test_bulk_write() {
+    BufferAccessStrategy strategy = GetAccessStrategy(BAS_BULKWRITE);
+    assert(strategy->nbuffers <= NBUFFERS / 8);
+
+    // 批量写入复用环中的脏页前先写回，热点页不受影响
+    warm_hot_pages();
+    for (PageID i = 0; i < SCAN_PAGES; i++) {
+        Buffer buf = ReadBufferExtended(SCAN_REL, SCAN_PAGES + i, scan_path, RBM_ZERO, strategy);
+        assert(BufferIsValid(buf));
+        PageID marker = SCAN_PAGES + i;
+        LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+        memcpy(BufferGetPage(buf)->data, &marker, sizeof(marker));
+        MarkBufferDirty(buf);
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+        ReleaseBuffer(buf);
+    }
+    FreeAccessStrategy(strategy);
+    assert(hot_page_misses() == 0);
+
+    assert(FlushAllBuffers());
+    assert(smgr_nblocks(SCAN_REL) == 2 * SCAN_PAGES);
+    Page page;
+    for (PageID i = SCAN_PAGES; i < 2 * SCAN_PAGES; i++) {
+        assert(smgr_read(SCAN_REL, i, &page));
+        PageID marker;
+        memcpy(&marker, page.data, sizeof(marker));
+        assert(marker == i);
+    }
+    printf("strategy bulk write tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(hot_path, sizeof(hot_path), "%s/hot.tbl", dir);
+    snprintf(scan_path, sizeof(scan_path), "%s/scan.tbl", dir);
+
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(init_page_cache(NBUFFERS, HUGE_PAGES_OFF));
+    assert(smgr_open(HOT_REL, hot_path));
+    assert(smgr_open(SCAN_REL, scan_path));
+    write_pages(HOT_REL, HOT_PAGES);
+    write_pages(SCAN_REL, SCAN_PAGES);
+
+    test_scan_strategy();
+    test_bulk_write();
+
+    destroy_page_cache();
+    smgr_shutdown();
+    remove(hot_path);
+    remove(scan_path);
+    rmdir(dir);
+    printf("All strategy tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "toast.h"
+#include "tuple.h"
+#include "smgr.h"
+#include "memctx.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define TEST_REL 2003
+
+static char rel_path[256];
+static char toast_path[sizeof(rel_path) + sizeof(TOAST_FILE_SUFFIX)];
+
+// 有规律的字符串压缩率高，伪随机的压缩后仍放不进行内
+static char* make_text(size_t len, bool random) {
+    char* s = malloc(len + 1);
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < len; i++) {
+        if (random) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            s[i] = '!' + x % 90;
+        } else {
+            s[i] = 'a' + (i / 7) % 26;
+        }
+    }
+    s[len] = '\0';
+    return s;
+}
+
+static off_t toast_file_size() {
+    struct stat st;
+    return stat(toast_path, &st) == 0 ? st.st_size : 0;
+}
+
+static void init_tuple(Tuple* tuple, Column* cols, const char* short_text, char* compressible,
+                       char* incompressible) {
+    memset(tuple, 0, sizeof(*tuple));
+    tuple->oid = 7;
+    tuple->col_count = 4;
+    tuple->columns = cols;
+    cols[0].type = INT4_TYPE;
+    cols[0].value.int_val = 42;
+    cols[1].type = TEXT_TYPE;
+    cols[1].value.str_val = (char*)short_text;
+    cols[2].type = TEXT_TYPE;
+    cols[2].value.str_val = compressible;
+    cols[3].type = TEXT_TYPE;
+    cols[3].value.str_val = incompressible;
+}
+
+// 反序列化后与原值逐列比较
+static void check_round_trip(const uint8_t* data, size_t len, const Tuple* orig) {
+    TupleView view;
+    assert(tuple_view_init(&view, data, (uint16_t)len, TEST_REL));
+    Tuple* t = tuple_view_materialize(&view, NULL);
+    assert(t != NULL);
+    assert(t->col_count == orig->col_count);
+    assert(t->columns[0].value.int_val == orig->columns[0].value.int_val);
+    for (int i = 1; i < orig->col_count; i++) {
+        assert(strcmp(t->columns[i].value.str_val, orig->columns[i].value.str_val) == 0);
+    }
+    free_tuple(t);
+
+    // 只取部分列时不需要的大字段不读
+    bool needed[4] = { true, true, false, false };
+    t = tuple_view_materialize(&view, needed);
+    assert(t->col_count == 2);
+    assert(strcmp(t->columns[1].value.str_val, orig->columns[1].value.str_val) == 0);
+    free_tuple(t);
+}
+
+void test_small_tuple_inline() {
+    Tuple tuple;
+    Column cols[4];
+    init_tuple(&tuple, cols, "short", "also short", "tiny");
+
+    uint8_t buffer[MAX_TUPLE_SIZE];
+    size_t len = heap_toast_serialize(TEST_REL, &tuple, buffer);
+    assert(len == tuple_serialized_size(&tuple));
+    assert(toast_file_size() == 0);
+
+    TupleView view;
+    assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+    size_t text_len;
+    const char* text = tuple_view_get_text(&view, 1, &text_len);
+    assert(text && text_len == 5 && memcmp(text, "short", 5) == 0);
+    check_round_trip(buffer, len, &tuple);
+    printf("toast inline tests passed!\n");
+}
+
+void test_compress_and_external() {
+    char* compressible = make_text(50000, false);
+    char* incompressible = make_text(20000, true);
+    Tuple tuple;
+    Column cols[4];
+    init_tuple(&tuple, cols, "short", compressible, incompressible);
+
+    uint8_t buffer[MAX_TUPLE_SIZE];
+    size_t len = heap_toast_serialize(TEST_REL, &tuple, buffer);
+    assert(len > 0 && len <= TOAST_TUPLE_TARGET);
+
+    // 压缩后仍放不下的值移到 .toast 文件（存压缩数据）
+    assert(toast_file_size() > 0);
+    assert(toast_file_size() < 20000);
+
+    TupleView view;
+    assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+    size_t text_len;
+    assert(tuple_view_get_text(&view, 2, &text_len) == NULL);
+    assert(tuple_view_get_text(&view, 3, &text_len) == NULL);
+    char* copy = tuple_view_copy_text(&view, 2);
+    assert(strcmp(copy, compressible) == 0);
+    pfree(copy);
+    check_round_trip(buffer, len, &tuple);
+
+    // 重新打开 .toast 文件后外部值仍能读回
+    toast_sync_all();
+    toast_shutdown();
+    check_round_trip(buffer, len, &tuple);
+
+    free(compressible);
+    free(incompressible);
+    printf("toast compression round-trip tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/toast.tbl", dir);
+    snprintf(toast_path, sizeof(toast_path), "%s%s", rel_path, TOAST_FILE_SUFFIX);
+
+    smgr_init(16, false, IO_METHOD_SYNC);
+    assert(smgr_open(TEST_REL, rel_path));
+
+    test_small_tuple_inline();
+    test_compress_and_external();
+
+    toast_shutdown();
+    smgr_shutdown();
+    remove(toast_path);
+    remove(rel_path);
+    rmdir(dir);
+    printf("All toast tests passed!\n");
+    return 0;
+}
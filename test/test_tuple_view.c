@@ -0,0 +1,309 @@
+#include "minidb.h"
+#include "page.h"
+#include "memctx.h"
+#include "tuple.h"
+#include "txmgr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_REL 2004
+
+static TableMeta meta;
+
+// 各类型各一列：id INT4, price FLOAT, name TEXT, flag BOOL, day DATE, note TEXT
+static void init_meta(void) {
+    memset(&meta, 0, sizeof(meta));
+    meta.oid = TEST_REL;
+    strcpy(meta.name, "view");
+    const char* names[] = { "id", "price", "name", "flag", "day", "note" };
+    DataType types[] = { INT4_TYPE, FLOAT_TYPE, TEXT_TYPE, BOOL_TYPE, DATE_TYPE, TEXT_TYPE };
+    meta.col_count = 6;
+    for (int i = 0; i < meta.col_count; i++) {
+        strcpy(meta.cols[i].name, names[i]);
+        meta.cols[i].type = types[i];
+    }
+}
+
+static void make_tuple(Tuple* tuple, Column* cols, int id, const char* name, const char* note) {
+    memset(tuple, 0, sizeof(*tuple));
+    tuple->oid = id;
+    tuple->xmin = 5;
+    tuple->xmax = 0;
+    tuple->ctid.page_id = 3;
+    tuple->ctid.slot = 7;
+    tuple->infomask = TUPLE_HEAP_ONLY;
+    tuple->col_count = 6;
+    tuple->columns = cols;
+    cols[0].type = INT4_TYPE;
+    cols[0].value.int_val = id;
+    cols[1].type = FLOAT_TYPE;
+    cols[1].value.float_val = 2.5f;
+    cols[2].type = TEXT_TYPE;
+    cols[2].value.str_val = (char*)name;
+    cols[3].type = BOOL_TYPE;
+    cols[3].value.bool_val = true;
+    cols[4].type = DATE_TYPE;
+    cols[4].value.int_val = 20240101;
+    cols[5].type = TEXT_TYPE;
+    cols[5].value.str_val = (char*)note;
+}
+
+void test_view_accessors() {
+    Tuple tuple;
+    Column cols[6];
+    make_tuple(&tuple, cols, 42, "alice", "");
+    uint8_t buffer[MAX_TUPLE_SIZE];
+    size_t len = serialize_tuple(&tuple, buffer);
+
+    TupleView view;
+    assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+    assert(view.oid == 42 && view.xmin == 5 && view.xmax == 0);
+    assert(view.ctid.page_id == 3 && view.ctid.slot == 7);
+    assert(view.infomask == TUPLE_HEAP_ONLY);
+    assert(view.col_count == 6);
+
+    int32_t i;
+    float f;
+    bool b;
+    assert(tuple_view_get_int(&view, 0, &i) && i == 42);
+    assert(tuple_view_get_float(&view, 1, &f) && f == 2.5f);
+    assert(tuple_view_get_bool(&view, 3, &b) && b);
+    assert(tuple_view_get_int(&view, 4, &i) && i == 20240101);
+
+    // TEXT 直接指向序列化数据，不复制
+    size_t text_len;
+    const char* text = tuple_view_get_text(&view, 2, &text_len);
+    assert(text_len == 5 && memcmp(text, "alice", 5) == 0);
+    assert((const uint8_t*)text > buffer && (const uint8_t*)text < buffer + len);
+    text = tuple_view_get_text(&view, 5, &text_len);
+    assert(text && text_len == 0);
+    char* copy = tuple_view_copy_text(&view, 2);
+    assert(strcmp(copy, "alice") == 0);
+    pfree(copy);
+
+    // 类型不符、列号越界
+    assert(!tuple_view_get_int(&view, 1, &i));
+    assert(!tuple_view_get_float(&view, 0, &f));
+    assert(!tuple_view_get_text(&view, 0, &text_len));
+    assert(!tuple_view_get_int(&view, -1, &i));
+    assert(!tuple_view_get_int(&view, 6, &i));
+
+    // 数据不完整
+    assert(!tuple_view_init(&view, buffer, TUPLE_HEADER_SIZE - 1, TEST_REL));
+    assert(tuple_view_init(&view, buffer, (uint16_t)(len - 8), TEST_REL));
+    assert(tuple_view_get_int(&view, 0, &i) && i == 42);
+    assert(!tuple_view_get_int(&view, 4, &i));
+    printf("tuple view accessor tests passed!\n");
+}
+
+void test_view_materialize() {
+    Tuple tuple;
+    Column cols[6];
+    make_tuple(&tuple, cols, 7, "bob", "some note");
+    uint8_t buffer[MAX_TUPLE_SIZE];
+    size_t len = serialize_tuple(&tuple, buffer);
+
+    TupleView view;
+    assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+    Tuple* t = tuple_view_materialize(&view, NULL);
+    assert(t != NULL);
+    assert(tuple_equals(t, &tuple));
+    assert(t->xmin == 5 && t->ctid.slot == 7 && t->infomask == TUPLE_HEAP_ONLY);
+    assert(strcmp(t->columns[5].value.str_val, "some note") == 0);
+    free_tuple(t);
+    printf("tuple view materialize tests passed!\n");
+}
+
+void test_view_condition() {
+    Tuple tuple;
+    Column cols[6];
+    make_tuple(&tuple, cols, 9, "carol", "x");
+    uint8_t buffer[MAX_TUPLE_SIZE];
+    size_t len = serialize_tuple(&tuple, buffer);
+    TupleView view;
+    assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+
+    Condition cond = { .op = "=" };
+    strcpy(cond.column, "id");
+    strcpy(cond.value, "9");
+    assert(tuple_view_eval_condition(&cond, &view, &meta));
+    strcpy(cond.value, "10");
+    assert(!tuple_view_eval_condition(&cond, &view, &meta));
+
+    strcpy(cond.column, "name");
+    strcpy(cond.value, "carol");
+    assert(tuple_view_eval_condition(&cond, &view, &meta));
+    strcpy(cond.value, "caro");
+    assert(!tuple_view_eval_condition(&cond, &view, &meta));
+    strcpy(cond.value, "carols");
+    assert(!tuple_view_eval_condition(&cond, &view, &meta));
+
+    strcpy(cond.column, "note");
+    strcpy(cond.value, "x");
+    assert(tuple_view_eval_condition(&cond, &view, &meta));
+    strcpy(cond.column, "missing");
+    assert(!tuple_view_eval_condition(&cond, &view, &meta));
+    printf("tuple view condition tests passed!\n");
+}
+
+void test_view_visibility() {
+    TransactionManager txmgr;
+    txmgr_init(&txmgr);
+    SET_COMMITTED(5, &txmgr);
+
+    Tuple tuple;
+    Column cols[6];
+    make_tuple(&tuple, cols, 1, "dave", "");
+    uint8_t buffer[MAX_TUPLE_SIZE];
+    TupleView view;
+
+    // 与 is_tuple_visible 的结果一致
+    uint32_t xmaxes[] = { 0, 5, 6 };
+    uint32_t readers[] = { 4, 6, 8 };
+    for (int i = 0; i < 3; i++) {
+        tuple.xmax = xmaxes[i];
+        size_t len = serialize_tuple(&tuple, buffer);
+        assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+        for (int j = 0; j < 3; j++) {
+            assert(tuple_view_is_visible(&txmgr, &view, readers[j]) ==
+                   is_tuple_visible(&txmgr, &tuple, readers[j]));
+        }
+    }
+    tuple.xmax = 0;
+    size_t len = serialize_tuple(&tuple, buffer);
+    assert(tuple_view_init(&view, buffer, (uint16_t)len, TEST_REL));
+    assert(tuple_view_is_visible(&txmgr, &view, 6));
+    printf("tuple view visibility tests passed!\n");
+}
+
+void test_page_view() {
+    Page page;
+    page_init(&page, 0);
+    Tuple tuple;
+    Column cols[6];
+    make_tuple(&tuple, cols, 11, "erin", "on page");
+    uint16_t slot;
+    assert(page_insert_tuple(&page, &tuple, &slot));
+
+    // 视图指向页面中的数据
+    TupleView view;
+    assert(page_get_tuple_view(&page, slot, &meta, &view));
+    assert(view.oid == 11 && view.rel_oid == TEST_REL);
+    assert(view.data > (const uint8_t*)&page && view.data < (const uint8_t*)&page + sizeof(page));
+    size_t text_len;
+    const char* text = tuple_view_get_text(&view, 5, &text_len);
+    assert(text_len == 7 && memcmp(text, "on page", 7) == 0);
+
+    // 删除的槽位、越界槽位没有视图
+    assert(!page_get_tuple_view(&page, slot + 1, &meta, &view));
+    assert(page_delete_tuple(&page, slot));
+    assert(!page_get_tuple_view(&page, slot, &meta, &view));
+    printf("tuple view page tests passed!\n");
+}
+
+void test_attcache() {
+    tuple_init_attcache(&meta);
+    // 前导定长列和第一个变长列有固定偏移，之后的列没有
+    assert(meta.attcacheoff[0] == TUPLE_HEADER_SIZE);
+    assert(meta.attcacheoff[1] == TUPLE_HEADER_SIZE + 1 + sizeof(int32_t));
+    assert(meta.attcacheoff[2] == TUPLE_HEADER_SIZE + 2 + sizeof(int32_t) + sizeof(float));
+    for (int i = 3; i < MAX_COLS; i++) assert(meta.attcacheoff[i] == 0);
+
+    TableMeta text_first = meta;
+    text_first.cols[0].type = TEXT_TYPE;
+    tuple_init_attcache(&text_first);
+    assert(text_first.attcacheoff[0] == TUPLE_HEADER_SIZE);
+    assert(text_first.attcacheoff[1] == 0);
+
+    // 用缓存偏移读出的值与逐列计算的相同，变长列之后从最后一个缓存偏移接着走
+    char name[300];
+    memset(name, 'n', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    Page page;
+    page_init(&page, 0);
+    Tuple tuple;
+    Column cols[6];
+    make_tuple(&tuple, cols, 77, name, "tail");
+    uint16_t slot;
+    assert(page_insert_tuple(&page, &tuple, &slot));
+    TupleView cached, plain;
+    assert(page_get_tuple_view(&page, slot, &meta, &cached));
+    assert(cached.attcacheoff == meta.attcacheoff);
+    assert(page_get_tuple_view(&page, slot, NULL, &plain));
+    assert(plain.attcacheoff == NULL);
+
+    int32_t a, b;
+    float f;
+    bool flag;
+    size_t la, lb;
+    assert(tuple_view_get_int(&cached, 0, &a) && a == 77);
+    assert(tuple_view_get_float(&cached, 1, &f) && f == 2.5f);
+    assert(!tuple_view_get_int(&cached, 1, &a));
+    assert(tuple_view_get_text(&cached, 2, &la) == tuple_view_get_text(&plain, 2, &lb));
+    assert(la == lb && la == strlen(name));
+    assert(tuple_view_get_bool(&cached, 3, &flag) && flag);
+    assert(tuple_view_get_int(&cached, 4, &a) && tuple_view_get_int(&plain, 4, &b) && a == b);
+    assert(tuple_view_get_text(&cached, 5, &la) == tuple_view_get_text(&plain, 5, &lb));
+    assert(la == 4);
+
+    Condition cond = { .op = "=" };
+    strcpy(cond.column, "note");
+    strcpy(cond.value, "tail");
+    assert(tuple_view_eval_condition(&cond, &cached, &meta));
+
+    // 列数与表定义不同（如加列之前写入的元组）时不用缓存偏移
+    TableMeta wider = meta;
+    wider.col_count = 7;
+    wider.cols[6].type = INT4_TYPE;
+    tuple_init_attcache(&wider);
+    assert(page_get_tuple_view(&page, slot, &wider, &cached));
+    assert(cached.attcacheoff == NULL);
+    printf("tuple view attcacheoff tests passed!\n");
+}
+
+// 建表和重新加载表元数据时都算出缓存偏移
+void test_catalog_attcache() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    assert(chdir(dir) == 0);  // WAL 文件写在当前目录下
+    MiniDBConfig config;
+    config_set_defaults(&config);
+    config.autoprewarm = false;
+    MiniDB db;
+    init_db_with_config(&db, dir, &config);
+
+    Session session = { .db = &db, .current_xid = INVALID_XID };
+    session_begin_transaction(&session);
+    assert(db_create_table(&db, "attcache", meta.cols, meta.col_count, session) >= 0);
+    session_commit_transaction(&db, &session);
+    TableMeta* t = &db.catalog.tables[find_table(&db.catalog, "attcache")];
+    assert(memcmp(t->attcacheoff, meta.attcacheoff, sizeof(meta.attcacheoff)) == 0);
+
+    close_db(&db);
+    init_db_with_config(&db, dir, &config);
+    t = &db.catalog.tables[find_table(&db.catalog, "attcache")];
+    assert(memcmp(t->attcacheoff, meta.attcacheoff, sizeof(meta.attcacheoff)) == 0);
+    close_db(&db);
+
+    assert(chdir("/") == 0);
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    assert(system(cmd) == 0);
+    printf("catalog attcacheoff tests passed!\n");
+}
+
+int main() {
+    init_meta();
+    test_view_accessors();
+    test_view_materialize();
+    test_view_condition();
+    test_view_visibility();
+    test_page_view();
+    test_attcache();
+    test_catalog_attcache();
+    printf("All tuple view tests passed!\n");
+    return 0;
+}
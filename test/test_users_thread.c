@@ -87,5 +87,6 @@ int main() {
     pthread_join(tid_update, NULL);
     pthread_join(tid2_update, NULL);
 
+    close_db(&db);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "server/parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+void test_parse_vacuum() {
+    VacuumStmt stmt;
+
+    assert(parse_vacuum("VACUUM", &stmt));
+    assert(!stmt.has_table);
+    assert(parse_vacuum("vacuum;", &stmt));
+    assert(!stmt.has_table);
+
+    assert(parse_vacuum("VACUUM users", &stmt));
+    assert(stmt.has_table);
+    assert(strcmp(stmt.table_name, "users") == 0);
+    assert(parse_vacuum("  Vacuum   orders ;  ", &stmt));
+    assert(stmt.has_table);
+    assert(strcmp(stmt.table_name, "orders") == 0);
+    assert(parse_vacuum("vacuum t;", &stmt));
+    assert(strcmp(stmt.table_name, "t") == 0);
+    printf("parse_vacuum accept tests passed!\n");
+}
+
+void test_parse_vacuum_rejects() {
+    VacuumStmt stmt;
+
+    assert(!parse_vacuum("VACUUMusers", &stmt));
+    assert(!parse_vacuum("VACUUM users extra", &stmt));
+    assert(!parse_vacuum("VACUUM users; select", &stmt));
+    assert(!parse_vacuum("SELECT * FROM users", &stmt));
+    assert(!parse_vacuum("", &stmt));
+
+    // 表名超长
+    char sql[MAX_TABLE_NAME + 16];
+    strcpy(sql, "VACUUM ");
+    memset(sql + 7, 'x', MAX_TABLE_NAME);
+    sql[7 + MAX_TABLE_NAME] = '\0';
+    assert(!parse_vacuum(sql, &stmt));
+    sql[7 + MAX_TABLE_NAME - 1] = '\0';
+    assert(parse_vacuum(sql, &stmt));
+    assert(strlen(stmt.table_name) == MAX_TABLE_NAME - 1);
+    printf("parse_vacuum reject tests passed!\n");
+}
+
+int main() {
+    test_parse_vacuum();
+    test_parse_vacuum_rejects();
+    printf("All vacuum parser tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "vm.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_REL 2002
+
+static char rel_path[256];
+
+// 模拟重启：丢弃内存中的映射（不写回），重新从 .vm 文件加载
+static VisibilityMap* restart(void) {
+    vm_shutdown();
+    VisibilityMap* vm = vm_open(TEST_REL, rel_path);
+    assert(vm != NULL);
+    return vm;
+}
+
+void test_set_clear() {
+    VisibilityMap* vm = vm_open(TEST_REL, rel_path);
+    assert(vm != NULL);
+    assert(vm_open(TEST_REL, rel_path) == vm);
+    assert(!visibilitymap_test(vm, 0));
+
+    visibilitymap_set(vm, 3);
+    visibilitymap_set(vm, 700);
+    assert(visibilitymap_test(vm, 3));
+    assert(visibilitymap_test(vm, 700));
+    assert(!visibilitymap_test(vm, 4));
+    assert(!visibilitymap_test(vm, 100000));
+
+    visibilitymap_clear(vm, 3);
+    assert(!visibilitymap_test(vm, 3));
+    visibilitymap_clear(vm, 4);
+    assert(!visibilitymap_test(vm, 4));
+    printf("vm set/clear tests passed!\n");
+}
+
+void test_restart() {
+    // 置位在写回之前不持久化
+    VisibilityMap* vm = restart();
+    assert(!visibilitymap_test(vm, 700));
+
+    visibilitymap_set(vm, 3);
+    visibilitymap_set(vm, 5);
+    visibilitymap_set(vm, 700);
+    vm_sync_all();
+    vm = restart();
+    assert(visibilitymap_test(vm, 3));
+    assert(visibilitymap_test(vm, 5));
+    assert(visibilitymap_test(vm, 700));
+
+    // 清位立即写入文件，不等写回
+    visibilitymap_clear(vm, 3);
+    vm = restart();
+    assert(!visibilitymap_test(vm, 3));
+    assert(visibilitymap_test(vm, 5));
+
+    // 写回改名之后的清位写入新文件
+    visibilitymap_clear(vm, 5);
+    visibilitymap_set(vm, 9);
+    vm_sync_all();
+    visibilitymap_clear(vm, 700);
+    vm = restart();
+    assert(!visibilitymap_test(vm, 5));
+    assert(visibilitymap_test(vm, 9));
+    assert(!visibilitymap_test(vm, 700));
+    printf("vm restart tests passed!\n");
+}
+
+void test_truncate() {
+    VisibilityMap* vm = vm_open(TEST_REL, rel_path);
+    visibilitymap_set(vm, 600);
+    visibilitymap_truncate(vm, 10);
+    assert(visibilitymap_test(vm, 9));
+    assert(!visibilitymap_test(vm, 600));
+    vm_sync_all();
+    vm = restart();
+    assert(visibilitymap_test(vm, 9));
+    assert(!visibilitymap_test(vm, 600));
+    printf("vm truncate tests passed!\n");
+}
+
+int main() {
+    char dir[] = "/tmp/minidb_test_XXXXXX";
+    assert(mkdtemp(dir));
+    snprintf(rel_path, sizeof(rel_path), "%s/vm.tbl", dir);
+
+    test_set_clear();
+    test_restart();
+    test_truncate();
+
+    vm_shutdown();
+    char vm_path[sizeof(rel_path) + sizeof(VM_FILE_SUFFIX)];
+    snprintf(vm_path, sizeof(vm_path), "%s%s", rel_path, VM_FILE_SUFFIX);
+    remove(vm_path);
+    rmdir(dir);
+    printf("All vm tests passed!\n");
+    return 0;
+}